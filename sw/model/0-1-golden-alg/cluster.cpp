@@ -44,18 +44,19 @@ cluster_if::cluster_if(uint32_t start_group, uint32_t n_groups, uint32_t n_cores
   * @param  kernel_dim  Size of the current kernel.
   */
 cluster::cluster(sc_module_name name, uint32_t start_group, uint32_t n_groups, uint32_t n_cores, uint8_t kernel_dim, uint32_t packet_size)
-    : sc_module(name), cluster_if(start_group, n_groups, n_cores, packet_size), _kern_dim(kernel_dim)
+    : sc_module(name), cluster_if(start_group, n_groups, n_cores, packet_size), core_ifs("core_ifs", n_cores), _kern_dim(kernel_dim), _n_kern(1)
 {
 
 }
 
-void cluster::activate(uint32_t command_type, uint32_t r, uint32_t c) {
-    std::cout << "Configured " << command_type << " " << r << " " << c << std::endl;
+void cluster::activate(uint32_t command_type, uint32_t r, uint32_t c, uint32_t n_kern) {
+    LOG_DEBUG(this->name(), "configured for cmd type %d, %dx%d matrix, %d kernels", command_type, r, c, n_kern);
     // allow cluster to tap the bus data
     _enabled = true;
 
     // latch configuration
     _command_type = command_type;
+    _n_kern = n_kern;
 
     // initialize FSM
     if (command_type == MM_CMD_KERN) {
@@ -102,36 +103,41 @@ void cluster::receive_packet(uint64_t addr, uint64_t packet, uint8_t *out_ptr) {
     }
     else if (_command_type == MM_CMD_SUBJ) {
         // iterate through data groups
-        for (int group_i = 0; group_i < _n_groups; group_i++) {
+        for (uint32_t group_i = 0; group_i < _n_groups; group_i++) {
 
-            // iterate through kernel rows (start with last to not overwrite subresults)
+            // the dispatched group is reused by every kernel in the bank
             int core_i = 0;
-            for (int row_i = _kern_dim-1; row_i >= 0; --row_i){
-
-                // load previous sub result to accumulate (only after first row)
-                uint32_t subres = 0;
-                if(row_i != 0) {
-                    subres_mem_ifs[row_i-1]->read(0, subres);
+            for (uint32_t kern_i = 0; kern_i < _n_kern; kern_i++) {
+                uint8_t *kernel = _kernel_mem + (kern_i * _kern_dim * _kern_dim);
+
+                // iterate through kernel rows (start with last to not overwrite subresults)
+                for (int row_i = _kern_dim-1; row_i >= 0; --row_i){
+
+                    // load previous sub result to accumulate (only after first row)
+                    uint32_t subres = 0;
+                    if(row_i != 0) {
+                        subres_mem_ifs[row_i-1]->read(0, subres);
+                    }
+
+                    // send current kernel row and data group to core to calculate
+                    subres = core_ifs[core_i]->calculate_row_result(subres, kernel + (row_i * _kern_dim), _dispatch_data + _start_group + group_i);
+
+                    if (row_i == (_kern_dim - 1)) {
+                        // round and truncate total result
+                        //subres += (1 << 6); // +0.5 in SQ0.7
+                        //subres >>= 7;       // truncate to get 8 integer bits in LSB
+
+                        // output total result
+                        out_ptr[kern_i * CLUSTER_RESULTS_STRIDE + group_i] = (uint8_t)subres; // implicit mask with 0xff
+                    }
+                    else {
+                        // write subresult to internal memory
+                        subres_mem_ifs[row_i]->write(0, subres);
+                    }
+
+                    // move to next core
+                    core_i = (core_i + 1) % _n_cores;
                 }
-
-                // send current kernel row and data group to core to calculate
-                subres = core_ifs[core_i]->calculate_row_result(subres, _kernel_mem + (row_i * _kern_dim), _dispatch_data + _start_group + group_i);
-
-                if (row_i == (_kern_dim - 1)) {
-                    // round and truncate total result
-                    //subres += (1 << 6); // +0.5 in SQ0.7
-                    //subres >>= 7;       // truncate to get 8 integer bits in LSB
-
-                    // output total result
-                    out_ptr[group_i] = (uint8_t)subres; // implicit mask with 0xff
-                }
-                else {
-                    // write subresult to internal memory
-                    subres_mem_ifs[row_i]->write(0, subres);
-                }
-
-                // move to next core
-                core_i = (core_i + 1) % _n_cores;
             }
         }
 
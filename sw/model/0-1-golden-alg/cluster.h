@@ -43,8 +43,8 @@ class cluster : public sc_module, public cluster_if {
 
     public:
 
-        // internal core interfaces
-        sc_port<core_if> core_ifs[MAX_N_CORES_PER_CLUSTER];
+        // internal core interfaces, one per core of the cluster
+        sc_vector<sc_port<core_if>> core_ifs;
 
         // internal memory interface
         sc_port<cluster_memory_if_t> subres_mem_ifs[MAX_KERN_DIM-1];
@@ -53,7 +53,7 @@ class cluster : public sc_module, public cluster_if {
         cluster(sc_module_name name, uint32_t start_group, uint32_t n_groups, uint32_t n_cores, uint8_t kernel_dim, uint32_t packet_size);
 
         /** Once the command header has been received, activate the cluster. */
-        void activate(uint32_t command_type, uint32_t r, uint32_t c);
+        void activate(uint32_t command_type, uint32_t r, uint32_t c, uint32_t n_kern);
 
         /** Disable the kernel after all payload packets received. */
         void disable();
@@ -73,9 +73,10 @@ class cluster : public sc_module, public cluster_if {
         // dispatch data
         uint8_t _dispatch_data[MAX_CLUSTER_INPUT_SIZE];
 
-        // internal kernel storage as registers
-        uint8_t _kernel_mem[KERN_SIZE_ROUNDED];
+        // internal kernel storage as registers, kernels of the bank are back to back
+        uint8_t _kernel_mem[KERN_BANK_SIZE_ROUNDED];
         uint8_t _kern_dim;
+        uint32_t _n_kern;
 
         // per-image configuration
         bool     _enabled;
@@ -1,5 +1,6 @@
 
 #include "system.h"
+#include "conv_engine.h"
 
 #include "systemc.h"
 
@@ -6,18 +6,20 @@
 #include "mat_mult_if.h"
 #include "mat_mult_cmd.h"
 #include "sc_trace.hpp"
+#include "perf_counters.h"
 
 #include "systemc.h"
 #include <iostream>
 #include <string>
 
 int kernel_dim;
-uint8_t memory[MEM_SIZE];
+uint8_t *memory;
 
 sc_tracer sc_tracer::tracer;
+latency_tracker latency_tracker::tracker;
 
 int sc_main(int argc, char* argv[]) {
-    if (!parseCmdLine(argc, argv, memory, &kernel_dim)) {
+    if (!parseCmdLine(argc, argv, &memory, &kernel_dim)) {
         return 1;
     }
 
@@ -31,7 +33,7 @@ int sc_main(int argc, char* argv[]) {
 
     // Design optimization parameters
     uint32_t n_clusters = MAX_N_CLUSTERS; // number of clusters (must be a power of 2)
-    uint32_t n_cores_per_cluster = kernel_dim;
+    uint32_t n_cores_per_cluster = kernel_dim * N_KERN; // one core per kernel row in the filter bank
     uint32_t payload_packet_size = PACKET_BYTES; // total number of bytes (pixels) received per payload packet (might be bigger than 64-bit if buffered)
 
     // Calculated design parameters
@@ -72,17 +74,13 @@ int sc_main(int argc, char* argv[]) {
 
     // dummy components
     cluster *dummy_cluster = new cluster("dummy_cluster", 0, 0, 0, 0, 0);
-    core *dummy_core = new core("dummy_core", 0);
-    for (int i = 0; i < MAX_N_CORES_PER_CLUSTER; i++) {
-        dummy_cluster->core_ifs[i](*dummy_core);
-    }
     cluster_memory *dummy_cluster_mem = new cluster_memory("dummy_cluster_mem", 0);
-    for (int i = 0; i < MAX_N_CORES_PER_CLUSTER-1; i++) {
+    for (int i = 0; i < MAX_KERN_DIM-1; i++) {
         dummy_cluster->subres_mem_ifs[i](*dummy_cluster_mem);
     }
 
     // initialize each cluster
-    int i = 0;
+    uint32_t i = 0;
     for (i = 0; i < n_clusters; i++) {
         // initialize each cluster
         clusters[i] = new cluster(("cluster" + std::to_string(i)).c_str(),
@@ -94,18 +92,14 @@ int sc_main(int argc, char* argv[]) {
                                     );
 
         // initialize each core for each cluster
-        int j = 0;
+        uint32_t j = 0;
         for (; j < n_cores_per_cluster; j++) {
             cores[j + i * n_cores_per_cluster] = new core(("cluster" + std::to_string(i) + "core" + std::to_string(j)).c_str(), kernel_dim);
             clusters[i]->core_ifs[j](*cores[j + i * n_cores_per_cluster]);
         }
-        // garbage cores
-        for (; j < MAX_N_CORES_PER_CLUSTER; j++) {
-            clusters[i]->core_ifs[j](*dummy_core);
-        }
 
         // initialize each memory for each cluster
-        for (j = 0; j < kernel_dim-1; j++) {
+        for (j = 0; j < (uint32_t)(kernel_dim - 1); j++) {
             cluster_mems[j + i * (kernel_dim - 1)] = new cluster_memory(("cluster" + std::to_string(i) + "mem" + std::to_string(j)).c_str(), false);
             clusters[i]->subres_mem_ifs[j](*cluster_mems[j + i * (kernel_dim - 1)]);
         }
@@ -133,8 +127,11 @@ int sc_main(int argc, char* argv[]) {
     sc_time startTime = sc_time_stamp();
     sc_start();
     sc_time stopTime = sc_time_stamp();
+    sc_logger::flush(); // the records of the run come before the reports
 
     cout << "Simulated for " << (stopTime - startTime) << endl;
+    latency_tracker::print_report();
+    perf_counters::finish();
 
     // final state
     memoryWrite(argv, memory);
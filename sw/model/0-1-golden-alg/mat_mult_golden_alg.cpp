@@ -7,7 +7,7 @@
 #include <string>
 
 mat_mult_ga::mat_mult_ga(sc_module_name name, uint32_t n_clusters, uint32_t n_cores_per_cluster, uint8_t kern_dim, uint32_t packet_size, uint32_t n_groups_per_cluster)
-    : mat_mult_top(name), _n_clusters(n_clusters), _n_cores_per_cluster(n_cores_per_cluster), _kern_dim(kern_dim), _hf_kern_dim(kern_dim >> 1), _packet_size(packet_size), _n_groups_per_cluster(n_groups_per_cluster)
+    : mat_mult_top(name), _n_clusters(n_clusters), _n_cores_per_cluster(n_cores_per_cluster), _kern_dim(kern_dim), _hf_kern_dim(kern_dim >> 1), _packet_size(packet_size), _n_groups_per_cluster(n_groups_per_cluster), _n_kern(1), _plane_size(0)
 {
 
 }
@@ -17,19 +17,43 @@ mat_mult_ga::mat_mult_ga(sc_module_name name, uint32_t n_clusters, uint32_t n_co
  * latch the status in the acknowledge packet.
  */
 bool mat_mult_ga::receive_packet(uint64_t addr, uint64_t packet) {
+    process_packet(addr, packet);
+
+    wait(1, SC_NS);
+
+    return true;
+}
+
+/**
+ * Receive a burst of packets. The packets are dispatched back to back and
+ * the simulation time of the whole burst is accounted in a single wait.
+ */
+bool mat_mult_ga::receive_packets(uint64_t addr, const uint64_t *packets, uint32_t n) {
+    for (uint32_t i = 0; i < n; ++i) {
+        process_packet(BURST_ADDR(addr, i), packets[i]);
+    }
+
+    if (n) {
+        wait(n, SC_NS);
+    }
+
+    return true;
+}
+
+void mat_mult_ga::process_packet(uint64_t addr, uint64_t packet) {
     //TODO current code assumes that the packets received are immediately distributed to clusters instead of buffered
     //and concatenated with other packets. Might want to add support for this (another optimization parameter).
     //Partially fixed
 
     if (_regs.cmd_type_reg.is_kern) {
         // dispatch kernel values to clusters
-        for (int i = 0; i < _n_clusters; i++) {
+        for (uint32_t i = 0; i < _n_clusters; i++) {
             cluster_ifs[i]->receive_packet(addr, packet, _results + (PACKET_BYTES - _hf_kern_dim) + (i * _n_groups_per_cluster));
         }
     }
     else if (_regs.cmd_type_reg.is_subj){
         // dispatch input image data to clusters
-        for (int i = 0; i < _n_clusters; i++) {
+        for (uint32_t i = 0; i < _n_clusters; i++) {
             cluster_ifs[i]->receive_packet(addr, packet, _results + (PACKET_BYTES - _hf_kern_dim) + (i * _n_groups_per_cluster));
         }
 
@@ -47,9 +71,9 @@ bool mat_mult_ga::receive_packet(uint64_t addr, uint64_t packet) {
         _loaded_el += PACKET_BYTES;
         if (_regs.cmd_type_reg.is_subj) {
             _out_col += PACKET_BYTES;
-            if (_out_col == (uint32_t)GET_CMD_SIZE_SUBJ_COLS(_cur_cmd)) {
+            if (_out_col == (int32_t)GET_CMD_SIZE_SUBJ_COLS(_cur_cmd)) {
                 // if last column, write last complete packet
-                for (int i = 0; i < _n_clusters; i++) {
+                for (uint32_t i = 0; i < _n_clusters; i++) {
                     cluster_ifs[i]->receive_packet(addr, 0, _results + (PACKET_BYTES - _hf_kern_dim) + (i * _n_groups_per_cluster));
                 }
                 write_results_buffer();
@@ -66,7 +90,7 @@ bool mat_mult_ga::receive_packet(uint64_t addr, uint64_t packet) {
             _loaded_el = 0;
             _expected_el = 0;
             _regs.status_reg.ready = true;
-            for (int i = 0; i < _n_clusters; ++i) {
+            for (uint32_t i = 0; i < _n_clusters; ++i) {
                 cluster_ifs[i]->disable();
             }
 
@@ -102,31 +126,28 @@ bool mat_mult_ga::receive_packet(uint64_t addr, uint64_t packet) {
     // activate clusters if necessary
     if (_cur_state != WAIT_DATA && _next_state == WAIT_DATA) {
         cout << "ACTIVATE CLUSTERS" << endl;
-        for (int i = 0; i < _n_clusters; ++i) {
+        for (uint32_t i = 0; i < _n_clusters; ++i) {
             if (_regs.cmd_type_reg.is_kern) {
-                cluster_ifs[i]->activate(GET_CMD_TYPE(_cur_cmd), GET_CMD_SIZE_ROWS(_cur_cmd), GET_CMD_SIZE_COLS(_cur_cmd));
+                cluster_ifs[i]->activate(GET_CMD_TYPE(_cur_cmd), GET_CMD_SIZE_ROWS(_cur_cmd), GET_CMD_SIZE_COLS(_cur_cmd), _n_kern);
             }
             else if (_regs.cmd_type_reg.is_subj) {
-                cluster_ifs[i]->activate(GET_CMD_TYPE(_cur_cmd), GET_CMD_SIZE_SUBJ_ROWS(_cur_cmd), GET_CMD_SIZE_SUBJ_COLS(_cur_cmd));
+                cluster_ifs[i]->activate(GET_CMD_TYPE(_cur_cmd), GET_CMD_SIZE_SUBJ_ROWS(_cur_cmd), GET_CMD_SIZE_SUBJ_COLS(_cur_cmd), _n_kern);
             }
         }
         _loaded_el = 0;
         _out_row = -_hf_kern_dim;
         _out_col = 0;
         _out_addr = (uint64_t)GET_CMD_OUT_ADDR(_cur_cmd);
+        _plane_size = (uint64_t)(GET_CMD_SIZE_SUBJ_ROWS(_cur_cmd) - _hf_kern_dim) * GET_CMD_SIZE_SUBJ_COLS(_cur_cmd);
     }
 
     // advance to next state
     advance_state();
-
-    wait(1, SC_NS);
-
-    return true;
 }
 
 void mat_mult_ga::protected_reset() {
     // reset internal clusters
-    for (int i = 0; i < _n_clusters; ++i) {
+    for (uint32_t i = 0; i < _n_clusters; ++i) {
         cluster_ifs[i]->reset();
     }
 
@@ -143,16 +164,35 @@ void mat_mult_ga::protected_reset() {
     mat_mult_top::protected_reset();
 }
 
+bool mat_mult_ga::configure_kernel(uint8_t kern_dim, uint8_t n_kern) {
+    if (n_kern > 1 && n_kern * kern_dim > _n_cores_per_cluster) {
+        LOG_ERROR(this->name(), "%d kernels need %d cores per cluster", n_kern, n_kern * kern_dim);
+        return false;
+    }
+
+    _n_kern = n_kern;
+    return true;
+}
+
 void mat_mult_ga::write_results_buffer() {
-    // get data from buffer
-    _out_data = *(uint64_t*)_results;
+    bool do_write = _out_col >= (int32_t)PACKET_BYTES && _out_row >= 0;
 
-    // write data with mask
-    if (_out_col >= PACKET_BYTES && _out_row >= 0) {
-        mem_if->write(_out_addr, _out_data);
-        _out_addr += PACKET_BYTES;
+    for (int i = 0; i < _n_kern; i++) {
+        uint8_t *results = _results + i * CLUSTER_RESULTS_STRIDE;
+
+        // get data from buffer
+        _out_data = *(uint64_t*)results;
+
+        // write data with mask, to the output matrix of the kernel
+        if (do_write) {
+            write_mem(_out_addr + i * _plane_size, &_out_data, 1);
+        }
+
+        // shift
+        memcpy(results, results + PACKET_BYTES, PACKET_BYTES);
     }
 
-    // shift
-    memcpy(_results, _results + PACKET_BYTES, PACKET_BYTES);
+    if (do_write) {
+        _out_addr += PACKET_BYTES;
+    }
 }
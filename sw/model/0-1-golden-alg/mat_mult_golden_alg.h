@@ -52,6 +52,10 @@ class mat_mult_ga : public mat_mult_top {
         uint32_t _expected_el;
         uint32_t _loaded_el;
 
+        // filter bank
+        uint8_t _n_kern;
+        uint64_t _plane_size; // distance between the output matrices of consecutive kernels
+
         // counters
         uint64_t _out_addr;
         int32_t _out_row;
@@ -62,10 +66,13 @@ class mat_mult_ga : public mat_mult_top {
 
         // internal clusters
         uint32_t _n_clusters = 0;
-        uint8_t _results[PACKET_BYTES * 2]; // store the output pixels from the current batch (has a size of _packet_size)
+        uint8_t _results[MAX_KERN_BANK * CLUSTER_RESULTS_STRIDE]; // store the output pixels from the current batch for each kernel (has a size of _packet_size)
 
         bool receive_packet(uint64_t addr, uint64_t packet);
+        bool receive_packets(uint64_t addr, const uint64_t *packets, uint32_t n);
+        void process_packet(uint64_t addr, uint64_t packet);
         void protected_reset();
+        bool configure_kernel(uint8_t kern_dim, uint8_t n_kern);
         void write_results_buffer();
 
 };
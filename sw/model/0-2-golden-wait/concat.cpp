@@ -1,4 +1,5 @@
 #include "concat.h"
+#include "conv_engine.h"
 
 
 concat::concat(sc_module_name name, uint64_t* reg_out_ptr):sc_module(name)
@@ -12,7 +13,7 @@ void concat::concatenate() {
     _concatenateReg &= ~(((uint64_t)0xff) << (_concat_counter << 3));
     
     //round by adding .5 and truncate
-    _concatenateReg |= ((((uint64_t)(inputReg+(1<<6)) >>7) & 0xff) << (_concat_counter << 3));
+    _concatenateReg |= ((uint64_t)conv_round(inputReg) << (_concat_counter << 3));
 
     if(_concat_counter >= PACKET_BYTES-1) {
         //write reg to memory bus
@@ -8,15 +8,17 @@
 #include <iostream>
 #include <string>
 #include "sc_trace.hpp"
+#include "perf_counters.h"
 
 sc_tracer sc_tracer::tracer;
+latency_tracker latency_tracker::tracker;
 
 int kernel_size;
 int hf_kernel_size;
-uint8_t memory[MEM_SIZE];
+uint8_t *memory;
 
 int sc_main(int argc, char* argv[]) {
-    if (!parseCmdLine(argc, argv, memory, &kernel_size)) {
+    if (!parseCmdLine(argc, argv, &memory, &kernel_size)) {
         return 1;
     }
     
@@ -48,8 +50,11 @@ int sc_main(int argc, char* argv[]) {
     sc_time startTime = sc_time_stamp();
     sc_start();
     sc_time stopTime = sc_time_stamp();
+    sc_logger::flush(); // the records of the run come before the reports
 
     cout << "Simulated for " << (stopTime - startTime) << endl;
+    latency_tracker::print_report();
+    perf_counters::finish();
 
     // final state
     memoryWrite(argv, memory);
@@ -19,6 +19,30 @@ mat_mult_wait::mat_mult_wait(sc_module_name name)
  * latch the status in the acknowledge packet.
  */
 bool mat_mult_wait::receive_packet(uint64_t addr, uint64_t packet) {
+    process_packet(addr, packet);
+
+    wait(1, SC_NS);
+
+    return true;
+}
+
+/**
+ * Receive a burst of packets. The packets are streamed through the MMU back
+ * to back and the simulation time of the whole burst is accounted in a single wait.
+ */
+bool mat_mult_wait::receive_packets(uint64_t addr, const uint64_t *packets, uint32_t n) {
+    for (uint32_t i = 0; i < n; ++i) {
+        process_packet(BURST_ADDR(addr, i), packets[i]);
+    }
+
+    if (n) {
+        wait(n, SC_NS);
+    }
+
+    return true;
+}
+
+void mat_mult_wait::process_packet(uint64_t addr, uint64_t packet) {
     // address check
     if ((addr & ADDR_MASK) >= (OFFSET_PAYLOAD)) {
         if (_cur_state ==  WAIT_DATA){
@@ -34,7 +58,7 @@ bool mat_mult_wait::receive_packet(uint64_t addr, uint64_t packet) {
                 //if check address to start writing outputs
                 if(_loaded_el > (_kernel_size*(1+_row_length>>1)-1)){
                     uint64_t out_addr = (uint64_t)GET_CMD_OUT_ADDR(_cur_cmd);
-                    mem_if->write((((uint64_t)GET_CMD_OUT_ADDR(_cur_cmd))) + _out_addr, _out_reg);
+                    write_mem((((uint64_t)GET_CMD_OUT_ADDR(_cur_cmd))) + _out_addr, &_out_reg, 1);
                     _out_addr += 8;
                 }
 
@@ -44,7 +68,7 @@ bool mat_mult_wait::receive_packet(uint64_t addr, uint64_t packet) {
                         sendBytes(addr, 0);
                         computeBytes();
                         uint64_t out_addr = (uint64_t)GET_CMD_OUT_ADDR(_cur_cmd);
-                        mem_if->write((((uint64_t)GET_CMD_OUT_ADDR(_cur_cmd))) + _out_addr, _out_reg);
+                        write_mem((((uint64_t)GET_CMD_OUT_ADDR(_cur_cmd))) + _out_addr, &_out_reg, 1);
                         _out_addr += 8;
                    }
                 }
@@ -77,8 +101,12 @@ bool mat_mult_wait::receive_packet(uint64_t addr, uint64_t packet) {
                 _mmu->setKernelSize(_kernel_size);
             }
 
-            if (GET_CMD_TYPE(_cur_cmd) == MM_CMD_SUBJ)
+            if (GET_CMD_TYPE(_cur_cmd) == MM_CMD_SUBJ) {
+                // new frame, keep the kernel
                 _row_length = cols;
+                _out_addr = 0;
+                _mmu->startSubject();
+            }
         }
     }
 
@@ -96,10 +124,6 @@ bool mat_mult_wait::receive_packet(uint64_t addr, uint64_t packet) {
 
     // advance to next state
     advance_state();
-
-    wait(1, SC_NS);
-
-    return true;
 }
 
 
@@ -111,14 +135,14 @@ void mat_mult_wait::protected_reset() {
 
 void mat_mult_wait::sendBytes(uint64_t addr, uint64_t packet){
 
-    for (int i = 0; i < PACKET_BYTES; ++i) {
+    for (uint32_t i = 0; i < PACKET_BYTES; ++i) {
         _mmu->store((uint8_t)((packet>>i*8)&0xFF));
     }
 }
 
 void mat_mult_wait::computeBytes(){
 
-    for (int i = 0; i < PACKET_BYTES; ++i) {
+    for (uint32_t i = 0; i < PACKET_BYTES; ++i) {
         _mmu->compute_output();
         _concat->concatenate();
     }
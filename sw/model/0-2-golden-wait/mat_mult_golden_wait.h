@@ -32,6 +32,8 @@ class mat_mult_wait: public mat_mult {
 
 
         bool receive_packet(uint64_t addr, uint64_t packet);
+        bool receive_packets(uint64_t addr, const uint64_t *packets, uint32_t n);
+        void process_packet(uint64_t addr, uint64_t packet);
         void protected_reset();
         void sendBytes(uint64_t addr, uint64_t packet);
         void computeBytes(); 
@@ -11,12 +11,12 @@ mmu::mmu(sc_module_name name, uint32_t* outptr, uint32_t n_cores, uint32_t row_l
 
     _cur_state = LOAD_KERN;
 
-    for (int i = 0; i < _n_cores; ++i) {
+    for (uint32_t i = 0; i < _n_cores; ++i) {
         // initialize each core
         _cores[i] = new core(("core" + std::to_string(i)).c_str());
     }
 
-    for (int i = 0; i < _n_cores-1; ++i) {
+    for (uint32_t i = 0; i < _n_cores-1; ++i) {
         // connect each core
         _cores[i]->forward = &(_cores[i+1]->addInput);
     }
@@ -58,8 +58,8 @@ void mmu::compute_output() {
 
     //todo deal wityh beginning and end
     uint32_t k=0;
-    for(int j = 0; j < _kernel_size; j++) {
-        for(int i = 0; i < _kernel_size; i++) {
+    for(uint32_t j = 0; j < _kernel_size; j++) {
+        for(uint32_t i = 0; i < _kernel_size; i++) {
 
             int32_t idx = _compute_row_index_counter + i - (_kernel_size>>1);
             int32_t idy = _compute_col_index_counter + j - (_kernel_size>>1);
@@ -69,12 +69,12 @@ void mmu::compute_output() {
                 idy+=_kernel_size;
             }
             //modulo operation
-            if(idy>=_kernel_size){
+            if(idy>=(int32_t)_kernel_size){
                 idy-=_kernel_size;
             }
 
             uint8_t sVal = 0;
-            if(idx >= 0 && idx < _row_length && (_col_index_counter-j >= 0) && (_col_index_counter+j <_col_length)){
+            if(idx >= 0 && idx < (int32_t)_row_length && (_col_index_counter-j >= 0) && (_col_index_counter+j <_col_length)){
                 sVal = _lsram->load(ID(idx, idy));
             }
 
@@ -101,21 +101,26 @@ void mmu::compute_output() {
 
 void mmu::protected_reset() {
 
-    for (int i = 0; i < _n_cores; ++i) {
+    for (uint32_t i = 0; i < _n_cores; ++i) {
         _cores[i]->reset();
     }
 
     _core_load_counter=0;
+    startSubject();
+
+    _cur_state = LOAD_KERN;
+    
+}
+
+void mmu::startSubject() {
+    // the kernel stays loaded in the cores
     _store_counter=0;
     _compute_row_index_counter=0;
     _compute_col_index_counter=0;
     _col_index_counter=0;
     _wait = 1; 
 
-    _cur_state = LOAD_KERN;
-
     _lsram->reset();
-    
 }
 
 
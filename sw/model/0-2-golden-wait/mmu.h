@@ -26,6 +26,7 @@ class mmu : public sc_module {
         void store(uint8_t nextVal);
         void compute_output();
         void protected_reset();
+        void startSubject();
         void setProcessingState();        
         void setKernelSize(uint32_t kernel_size);
 
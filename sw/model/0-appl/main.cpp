@@ -11,12 +11,20 @@
 
 int kernel_dim;
 int hf_kernel_dim;
-uint8_t memory[MEM_SIZE];
+uint8_t *memory;
 
 sc_tracer sc_tracer::tracer;
+latency_tracker latency_tracker::tracker;
 
 int sc_main(int argc, char* argv[]) {
-    if (!parseCmdLine(argc, argv, memory, &kernel_dim)) {
+    if (!parseCmdLine(argc, argv, &memory, &kernel_dim)) {
+        return 1;
+    }
+
+    // computation threads, or rows streamed as they are received
+    int n_threads = getOptionInt("threads", 1);
+    bool stream = getOptionInt("stream", 0) != 0;
+    if (!optionsValid()) {
         return 1;
     }
 
@@ -33,7 +41,7 @@ int sc_main(int argc, char* argv[]) {
     simple_memory_mod<uint64_t> *mem = new simple_memory_mod<uint64_t>("mem", memory, MEM_SIZE);
 
     // matrix multiplier
-    mat_mult *matrix_multiplier = new mat_mult("matrix_multiplier");
+    mat_mult *matrix_multiplier = new mat_mult("matrix_multiplier", n_threads, stream);
     matrix_multiplier->mem_if(*mem);
 
     // command issuer (CPU)
@@ -47,8 +55,11 @@ int sc_main(int argc, char* argv[]) {
     sc_time startTime = sc_time_stamp();
     sc_start();
     sc_time stopTime = sc_time_stamp();
+    sc_logger::flush(); // the records of the run come before the reports
 
     cout << "Simulated for " << (stopTime - startTime) << endl;
+    latency_tracker::print_report();
+    perf_counters::finish();
 
     // final state
     memoryWrite(argv, memory);
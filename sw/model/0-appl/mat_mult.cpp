@@ -3,11 +3,46 @@
 #include "system.h"
 #include "systemc.h"
 #include <stdio.h>
+#include <string.h>
+#include <new>
 
-mat_mult::mat_mult(sc_module_name name)
-    : mat_mult_top(name), _loaded_el(0), _expected_el(0)
+// minimum number of rows in a band
+#define MIN_BAND_ROWS 8
+
+// alignment of the subject and output memories
+#define MEM_ALIGN std::align_val_t(64)
+
+mat_mult::mat_mult(sc_module_name name, uint32_t n_threads, bool stream)
+    : mat_mult_top(name), _loaded_el(0), _expected_el(0), _n_kern(1), subj_mem(nullptr), out_mem(nullptr), _subj_capacity(0), _out_capacity(0),
+      _isa(conv_detect_isa()), _conv_fn(nullptr), _stream(stream), _stream_rows_in(0), _stream_rows_out(0)
 {
+    _pool = new thread_pool(n_threads);
+    if (_stream) {
+        LOG_INFO(this->name(), "using %s convolution engine, streaming rows", conv_isa_name(_isa));
+    }
+    else {
+        LOG_INFO(this->name(), "using %s convolution engine on %d threads", conv_isa_name(_isa), _pool->size());
+    }
+}
 
+mat_mult::~mat_mult() {
+    delete _pool;
+    ::operator delete[](subj_mem, MEM_ALIGN);
+    ::operator delete[](out_mem, MEM_ALIGN);
+}
+
+void mat_mult::reserve_memories(uint64_t subj_el, uint64_t out_el) {
+    if (subj_el > _subj_capacity) {
+        ::operator delete[](subj_mem, MEM_ALIGN);
+        subj_mem = new (MEM_ALIGN) uint8_t[subj_el];
+        _subj_capacity = subj_el;
+    }
+
+    if (out_el > _out_capacity) {
+        ::operator delete[](out_mem, MEM_ALIGN);
+        out_mem = new (MEM_ALIGN) uint8_t[out_el];
+        _out_capacity = out_el;
+    }
 }
 
 /**
@@ -15,12 +50,17 @@ mat_mult::mat_mult(sc_module_name name)
  * latch the status in the acknowledge packet.
  */
 bool mat_mult::receive_packet(uint64_t addr, uint64_t packet) {
+    // payload data
+    if (_cur_state == WAIT_DATA) {
+        receive_payload(&packet, 1);
+        return true;
+    }
+
     // write data in packet to destination
     *_cur_ptr = packet;
 
     // preprocessing
-    switch (_cur_state) {
-    case WAIT_CMD_SIZE:
+    if (_cur_state == WAIT_CMD_SIZE) {
         // calculate expected elements
         if (_regs.cmd_type_reg.is_kern) {
             _expected_el = (uint32_t)(GET_CMD_SIZE_NELS(_cur_cmd));
@@ -31,33 +71,8 @@ bool mat_mult::receive_packet(uint64_t addr, uint64_t packet) {
             _expected_el = (uint32_t)(GET_CMD_SIZE_SUBJ_NELS(_cur_cmd));
         }
         
-        LOGF("[%s] Expected elements %d", this->name(), _expected_el);
-        break;
-
-    case WAIT_DATA:
-        _regs.status_reg.ready = false;
-        _loaded_el += sizeof(uint64_t);
-        
-        // complete payload reception
-        if (_loaded_el >= _expected_el) {
-            LOGF("Loaded %d/%d", _loaded_el, _expected_el);
-            // start calculating when all elements loaded
-            if (_regs.cmd_type_reg.is_subj) {
-                calculate();
-            }
-            _loaded_el = 0;
-            _expected_el = 0;
-
-            _regs.status_reg.ready = true;
-            
-            // issue acknowledge packet
-            write_ack();
-        }
-        break;
-
-    default:
-        break;
-    };
+        LOG_DEBUG(this->name(), "Expected elements %d", _expected_el);
+    }
 
     // decoding FSM
     calculate_next_state();
@@ -68,12 +83,20 @@ bool mat_mult::receive_packet(uint64_t addr, uint64_t packet) {
         // reset for new command
         _cur_ptr = (uint64_t*)&_cur_cmd.s_key;
     }
-    else if (_cur_state != WAIT_DATA && _next_state == WAIT_DATA) {
+    else if (_next_state == WAIT_DATA) {
         // point to internal memory
         if (_regs.cmd_type_reg.is_kern) {
             _cur_ptr = (uint64_t*)kern_mem;
         }
+        else if (_regs.cmd_type_reg.is_subj && streaming()) {
+            uint32_t cols = GET_CMD_SIZE_SUBJ_COLS(_cur_cmd);
+            reserve_memories((uint64_t)_kern_dim*cols, (uint64_t)_n_kern*cols);
+            _stream_rows_in = 0;
+            _stream_rows_out = 0;
+            _cur_ptr = (uint64_t*)stream_slot(0);
+        }
         else if (_regs.cmd_type_reg.is_subj) {
+            reserve_memories(_expected_el, (uint64_t)_expected_el*_n_kern);
             _cur_ptr = (uint64_t*)subj_mem;
         }
     }
@@ -84,6 +107,86 @@ bool mat_mult::receive_packet(uint64_t addr, uint64_t packet) {
     return true;
 }
 
+bool mat_mult::receive_packets(uint64_t addr, const uint64_t *packets, uint32_t n) {
+    for (uint32_t i = 0; i < n; ) {
+        if (_cur_state == WAIT_DATA) {
+            // copy as much of the payload as possible at once
+            i += receive_payload(packets + i, n - i);
+        }
+        else {
+            // command header, one packet at a time
+            receive_packet(BURST_ADDR(addr, i), packets[i]);
+            i++;
+        }
+    }
+
+    return true;
+}
+
+uint32_t mat_mult::receive_payload(const uint64_t *packets, uint32_t n) {
+    // stop at the end of the payload, or at the end of the row when streaming
+    bool stream_subj = streaming() && _regs.cmd_type_reg.is_subj;
+    uint32_t cols = GET_CMD_SIZE_SUBJ_COLS(_cur_cmd);
+    uint32_t n_el = _expected_el > _loaded_el ? _expected_el - _loaded_el : 0;
+    if (stream_subj) {
+        n_el = cols - (_loaded_el % cols);
+    }
+    uint32_t n_packets = (n_el + sizeof(uint64_t) - 1) / sizeof(uint64_t);
+    if (n_packets == 0) n_packets = 1;
+    if (n_packets > n) n_packets = n;
+
+    // write data in packets to internal memory
+    memcpy(_cur_ptr, packets, n_packets * sizeof(uint64_t));
+    _cur_ptr += n_packets;
+    _regs.status_reg.ready = false;
+    _loaded_el += n_packets * sizeof(uint64_t);
+
+    if (_regs.cmd_type_reg.is_subj && (_loaded_el % cols) == 0) {
+        sc_tracer::trigger("row", _loaded_el / cols);
+    }
+
+    // compute the output rows completed by a new input row
+    bool row_done = stream_subj && (_loaded_el % cols) == 0;
+    if (row_done) {
+        _stream_rows_in++;
+        stream_rows(_loaded_el >= _expected_el);
+    }
+
+    // complete payload reception
+    if (_loaded_el >= _expected_el) {
+        LOG_DEBUG(this->name(), "Loaded %d/%d", _loaded_el, _expected_el);
+        // start calculating when all elements loaded
+        if (_regs.cmd_type_reg.is_subj && !streaming()) {
+            calculate();
+        }
+        _loaded_el = 0;
+        _expected_el = 0;
+
+        _regs.status_reg.ready = true;
+        
+        // issue acknowledge packet
+        write_ack();
+    }
+
+    // decoding FSM
+    calculate_next_state();
+
+    // advance pointer
+    if (_next_state == WAIT_CMD_SKEY) {
+        // reset for new command
+        _cur_ptr = (uint64_t*)&_cur_cmd.s_key;
+    }
+    else if (row_done) {
+        // wrap to the ring slot of the next row
+        _cur_ptr = (uint64_t*)stream_slot(_stream_rows_in);
+    }
+
+    // advance to next state
+    advance_state();
+
+    return n_packets;
+}
+
 void mat_mult::protected_reset() {
     // reset state
     _cur_ptr = (uint64_t*)&_cur_cmd.s_key;
@@ -98,44 +201,97 @@ void mat_mult::protected_reset() {
     mat_mult_top::protected_reset();
 }
 
+bool mat_mult::configure_kernel(uint8_t kern_dim, uint8_t n_kern) {
+    _conv_fn = conv_select_bank(_isa, kern_dim);
+    if (!_conv_fn) {
+        LOG_ERROR(this->name(), "No %s engine for %dx%d kernels", conv_isa_name(_isa), kern_dim, kern_dim);
+        return false;
+    }
+
+    _n_kern = n_kern;
+    return true;
+}
+
 void mat_mult::calculate() {
     // bounds
     uint16_t rows = (uint16_t)(GET_CMD_SIZE_SUBJ_ROWS(_cur_cmd));
     uint16_t cols = (uint16_t)(GET_CMD_SIZE_SUBJ_COLS(_cur_cmd));
+    if (!_conv_fn) {
+        LOG_ERROR(this->name(), "No kernel loaded");
+        return;
+    }
+
+    // split the output into horizontal bands, more bands than threads to balance the load
+    uint32_t n_bands = _pool->size() * 4;
+    uint32_t band_rows = (rows + n_bands - 1) / n_bands;
+    if (band_rows < MIN_BAND_ROWS) band_rows = MIN_BAND_ROWS;
+    n_bands = (rows + band_rows - 1) / band_rows;
 
     // calculations
-    uint64_t data = 0;
+    _pool->run(n_bands, [&](uint32_t band) {
+        uint32_t r_start = band * band_rows;
+        uint32_t r_end = r_start + band_rows > rows ? rows : r_start + band_rows;
+        calculate_band(r_start, r_end, rows, cols);
+    });
+
+    // write data back to CPU memory in address order, the output matrices of the bank follow each other
     uint64_t addr = ((uint64_t)GET_CMD_OUT_ADDR(_cur_cmd));
-    LOGF("[%s] writing to %016lx, matrix is %dx%d", this->name(), addr, rows, cols);
-    for (uint16_t r = 0; r < rows; r++) {
-        for (uint16_t c = 0; c < cols; c++) {
-            // accumulate result
-            uint32_t res = 0;
-
-            // compute kernel dot product with neighborhood
-            int kerneli = 0;
-            for (int i = r - _hf_kern_dim; i <= r + _hf_kern_dim; i++) {
-                for (int j = c - _hf_kern_dim; j <= c + _hf_kern_dim; j++) {
-                    if (i >= 0 && i < rows && j >= 0 && j < cols) {
-                        res += (uint32_t)subj_mem[i*cols + j] // matrix value is unsigned byte
-                            * (uint32_t)kern_mem[kerneli]; // kernel value is signed byte
-                    }
-                    kerneli++;
-                }
-            }
-
-            // write data to output buffer
-            data |= (uint64_t)(res & 0xff) << ((c & 0x7) << 3);
-
-            // write data back to CPU memory
-            if ((c & 0x7) == 0x7) {
-                mem_if->write(addr, data);
-                //printf("Write to %016lx, %016lx\n", addr, data);
-                data = 0;
-                addr += 8;
-            }
+    uint64_t n_el = (uint64_t)rows*cols*_n_kern;
+    LOG_INFO(this->name(), "writing to %016lx, %d matrices of %dx%d", addr, _n_kern, rows, cols);
+    write_mem(addr, (uint64_t*)out_mem, n_el / 8);
+
+    LOG_INFO(this->name(), "Done multiplying");
+}
+
+void mat_mult::calculate_band(uint16_t r_start, uint16_t r_end, uint16_t rows, uint16_t cols) {
+    const uint8_t *in_rows[MAX_KERN_DIM];
+
+    for (uint16_t r = r_start; r < r_end; r++) {
+        // rows covered by the kernel (including the halo from neighbouring bands), null rows are zero padding
+        for (int i = 0; i < _kern_dim; i++) {
+            int subj_r = r + i - _hf_kern_dim;
+            in_rows[i] = (subj_r >= 0 && subj_r < rows) ? subj_mem + (uint64_t)subj_r*cols : nullptr;
         }
+
+        // compute the dot product of each kernel with each neighborhood in the row, reusing the rows across the bank
+        _conv_fn(in_rows, cols, kern_mem, _n_kern, out_mem + (uint64_t)r*cols, (uint64_t)rows*cols);
+    }
+}
+
+uint8_t *mat_mult::stream_slot(uint32_t r) {
+    return subj_mem + (uint64_t)(r % _kern_dim) * GET_CMD_SIZE_SUBJ_COLS(_cur_cmd);
+}
+
+void mat_mult::stream_rows(bool last) {
+    uint16_t rows = (uint16_t)(GET_CMD_SIZE_SUBJ_ROWS(_cur_cmd));
+    uint16_t cols = (uint16_t)(GET_CMD_SIZE_SUBJ_COLS(_cur_cmd));
+
+    // an output row is complete once its bottom halo row is received, the last rows are padded with zeros
+    uint32_t rows_ready = last ? rows : (_stream_rows_in > _hf_kern_dim ? _stream_rows_in - _hf_kern_dim : 0);
+    for (; _stream_rows_out < rows_ready; _stream_rows_out++) {
+        stream_output_row(_stream_rows_out, rows, cols);
+    }
+
+    if (last) {
+        LOG_INFO(this->name(), "Done multiplying");
+    }
+}
+
+void mat_mult::stream_output_row(uint32_t r, uint16_t rows, uint16_t cols) {
+    const uint8_t *in_rows[MAX_KERN_DIM];
+
+    // rows covered by the kernel from the ring, null rows are zero padding
+    for (int i = 0; i < _kern_dim; i++) {
+        int subj_r = (int)r + i - _hf_kern_dim;
+        in_rows[i] = (subj_r >= 0 && subj_r < rows) ? stream_slot(subj_r) : nullptr;
     }
 
-    LOGF("[%s] Done multiplying", this->name());
+    // compute the dot product of each kernel with each neighborhood in the row
+    _conv_fn(in_rows, cols, kern_mem, _n_kern, out_mem, cols);
+
+    // write the row of each output matrix to CPU memory
+    uint64_t out_addr = ((uint64_t)GET_CMD_OUT_ADDR(_cur_cmd)) + (uint64_t)r*cols;
+    for (uint32_t k = 0; k < _n_kern; k++) {
+        write_mem(out_addr + (uint64_t)k*rows*cols, (uint64_t*)(out_mem + (uint64_t)k*cols), cols / 8);
+    }
 }
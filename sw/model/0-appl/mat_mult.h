@@ -3,6 +3,8 @@
 #include "system.h"
 #include "mat_mult_if.h"
 #include "mat_mult_top.h"
+#include "conv_engine.h"
+#include "thread_pool.hpp"
 
 #ifndef MAT_MULT_H
 #define MAT_MULT_H
@@ -11,29 +13,86 @@ class mat_mult : public mat_mult_top {
 
     public:
 
-        /** Constructor. */
-        mat_mult(sc_module_name name);
+        /**
+         * @brief Constructor.
+         *
+         * @param name      SystemC module name.
+         * @param n_threads Number of host threads computing output bands. 0 uses all hardware threads.
+         * @param stream    Compute each output row as soon as its last input row is received, keeping
+         *                  only a ring of kernel dimension rows instead of the whole subject.
+         */
+        mat_mult(sc_module_name name, uint32_t n_threads = 1, bool stream = false);
+
+        /** Destructor. */
+        ~mat_mult();
 
     protected:
 
         /** Receive a 64-bit packet. */
         bool receive_packet(uint64_t addr, uint64_t packet);
 
+        /** Receive a burst of packets, copying whole runs of payload into the internal memories. */
+        bool receive_packets(uint64_t addr, const uint64_t *packets, uint32_t n);
+
         /** Reset function to be overridden and called by subclasses. */
         void protected_reset();
 
+        /** Select the convolution specialized for the kernel dimension. */
+        bool configure_kernel(uint8_t kern_dim, uint8_t n_kern);
+
         // state variables
         uint64_t *_cur_ptr;
         uint32_t _expected_el;
         uint32_t _loaded_el;
         uint8_t _kern_dim;
         uint8_t _hf_kern_dim;
+        uint8_t _n_kern;
 
     private:
 
-        // internal memories
-        uint8_t subj_mem[MAT_SIZE];
-        uint8_t kern_mem[KERN_SIZE_ROUNDED];
+        // internal memories, the subject memory is sized for the largest subject received
+        // (or the ring of input rows when streaming)
+        uint8_t *subj_mem;
+        uint8_t kern_mem[KERN_BANK_SIZE_ROUNDED];
+
+        // output staging, one matrix per kernel, each band writes its own rows (cache line aligned to avoid false sharing)
+        // (or one row per kernel when streaming)
+        uint8_t *out_mem;
+        uint64_t _subj_capacity;
+        uint64_t _out_capacity;
+
+        // convolution engine selected for the host CPU, then specialized for the kernel
+        conv_isa_e _isa;
+        conv_bank_fn _conv_fn;
+
+        // host threads computing output bands
+        thread_pool *_pool;
+
+        // streaming state
+        bool _stream;
+        uint32_t _stream_rows_in;  // input rows received
+        uint32_t _stream_rows_out; // output rows written
+
+        /** Copy up to `n` payload packets, stopping at the end of the payload or streamed row. Returns the number copied. */
+        uint32_t receive_payload(const uint64_t *packets, uint32_t n);
+
+        /** Grow the subject and output memories to hold `subj_el` and `out_el` elements. */
+        void reserve_memories(uint64_t subj_el, uint64_t out_el);
+
+        /** Whether the current subject is streamed, which needs a loaded kernel and whole rows to size the ring. */
+        bool streaming() const { return _stream && _conv_fn && GET_CMD_SIZE_SUBJ_COLS(_cur_cmd); }
+
+        /** Ring slot holding input row `r` when streaming. */
+        uint8_t *stream_slot(uint32_t r);
+
+        /** Compute and write the output rows whose input rows have all been received. */
+        void stream_rows(bool last);
+
+        /** Compute output row `r` from the ring and write it to the command host. */
+        void stream_output_row(uint32_t r, uint16_t rows, uint16_t cols);
+
+        /** Convolve output rows `[r_start, r_end)` into `out_mem`. */
+        void calculate_band(uint16_t r_start, uint16_t r_end, uint16_t rows, uint16_t cols);
 
         void calculate();
 
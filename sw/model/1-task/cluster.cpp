@@ -24,14 +24,14 @@ cluster_memory::~cluster_memory() {
 
 bool cluster_memory::do_read(uint32_t addr, uint32_t& data) {
     data = _mem[_r_cursor++]; // get current sub result for update
-    DEBUGF("[%s] loaded subresult (%d/%d) %08x", this->name(), _r_cursor, INTERNAL_MEMORY_SIZE_PER_GROUP, data);
+    DEBUGF("loaded subresult (%d/%d) %08x", _r_cursor, INTERNAL_MEMORY_SIZE_PER_GROUP, data);
     _r_cursor %= INTERNAL_MEMORY_SIZE_PER_GROUP; // wrap cursor
     return true;
 }
 
 bool cluster_memory::do_write(uint32_t addr, uint32_t data) {
     _mem[_w_cursor++] = data; // store sub result and increment cursor
-    DEBUGF("[%s] stored subresult (%d/%d) %08x", this->name(), _w_cursor, INTERNAL_MEMORY_SIZE_PER_GROUP, data);
+    DEBUGF("stored subresult (%d/%d) %08x", _w_cursor, INTERNAL_MEMORY_SIZE_PER_GROUP, data);
     _w_cursor %= INTERNAL_MEMORY_SIZE_PER_GROUP; // wrap cursor
     return true;
 }
@@ -50,13 +50,16 @@ cluster_if::cluster_if(uint32_t start_group, uint32_t n_groups, uint32_t n_cores
   * @param  n_groups    Number of groups of input data to process.
   * @param  n_cores     Number of computation cores in the cluster.
   * @param  kernel_dim  Size of the current kernel.
+  * @param  event_driven Sleep while disabled instead of polling every cycle.
   */
-cluster::cluster(sc_module_name name, uint32_t start_group, uint32_t n_groups, uint32_t n_cores, uint8_t kernel_dim, uint32_t packet_size)
-    : sc_module(name), cluster_if(start_group, n_groups, n_cores, packet_size), _kern_dim(kernel_dim),
-    _enabled("enabled"), _command_type("command_type"), _res_valid("res_valid"), _new_packet("new_packet")
+cluster::cluster(sc_module_name name, uint32_t start_group, uint32_t n_groups, uint32_t n_cores, uint8_t kernel_dim, uint32_t packet_size, bool event_driven)
+    : sc_module(name), cluster_if(start_group, n_groups, n_cores, packet_size), core_ifs("core_ifs", n_cores), _kern_dim(kernel_dim), _n_kern(1), _event_driven(event_driven),
+    _enabled("enabled"), _command_type("command_type"), _res_valid("res_valid"), _new_packet("new_packet"), _busy_cycles(0)
 {
     if (n_groups) {
-        _out = new uint8_t[n_groups];
+        _out = new uint8_t[n_groups * MAX_KERN_BANK];
+
+        perf_counters::add(this->name(), "busy_cycles", &_busy_cycles);
     }
 
     _enabled.write(SC_LOGIC_0);
@@ -72,13 +75,14 @@ cluster::~cluster() {
     }
 }
 
-void cluster::activate(uint32_t command_type, uint32_t r, uint32_t c) {
-    LOGF("[%s] configured for cmd type %d, %dx%d matrix", this->name(), command_type, r, c);
+void cluster::activate(uint32_t command_type, uint32_t r, uint32_t c, uint32_t n_kern) {
+    LOG_DEBUG(this->name(), "configured for cmd type %d, %dx%d matrix, %d kernels", command_type, r, c, n_kern);
     // allow cluster to tap the bus data
     _enabled.write(SC_LOGIC_1);
 
     // latch configuration
     _command_type.write(command_type);
+    _n_kern = n_kern;
 
     // initialize FSM
     _kernel_cursor = 0;
@@ -111,7 +115,7 @@ void cluster::receive_packet(uint64_t addr, uint64_t packet, uint8_t *out_ptr) {
 
         _new_packet.write(SC_LOGIC_1);
 
-        DEBUGF("[%s] Recv %016lx", this->name(), packet);
+        DEBUGF("Recv %016lx", packet);
     }
 }
 
@@ -120,9 +124,11 @@ void cluster::clear_packet() {
 }
 
 bool cluster::get_results(uint8_t *res) {
-    memcpy(res, _out, _n_groups);
+    for (uint32_t kern_i = 0; kern_i < _n_kern; kern_i++) {
+        memcpy(res + kern_i * CLUSTER_RESULTS_STRIDE, _out + kern_i * _n_groups, _n_groups);
+    }
     if (_res_valid.read().to_bool()) {
-        DEBUGF("[%s] Returning group %d: %02x to %016lx", this->name(), _start_group, _out[0], (uint64_t)(void*)res);
+        DEBUGF("Returning group %d: %02x to %016lx", _start_group, _out[0], (uint64_t)(void*)res);
     }
     else {
         DEBUGF("[%s] no results", this->name());
@@ -143,8 +149,9 @@ void cluster::main() {
     uint8_t dispatch_data[MAX_CLUSTER_INPUT_SIZE];
 
     // local variables
-    int group_i;
-    int core_i;
+    uint32_t group_i;
+    int kern_i;
+    uint32_t core_i;
     int row_i;
     uint32_t subres;
 
@@ -158,63 +165,69 @@ void cluster::main() {
             // route previous output data
             _res_valid.write(SC_LOGIC_0);
             for (group_i = 0; group_i < _n_groups; group_i++) {
-                // iterate through kernel rows (start with last to not overwrite subresults)
                 core_i = _n_cores-1;
-                for (row_i = _kern_dim-1; row_i >= 0; --row_i){
-                    // output result from previous computation
-                    if (core_ifs[core_i]->get_row_result(subres)) {
-                        if (row_i == (_kern_dim - 1)) {
-                            // output total result
-                            _out[group_i] = (uint8_t)subres; // implicit mask with 0xff
-                            _res_valid.write(SC_LOGIC_1);
-
-                            DEBUGF("[%score%d] (row %d) result %08x", this->name(), core_i, row_i, subres);
-                        }
-                        else {
-                            // write subresult to internal memory
-                            subres_mem_ifs[row_i]->write(0, subres);
+                for (kern_i = _n_kern-1; kern_i >= 0; --kern_i) {
+                    // iterate through kernel rows (start with last to not overwrite subresults)
+                    for (row_i = _kern_dim-1; row_i >= 0; --row_i){
+                        // output result from previous computation
+                        if (core_ifs[core_i]->get_row_result(subres)) {
+                            if (row_i == (_kern_dim - 1)) {
+                                // output total result
+                                _out[kern_i * _n_groups + group_i] = (uint8_t)subres; // implicit mask with 0xff
+                                _res_valid.write(SC_LOGIC_1);
+
+                                DEBUGF("core%d (kernel %d, row %d) result %08x", core_i, kern_i, row_i, subres);
+                            }
+                            else {
+                                // write subresult to internal memory
+                                subres_mem_ifs[row_i]->write(0, subres);
+                            }
                         }
-                    }
 
-                    // move to next core
-                    if (!core_i) core_i = _n_cores;
-                    core_i--;
+                        // move to next core
+                        if (!core_i) core_i = _n_cores;
+                        core_i--;
+                    }
                 }
             }
 
             // route input data
             if (_new_packet.read().to_bool()) {
+                _busy_cycles++;
                 memcpy(dispatch_data, _dispatch_data, MAX_CLUSTER_INPUT_SIZE);
 
                 if (command_type == MM_CMD_SUBJ) {
                     for (group_i = 0; group_i < _n_groups; group_i++) {
-                        // iterate through kernel rows (start with last to not overwrite subresults)
+                        // the dispatched group is shared by the cores of every kernel in the bank
                         core_i = _n_cores-1;
-                        for (row_i = _kern_dim-1; row_i >= 0; --row_i){
-                            // load previous sub result to accumulate (only after first row)
-                            if(row_i != 0) {
-                                subres_mem_ifs[row_i-1]->read(0, subres);
-                            }
-                            else {
-                                subres = 0;
-                                // LOGF("[%score%d] (row %d) loaded subresult %08x", this->name(), core_i, row_i, subres);
+                        for (kern_i = _n_kern-1; kern_i >= 0; --kern_i) {
+                            // iterate through kernel rows (start with last to not overwrite subresults)
+                            for (row_i = _kern_dim-1; row_i >= 0; --row_i){
+                                // load previous sub result to accumulate (only after first row)
+                                if(row_i != 0) {
+                                    subres_mem_ifs[row_i-1]->read(0, subres);
+                                }
+                                else {
+                                    subres = 0;
+                                    // LOGF("core%d (row %d) loaded subresult %08x", core_i, row_i, subres);
+                                }
+
+                                // send current kernel row and data group to core to calculate
+                                core_ifs[core_i]->calculate_row_result(subres, _kernel_mem + ((kern_i * _kern_dim + row_i) * _kern_dim), dispatch_data + _start_group + group_i);
+
+                                // move to next core
+                                if (!core_i) core_i = _n_cores;
+                                core_i--;
                             }
-
-                            // send current kernel row and data group to core to calculate
-                            core_ifs[core_i]->calculate_row_result(subres, _kernel_mem + (row_i * _kern_dim), dispatch_data + _start_group + group_i);
-
-                            // move to next core
-                            if (!core_i) core_i = _n_cores;
-                            core_i--;
                         }
                     }
                 }
 
                 // buffer current (kernel_dim - 1) last pixels
-                DEBUGF("[%s] data: %02x %02x %02x %02x %02x", this->name(),
+                DEBUGF("data: %02x %02x %02x %02x %02x",
                     _dispatch_data[_start_group+0], _dispatch_data[_start_group+1], _dispatch_data[_start_group+2], _dispatch_data[_start_group+3], _dispatch_data[_start_group+4]);
                 memcpy(_dispatch_data, dispatch_data + _packet_size, (_kern_dim - 1));
-                DEBUGF("[%s] shifted data: %02x %02x %02x %02x %02x", this->name(),
+                DEBUGF("shifted data: %02x %02x %02x %02x %02x",
                     _dispatch_data[_start_group+0], _dispatch_data[_start_group+1], _dispatch_data[_start_group+2], _dispatch_data[_start_group+3], _dispatch_data[_start_group+4]);
             }
             else {
@@ -228,6 +241,12 @@ void cluster::main() {
             for (core_i = 0; core_i < _n_cores; ++core_i) {
                 core_ifs[core_i]->reset();
             }
+
+            // the cores stay in reset until the top-level activates the cluster
+            if (_event_driven) {
+                IDLE_CORE(_enabled.value_changed_event());
+                continue;
+            }
         }
 
         // next posedge
@@ -3,6 +3,7 @@
 #include "memory_if.hpp"
 #include "cluster_if.h"
 #include "core.h"
+#include "perf_counters.h"
 
 #include "systemc.h"
 
@@ -51,21 +52,21 @@ class cluster : public sc_module, public cluster_if {
 
     public:
 
-        // internal core interfaces
-        sc_port<core_if> core_ifs[MAX_N_CORES_PER_CLUSTER];
+        // internal core interfaces, one per core of the cluster
+        sc_vector<sc_port<core_if>> core_ifs;
 
         // internal memory interface
         sc_port<cluster_memory> subres_mem_ifs[MAX_KERN_DIM-1];
 
         /** Constructor. */
         SC_HAS_PROCESS(cluster);
-        cluster(sc_module_name name, uint32_t start_group, uint32_t n_groups, uint32_t n_cores, uint8_t kernel_dim, uint32_t packet_size);
+        cluster(sc_module_name name, uint32_t start_group, uint32_t n_groups, uint32_t n_cores, uint8_t kernel_dim, uint32_t packet_size, bool event_driven = false);
 
         /** Destructor. */
         ~cluster();
 
         /** Once the command header has been received, activate the cluster. */
-        void activate(uint32_t command_type, uint32_t r, uint32_t c);
+        void activate(uint32_t command_type, uint32_t r, uint32_t c, uint32_t n_kern);
 
         /** Disable the kernel after all payload packets received. */
         void disable();
@@ -86,6 +87,8 @@ class cluster : public sc_module, public cluster_if {
 
         /* Configuration. */
         uint8_t _kern_dim;
+        uint32_t _n_kern;
+        bool _event_driven;
 
         /** Per-image configuration. */
         sc_signal<sc_logic> _enabled;
@@ -97,9 +100,12 @@ class cluster : public sc_module, public cluster_if {
 
         /** Buffers. */
         uint8_t _dispatch_data[MAX_CLUSTER_INPUT_SIZE];
-        uint8_t *_out;
-        uint8_t _kernel_mem[KERN_SIZE_ROUNDED];
-        uint8_t _kernel_cursor;
+        uint8_t *_out; // output pixels of each group, for each kernel in the bank
+        uint8_t _kernel_mem[KERN_BANK_SIZE_ROUNDED];
+        uint16_t _kernel_cursor;
+
+        /** Performance counters. */
+        uint64_t _busy_cycles; // cycles dispatching a packet to the cores
 
         /** Main thread function. */
         void main();
@@ -3,14 +3,17 @@
 #include "system.h"
 #include "systemc.h"
 
-core::core(sc_module_name name, uint8_t kern_dim)
-    : sc_module(name), _kern_dim(kern_dim),
-    _rst("rst"), _enable("enable"), _res_valid("res_valid"), _carry("carry"), _result("result")
+core::core(sc_module_name name, uint8_t kern_dim, bool event_driven)
+    : sc_module(name), _kern_dim(kern_dim), _event_driven(event_driven),
+    _rst("rst"), _enable("enable"), _res_valid("res_valid"), _carry("carry"), _result("result"), _active_cycles(0), _mac_ops(0)
 {
     // allocate memory
     if (kern_dim) {
         _kern_row = new uint8_t[kern_dim];
         _group = new uint8_t[kern_dim];
+
+        perf_counters::add(this->name(), "active_cycles", &_active_cycles);
+        perf_counters::add(this->name(), "mac_ops", &_mac_ops);
     }
 
     _rst.write(SC_LOGIC_0);
@@ -42,7 +45,7 @@ void core::calculate_row_result(uint32_t carry, uint8_t *kern_row, uint8_t *grou
 
 bool core::get_row_result(uint32_t &res) {
     // output 18 bits
-    res = _result.read() & 0x3ffff;
+    res = conv_core_result(_result.read());
     return _res_valid.read().to_bool();
 }
 
@@ -53,7 +56,7 @@ void core::reset() {
 
 void core::main() {
     // local copies for processing
-    bool rst, enable;
+    bool rst, enable, active;
     uint32_t result;
     uint32_t carry;
     uint8_t kern_row[_kern_dim];
@@ -69,15 +72,15 @@ void core::main() {
         YIELD();
 
         // compute and update
-        if (_enable.read().to_bool() && !rst) {
+        active = _enable.read().to_bool() && !rst;
+        if (active) {
             // perform computation
-            result = carry;
-            for (int i = 0; i < _kern_dim; ++i) {
-                result += (uint32_t)kern_row[i] * (uint32_t)group[i];
-            }
+            result = conv_dot_dim(_kern_dim, carry, kern_row, group);
+            _active_cycles++;
+            _mac_ops += _kern_dim;
 
-            DEBUGF("[%s]: computed new result %08x = %08x + (%02x %02x %02x %02x %02x).(%02x %02x %02x %02x %02x)",
-                this->name(), result, carry,
+            DEBUGF("computed new result %08x = %08x + (%02x %02x %02x %02x %02x).(%02x %02x %02x %02x %02x)",
+                result, carry,
                 kern_row[0], kern_row[1], kern_row[2], kern_row[3], kern_row[4],
                 group[0], group[1], group[2], group[3], group[4]
                 );
@@ -90,7 +93,12 @@ void core::main() {
             _res_valid.write(SC_LOGIC_0);
         }
 
-        // next posedge
-        POS_CORE();
+        // next posedge, the outputs of an idle core do not change until the cluster enables it
+        if (_event_driven && !active) {
+            IDLE_CORE(_rst.value_changed_event() | _enable.value_changed_event());
+        }
+        else {
+            POS_CORE();
+        }
     }
 }
@@ -1,5 +1,7 @@
 
 #include "system.h"
+#include "conv_engine.h"
+#include "perf_counters.h"
 
 #include "systemc.h"
 
@@ -28,9 +30,15 @@ class core : public sc_module, public core_if {
 
     public:
 
-        /** Constructor. */
+        /**
+         * @brief Constructor.
+         *
+         * @param name         SystemC module name.
+         * @param kern_dim     Kernel dimension.
+         * @param event_driven Sleep while reset or disabled instead of polling every cycle.
+         */
         SC_HAS_PROCESS(core);
-        core(sc_module_name name, uint8_t kern_dim = MAX_KERN_DIM);
+        core(sc_module_name name, uint8_t kern_dim = MAX_KERN_DIM, bool event_driven = false);
 
         /** Destructor. */
         ~core();
@@ -48,6 +56,7 @@ class core : public sc_module, public core_if {
 
         /** Configuration. */
         uint8_t _kern_dim;
+        bool _event_driven;
 
         /** Status signals. */
         sc_signal<sc_logic> _rst;
@@ -60,6 +69,10 @@ class core : public sc_module, public core_if {
         sc_signal<uint32_t> _carry;
         sc_signal<uint32_t> _result;
 
+        /** Performance counters. */
+        uint64_t _active_cycles;
+        uint64_t _mac_ops;
+
         /** Main thread function. */
         void main();
 
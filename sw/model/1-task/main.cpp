@@ -6,18 +6,20 @@
 #include "mat_mult_if.h"
 #include "mat_mult_cmd.h"
 #include "sc_trace.hpp"
+#include "perf_counters.h"
 
 #include "systemc.h"
 #include <iostream>
 #include <string>
 
 int kernel_dim;
-uint8_t memory[MEM_SIZE];
+uint8_t *memory;
 
 sc_tracer sc_tracer::tracer;
+latency_tracker latency_tracker::tracker;
 
 int sc_main(int argc, char* argv[]) {
-    if (!parseCmdLine(argc, argv, memory, &kernel_dim)) {
+    if (!parseCmdLine(argc, argv, &memory, &kernel_dim)) {
         return 1;
     }
 
@@ -31,8 +33,18 @@ int sc_main(int argc, char* argv[]) {
 
     // Design optimization parameters
     uint32_t n_clusters = MAX_N_CLUSTERS; // number of clusters (must be a power of 2)
-    uint32_t n_cores_per_cluster = kernel_dim;
+    uint32_t n_cores_per_cluster = kernel_dim * N_KERN; // one core per kernel row in the filter bank
     uint32_t payload_packet_size = PACKET_BYTES; // total number of bytes (pixels) received per payload packet (might be bigger than 64-bit if buffered)
+    bool event_driven = getOptionInt("event_driven", 0) != 0; // idle cores and clusters sleep instead of polling
+    int quantum = getOptionInt("quantum", 0); // core cycles the packet delivery runs ahead, 0 for strict timing
+    if (!optionsValid()) {
+        return 1;
+    }
+    if (quantum < 0 || quantum > LT_MAX_QUANTUM) {
+        std::cerr << "*** ERROR in main: invalid quantum " << quantum << ", max is " << LT_MAX_QUANTUM << " cycles" << std::endl;
+        return 1;
+    }
+    quantum_keeper::set_global_quantum(sc_time(CC_CORE(quantum), SC_NS));
 
     // Calculated design parameters
     uint32_t n_groups_per_cluster = (payload_packet_size + (kernel_dim - 1)) / n_clusters; // number of groups to be processed for each cluster (NOTE: the division must yield an integer)
@@ -48,6 +60,8 @@ int sc_main(int argc, char* argv[]) {
     sc_tracer::trace(n_cores_per_cluster, "top", "n_cores_per_cluster");
     sc_tracer::trace(payload_packet_size, "top", "payload_packet_size");
     sc_tracer::trace(n_groups_per_cluster, "top", "n_groups_per_cluster");
+    perf_counters::set_config("n_clusters", n_clusters);
+    perf_counters::set_config("n_cores_per_cluster", n_cores_per_cluster);
 
     // =====================================
     // ==== CREATE AND CONNECT MODULES =====
@@ -71,18 +85,14 @@ int sc_main(int argc, char* argv[]) {
     cluster_memory *cluster_mems[n_clusters * (n_cores_per_cluster - 1)];
 
     // dummy components
-    cluster *dummy_cluster = new cluster("dummy_cluster", 0, 0, 0, 0, 0);
-    core *dummy_core = new core("dummy_core", 0);
-    for (int i = 0; i < MAX_N_CORES_PER_CLUSTER; i++) {
-        dummy_cluster->core_ifs[i](*dummy_core);
-    }
+    cluster *dummy_cluster = new cluster("dummy_cluster", 0, 0, 0, 0, 0, event_driven);
     cluster_memory *dummy_cluster_mem = new cluster_memory("dummy_cluster_mem", 0);
-    for (int i = 0; i < MAX_N_CORES_PER_CLUSTER-1; i++) {
+    for (int i = 0; i < MAX_KERN_DIM-1; i++) {
         dummy_cluster->subres_mem_ifs[i](*dummy_cluster_mem);
     }
 
     // initialize each cluster
-    int i, j;
+    uint32_t i, j;
     for (i = 0; i < n_clusters; i++) {
         // initialize each cluster
         clusters[i] = new cluster(("cluster" + std::to_string(i)).c_str(),
@@ -90,21 +100,18 @@ int sc_main(int argc, char* argv[]) {
                                     n_groups_per_cluster,   // number of groups to process
                                     n_cores_per_cluster,    // number of cores
                                     kernel_dim,             // dimension of the kernel
-                                    payload_packet_size     // number of bytes in each packet
+                                    payload_packet_size,    // number of bytes in each packet
+                                    event_driven            // sleep while idle
                                     );
 
         // initialize each core for each cluster
         for (j = 0; j < n_cores_per_cluster; j++) {
-            cores[j + i * n_cores_per_cluster] = new core(("cluster" + std::to_string(i) + "core" + std::to_string(j)).c_str(), kernel_dim);
+            cores[j + i * n_cores_per_cluster] = new core(("cluster" + std::to_string(i) + "core" + std::to_string(j)).c_str(), kernel_dim, event_driven);
             clusters[i]->core_ifs[j](*cores[j + i * n_cores_per_cluster]);
         }
-        // garbage cores
-        for (; j < MAX_N_CORES_PER_CLUSTER; j++) {
-            clusters[i]->core_ifs[j](*dummy_core);
-        }
 
         // initialize each memory for each cluster
-        for (j = 0; j < kernel_dim-1; j++) {
+        for (j = 0; j < (uint32_t)(kernel_dim - 1); j++) {
             cluster_mems[j + i * (kernel_dim - 1)] = new cluster_memory(("cluster" + std::to_string(i) + "mem" + std::to_string(j)).c_str(), false);
             clusters[i]->subres_mem_ifs[j](*cluster_mems[j + i * (kernel_dim - 1)]);
         }
@@ -132,8 +139,12 @@ int sc_main(int argc, char* argv[]) {
     sc_time startTime = sc_time_stamp();
     sc_start();
     sc_time stopTime = sc_time_stamp();
+    sc_logger::flush(); // the records of the run come before the reports
 
-    cout << "Simulated for " << (stopTime - startTime) << endl;
+    cout << "Simulated for " << (stopTime - startTime) << " (" << (uint64_t)((stopTime - startTime) / sc_time(CC_CORE_NS, SC_NS)) << " core cycles)" << endl;
+    latency_tracker::print_report();
+    perf_counters::finish();
+    matrix_multiplier->print_report();
 
     // final state
     memoryWrite(argv, memory);
@@ -9,13 +9,29 @@
 mat_mult_task::mat_mult_task(sc_module_name name, uint32_t n_clusters, uint32_t n_cores_per_cluster, uint8_t kern_dim, uint32_t packet_size, uint32_t n_groups_per_cluster)
     : mat_mult_top(name), _n_clusters(n_clusters), _n_cores_per_cluster(n_cores_per_cluster), _kern_dim(kern_dim), _hf_kern_dim(kern_dim >> 1), _packet_size(packet_size), _n_groups_per_cluster(n_groups_per_cluster),
 
-    _new_packet("new_packet"), _addr("addr"), _packet("packet")
+    _n_kern(1), _plane_size(0), _new_packet("new_packet"), _addr("addr"), _packet("packet")
 {
     _new_packet.write(SC_LOGIC_0);
 
     _in_fifo_head = 0;
     _in_fifo_tail = 0;
 
+    _decoupled = quantum_keeper::get_global_quantum() != SC_ZERO_TIME;
+    _lt_head = 0;
+    _lt_tail = 0;
+    _lt_asserted = false;
+    _lt_delivery_time = SC_ZERO_TIME;
+    _lt_strict_cycles = 0;
+
+    _in_fifo_occupancy_sum = 0;
+    _in_fifo_max_occupancy = 0;
+    _in_fifo_starved_cycles = 0;
+    _in_queue_stall_cycles = 0;
+    perf_counters::add(this->name(), "in_fifo_occupancy_sum", &_in_fifo_occupancy_sum);
+    perf_counters::add(this->name(), "in_fifo_max_occupancy", &_in_fifo_max_occupancy);
+    perf_counters::add(this->name(), "in_fifo_starved_cycles", &_in_fifo_starved_cycles);
+    perf_counters::add(this->name(), "in_queue_stall_cycles", &_in_queue_stall_cycles);
+
     SC_THREAD(main);
 }
 
@@ -26,13 +42,14 @@ void mat_mult_task::dispatch_packet(uint64_t addr, uint64_t packet) {
     _packet.write(packet);
 
     // dispatch to clusters
-    for (int i = 0; i < _n_clusters; i++) {
+    for (uint32_t i = 0; i < _n_clusters; i++) {
         cluster_ifs[i]->receive_packet(addr, packet, nullptr);
     }
 
     // enqueue in FIFO
     _in_fifo_packet[_in_fifo_tail & IN_FIFO_PTR_MASK] = packet;
     _in_fifo_addr[_in_fifo_tail & IN_FIFO_PTR_MASK] = addr;
+    latency_tracker::publish(INPUT_PACKET, (uint32_t)_in_fifo_tail);
     _in_fifo_tail++;
 }
 
@@ -41,33 +58,124 @@ void mat_mult_task::dispatch_packet(uint64_t addr, uint64_t packet) {
  * latch the status in the acknowledge packet.
  */
 bool mat_mult_task::receive_packet(uint64_t addr, uint64_t packet) {
-    DEBUGF("[%s] Recv %016lx at %016lx", this->name(), packet, addr);
+    sc_time start = _qk.get_current_time();
+    transfer_packet(addr, packet);
+    if (!_decoupled) deassert_packet();
+    else _lt_delivery_time += _qk.get_current_time() - start;
+
+    return true;
+}
+
+/**
+ * Receive a burst of packets, one per core cycle. The new packet signals stay
+ * asserted until the end of the burst.
+ */
+bool mat_mult_task::receive_packets(uint64_t addr, const uint64_t *packets, uint32_t n) {
+    sc_time start = _qk.get_current_time();
+    for (uint32_t i = 0; i < n; ++i) {
+        uint64_t addr_i = BURST_ADDR(addr, i);
+        if ((addr_i & ADDR_MASK) >= OFFSET_COMMAND) {
+            // command packets are not routed to the clusters
+            deassert_packet();
+        }
+        transfer_packet(addr_i, packets[i]);
+    }
+
+    // the caller continues in the simulation time, the main thread deasserts when the queue drains
+    if (_decoupled) {
+        _qk.sync();
+        _lt_delivery_time += _qk.get_current_time() - start;
+    }
+    else {
+        deassert_packet();
+    }
+
+    return true;
+}
+
+void mat_mult_task::transfer_packet(uint64_t addr, uint64_t packet) {
+    DEBUGF("Recv %016lx at %016lx", packet, addr);
 
     // dispatch values to clusters
     _loaded_el += PACKET_BYTES;
-    dispatch_packet(addr, packet);
-    POS_CORE();
+    if (_decoupled) {
+        queue_packet(addr, packet);
+    }
+    else {
+        dispatch_packet(addr, packet);
+        POS_CORE();
+    }
 
     if (_regs.cmd_type_reg.is_subj && _cur_state == WAIT_DATA) {
         // insert packet at end of row
         if (_loaded_el && ((_loaded_el % (uint32_t)GET_CMD_SIZE_SUBJ_COLS(_cur_cmd)) == 0)) {
-            dispatch_packet(addr, 0);
+            if (_decoupled) {
+                queue_packet(addr, 0);
+            }
+            else {
+                dispatch_packet(addr, 0);
+                POS_CORE();
+            }
+        }
+    }
+}
+
+void mat_mult_task::queue_packet(uint64_t addr, uint64_t packet) {
+    bool is_cmd = (addr & ADDR_MASK) >= OFFSET_COMMAND;
+
+    // the command decoding activates the clusters, so the header is a hand-off in the simulation time
+    if (is_cmd) _qk.sync();
+
+    // wait for room in the queue
+    while (_lt_tail - _lt_head >= LT_QUEUE_SIZE) {
+        _qk.sync();
+        if (_lt_tail - _lt_head >= LT_QUEUE_SIZE) {
+            _in_queue_stall_cycles++;
             POS_CORE();
         }
     }
 
+    _lt_packet[_lt_tail & LT_QUEUE_PTR_MASK] = packet;
+    _lt_addr[_lt_tail & LT_QUEUE_PTR_MASK] = addr;
+    _lt_tail++;
+    _lt_strict_cycles++; // strict timing waits a core cycle per packet
+
+    if (is_cmd) {
+        // wait until the main thread decoded the header packet
+        do {
+            POS_CORE();
+        } while (_lt_head != _lt_tail);
+        _qk.reset();
+    }
+    else {
+        // one packet per core cycle
+        _qk.inc(sc_time(CC_CORE_NS, SC_NS));
+        if (_qk.need_sync()) _qk.sync();
+    }
+}
+
+void mat_mult_task::print_report() {
+    if (_decoupled) {
+        _qk.print_report(this->name());
+
+        // the header hand-offs and the stalls for room in the queue cost cycles the strict delivery does not take
+        uint64_t cycles = (uint64_t)(_lt_delivery_time / sc_time(CC_CORE_NS, SC_NS));
+        std::cout << "Packet delivery " << this->name() << ": " << cycles << " core cycles, " << _lt_strict_cycles << " with strict timing, "
+            << (int64_t)(cycles - _lt_strict_cycles) << " cycles of divergence" << std::endl;
+    }
+}
+
+void mat_mult_task::deassert_packet() {
     // deassert new packet signals
     _new_packet.write(SC_LOGIC_0);
-    for (int i = 0; i < _n_clusters; i++) {
+    for (uint32_t i = 0; i < _n_clusters; i++) {
         cluster_ifs[i]->clear_packet();
     }
-
-    return true;
 }
 
 void mat_mult_task::protected_reset() {
     // reset internal clusters
-    for (int i = 0; i < _n_clusters; ++i) {
+    for (uint32_t i = 0; i < _n_clusters; ++i) {
         cluster_ifs[i]->reset();
     }
 
@@ -84,25 +192,45 @@ void mat_mult_task::protected_reset() {
     mat_mult_top::protected_reset();
 }
 
+bool mat_mult_task::configure_kernel(uint8_t kern_dim, uint8_t n_kern) {
+    if (n_kern > 1 && n_kern * kern_dim > _n_cores_per_cluster) {
+        LOG_ERROR(this->name(), "%d kernels need %d cores per cluster", n_kern, n_kern * kern_dim);
+        return false;
+    }
+
+    _n_kern = n_kern;
+    return true;
+}
+
 void mat_mult_task::write_results_buffer() {
-    // write data with mask
-    if (_out_col > 0 && _out_row >= _hf_kern_dim) {
-        DEBUGF("[%s] Writing %016lx to %016lx, ", this->name(), *(uint64_t*)_results, _out_addr);
-        mem_if->write(_out_addr, *(uint64_t*)_results);
-        _out_addr += PACKET_BYTES;
+    bool do_write = _out_col > 0 && _out_row >= _hf_kern_dim;
+
+    for (int i = 0; i < _n_kern; i++) {
+        uint8_t *results = _results + i * CLUSTER_RESULTS_STRIDE;
+
+        // write data with mask, to the output matrix of the kernel
+        if (do_write) {
+            DEBUGF("Writing %016lx to %016lx, ", *(uint64_t*)results, _out_addr + i * _plane_size);
+            write_mem(_out_addr + i * _plane_size, (uint64_t*)results, 1);
+        }
+
+        // shift
+        memcpy(results, results + PACKET_BYTES, PACKET_BYTES);
     }
 
-    // shift
-    memcpy(_results, _results + PACKET_BYTES, PACKET_BYTES);
+    if (do_write) {
+        _out_addr += PACKET_BYTES;
+    }
 }
 
 void mat_mult_task::check_complete_reception() {
-    if (_loaded_el >= _expected_el) {
-        LOGF("Received and wrote all payload %d/%d", _loaded_el, _expected_el);
+    // the delivering thread counts the decoupled packets before they reach the clusters
+    if (_loaded_el >= _expected_el && _lt_head == _lt_tail) {
+        LOG_DEBUG(this->name(), "Received and wrote all payload %d/%d", _loaded_el, _expected_el);
         _loaded_el = 0;
         _expected_el = 0;
         _regs.status_reg.ready = true;
-        for (int i = 0; i < _n_clusters; ++i) {
+        for (uint32_t i = 0; i < _n_clusters; ++i) {
             cluster_ifs[i]->disable();
         }
 
@@ -118,15 +246,42 @@ void mat_mult_task::main() {
     uint64_t packet;
 
     // local variables
-    int i;
+    uint32_t i;
     bool res_valid;
     uint8_t *out_ptr;
+    uint64_t occupancy;
 
     while (true) {
         // capture values on posedge
         new_packet = false;
         YIELD(); YIELD();
 
+        // hand the next decoupled packet to the clusters
+        if (_decoupled) {
+            if (_lt_head != _lt_tail) {
+                uint64_t lt_addr = _lt_addr[_lt_head & LT_QUEUE_PTR_MASK];
+                uint64_t lt_packet = _lt_packet[_lt_head & LT_QUEUE_PTR_MASK];
+                _lt_head++;
+
+                // command packets are not routed to the clusters
+                if ((lt_addr & ADDR_MASK) >= OFFSET_COMMAND) {
+                    deassert_packet();
+                }
+                dispatch_packet(lt_addr, lt_packet);
+                _lt_asserted = true;
+            }
+            else if (_lt_asserted) {
+                deassert_packet();
+                _lt_asserted = false;
+            }
+        }
+
+        // input FIFO occupancy
+        occupancy = (uint64_t)(_in_fifo_tail - _in_fifo_head);
+        _in_fifo_occupancy_sum += occupancy;
+        if (occupancy > _in_fifo_max_occupancy) _in_fifo_max_occupancy = occupancy;
+        if (!occupancy && _cur_state == WAIT_DATA) _in_fifo_starved_cycles++;
+
         // =====================
         // ===== INPUT FSM =====
         // =====================
@@ -135,6 +290,7 @@ void mat_mult_task::main() {
             new_packet = true;
             addr = _in_fifo_addr[_in_fifo_head & IN_FIFO_PTR_MASK];
             packet = _in_fifo_packet[_in_fifo_head & IN_FIFO_PTR_MASK];
+            latency_tracker::capture(INPUT_PACKET, (uint32_t)_in_fifo_head);
             _in_fifo_head++;
 
             // address check
@@ -182,6 +338,7 @@ void mat_mult_task::main() {
                     if (_out_col > (uint32_t)GET_CMD_SIZE_SUBJ_COLS(_cur_cmd)) {
                         // new row
                         _out_row++;
+                        sc_tracer::trigger("row", _out_row);
                         _out_col = 0;
                     }
                 }
@@ -206,13 +363,13 @@ void mat_mult_task::main() {
 
         // activate clusters if necessary
         if (_cur_state != WAIT_DATA && _next_state == WAIT_DATA) {
-            LOG("ACTIVATE CLUSTERS");
-            for (int i = 0; i < _n_clusters; ++i) {
+            LOG_DEBUG(this->name(), "ACTIVATE CLUSTERS");
+            for (uint32_t i = 0; i < _n_clusters; ++i) {
                 if (_regs.cmd_type_reg.is_kern) {
-                    cluster_ifs[i]->activate(GET_CMD_TYPE(_cur_cmd), GET_CMD_SIZE_ROWS(_cur_cmd), GET_CMD_SIZE_COLS(_cur_cmd));
+                    cluster_ifs[i]->activate(GET_CMD_TYPE(_cur_cmd), GET_CMD_SIZE_ROWS(_cur_cmd), GET_CMD_SIZE_COLS(_cur_cmd), _n_kern);
                 }
                 else if (_regs.cmd_type_reg.is_subj) {
-                    cluster_ifs[i]->activate(GET_CMD_TYPE(_cur_cmd), GET_CMD_SIZE_SUBJ_ROWS(_cur_cmd), GET_CMD_SIZE_SUBJ_COLS(_cur_cmd));
+                    cluster_ifs[i]->activate(GET_CMD_TYPE(_cur_cmd), GET_CMD_SIZE_SUBJ_ROWS(_cur_cmd), GET_CMD_SIZE_SUBJ_COLS(_cur_cmd), _n_kern);
                 }
             }
 
@@ -221,6 +378,7 @@ void mat_mult_task::main() {
             _out_row = 0;
             _out_col = 0;
             _out_addr = (uint64_t)GET_CMD_OUT_ADDR(_cur_cmd);
+            _plane_size = (uint64_t)(GET_CMD_SIZE_SUBJ_ROWS(_cur_cmd) - _hf_kern_dim) * GET_CMD_SIZE_SUBJ_COLS(_cur_cmd);
         }
 
         // advance to next state
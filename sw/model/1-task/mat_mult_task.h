@@ -4,13 +4,16 @@
 #include "mat_mult_if.h"
 #include "mat_mult_top.h"
 #include "cluster.h"
+#include "quantum_keeper.hpp"
 
 #ifndef MAT_MULT_TASK_H
 #define MAT_MULT_TASK_H
 
-#define IN_FIFO_BUF_N_BITS 4
-#define IN_FIFO_BUF_SIZE (1 << IN_FIFO_BUF_N_BITS)
-#define IN_FIFO_PTR_MASK (IN_FIFO_BUF_SIZE - 1)
+// packets queued ahead of the clusters when decoupled, twice the largest quantum
+#define LT_QUEUE_N_BITS 7
+#define LT_QUEUE_SIZE (1 << LT_QUEUE_N_BITS)
+#define LT_QUEUE_PTR_MASK (LT_QUEUE_SIZE - 1)
+#define LT_MAX_QUANTUM (LT_QUEUE_SIZE >> 1) // in core cycles
 
 /**
  * @brief Task-level implementation of matrix convolution using the designed algorithm.
@@ -40,6 +43,9 @@ class mat_mult_task : public mat_mult_top {
                     uint32_t packet_size = PACKET_BYTES,
                     uint32_t n_groups_per_cluster = PACKET_BYTES/MAX_N_CLUSTERS);
 
+        /** Print the timing of the decoupled packet delivery, and its divergence from strict timing in core cycles. */
+        void print_report();
+
     private:
 
         /** Configuration. */
@@ -55,6 +61,10 @@ class mat_mult_task : public mat_mult_top {
         uint32_t _expected_el;
         uint32_t _loaded_el;
 
+        /** Filter bank. */
+        uint8_t _n_kern;
+        uint64_t _plane_size; // distance between the output matrices of consecutive kernels
+
         /** Output FSM. */
         uint64_t _out_addr;
         uint32_t _out_row;
@@ -71,13 +81,51 @@ class mat_mult_task : public mat_mult_top {
         uint64_t _in_fifo_packet[IN_FIFO_BUF_SIZE];
         uint64_t _in_fifo_addr[IN_FIFO_BUF_SIZE];
 
+        /**
+         * Loosely-timed delivery, with a global quantum. The payload packets
+         * are queued with the local time of the delivering thread, and the
+         * main thread hands them to the clusters one per cycle.
+         */
+        bool _decoupled;
+        quantum_keeper _qk;
+        uint32_t _lt_head;
+        uint32_t _lt_tail;
+        uint64_t _lt_packet[LT_QUEUE_SIZE];
+        uint64_t _lt_addr[LT_QUEUE_SIZE];
+        bool _lt_asserted;
+
+        /** Time the decoupled delivery took, against the core cycles it takes with strict timing, one per packet. */
+        sc_time _lt_delivery_time;
+        uint64_t _lt_strict_cycles;
+
+        /** Performance counters, the input FIFO is sampled once per core cycle. */
+        uint64_t _in_fifo_occupancy_sum;
+        uint64_t _in_fifo_max_occupancy;
+        uint64_t _in_fifo_starved_cycles; // FIFO empty while waiting for the payload
+        uint64_t _in_queue_stall_cycles;  // delivery waiting for room in the decoupled queue
+
         /** Output buffers. */
-        uint8_t _results[PACKET_BYTES * 2]; // store the output pixels from the current batch (has a size of _packet_size)
+        uint8_t _results[MAX_KERN_BANK * CLUSTER_RESULTS_STRIDE]; // store the output pixels from the current batch for each kernel (has a size of _packet_size)
 
         /** mat_mult_top.receive_packet */
         bool receive_packet(uint64_t addr, uint64_t packet);
         void protected_reset();
 
+        /** mat_mult_top.receive_packets, one packet per core cycle. */
+        bool receive_packets(uint64_t addr, const uint64_t *packets, uint32_t n);
+
+        /** Transfer a 64-bit packet to the clusters in one core cycle, plus one at the end of a subject row. */
+        void transfer_packet(uint64_t addr, uint64_t packet);
+
+        /** Deassert the new packet signals after a packet or burst. */
+        void deassert_packet();
+
+        /** Queue a packet for the main thread, advancing the local time of the caller. */
+        void queue_packet(uint64_t addr, uint64_t packet);
+
+        /** mat_mult_top.configure_kernel, each kernel row of the bank needs its own core. */
+        bool configure_kernel(uint8_t kern_dim, uint8_t n_kern);
+
         /** Dispatch a 64-bit packet to the internal FSM and clusters. */
         void dispatch_packet(uint64_t addr, uint64_t packet);
 
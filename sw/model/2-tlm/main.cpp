@@ -0,0 +1,101 @@
+
+#include "system.h"
+#include "mat_mult_tlm.h"
+#include "mat_mult_at.h"
+#include "mat_mult_if.h"
+#include "mat_mult_cmd.h"
+#include "tlm_memory.h"
+#include "quantum_keeper.hpp"
+
+#include "systemc.h"
+#include <iostream>
+#include <string>
+
+int kernel_dim;
+int hf_kernel_dim;
+uint8_t *memory;
+
+sc_tracer sc_tracer::tracer;
+latency_tracker latency_tracker::tracker;
+
+int sc_main(int argc, char* argv[]) {
+    if (!parseCmdLine(argc, argv, &memory, &kernel_dim)) {
+        return 1;
+    }
+
+    // bus cycles the command delivery runs ahead of the simulation time, 0 to synchronize every transaction
+    int quantum = getOptionInt("quantum", TLM_DEFAULT_QUANTUM);
+    if (quantum < 0) {
+        std::cerr << "*** ERROR in main: invalid quantum " << quantum << std::endl;
+        return 1;
+    }
+    quantum_keeper::set_global_quantum(sc_time(CC_MAIN(quantum), SC_NS));
+
+    // approximately-timed variant, with bursts in flight per initiator
+    bool at = getOptionInt("at", 0) != 0;
+    int outstanding = getOptionInt("outstanding", AT_DEFAULT_OUTSTANDING);
+    int n_threads = getOptionInt("threads", 1);
+    if (!optionsValid()) {
+        return 1;
+    }
+    if (outstanding < 1 || outstanding > AT_MAX_OUTSTANDING) {
+        std::cerr << "*** ERROR in main: invalid outstanding bursts " << outstanding << ", max is " << AT_MAX_OUTSTANDING << std::endl;
+        return 1;
+    }
+
+    // initial state
+    std::cout << "Matrix size: " << MAT_ROWS << "x" << MAT_COLS << ", kernel size: " << kernel_dim << "x" << kernel_dim << std::endl;
+    hf_kernel_dim = kernel_dim >> 1;
+    memoryPrint(memory, kernel_dim);
+
+    // =====================================
+    // ==== CREATE AND CONNECT MODULES =====
+    // =====================================
+
+    // CPU memory
+    tlm_memory *mem = new tlm_memory("mem", memory, MEM_SIZE);
+
+    // matrix multiplier, the commands are delivered through its payload socket
+    mat_mult_tlm *lt_multiplier = nullptr;
+    mat_mult_at *at_multiplier = nullptr;
+    mat_mult_top *matrix_multiplier;
+    if (at) {
+        at_multiplier = new mat_mult_at("matrix_multiplier", outstanding);
+        at_multiplier->host->socket.bind(at_multiplier->payload->socket);
+        at_multiplier->mem_master->socket.bind(mem->socket);
+        matrix_multiplier = at_multiplier;
+    }
+    else {
+        tlm_memory_port *mem_port = new tlm_memory_port("mem_port", MEM_SIZE);
+        mem_port->socket.bind(mem->socket);
+
+        lt_multiplier = new mat_mult_tlm("matrix_multiplier", mem_port, n_threads);
+        lt_multiplier->host_socket.bind(lt_multiplier->socket);
+        matrix_multiplier = lt_multiplier;
+    }
+
+    // command issuer (CPU)
+    mat_mult_cmd *cpu = new mat_mult_cmd("cpu", memory, kernel_dim);
+    cpu->mm_if(*matrix_multiplier);
+    matrix_multiplier->cmd_if(*cpu);
+
+    // =============================
+    // ==== RUN THE SIMULATION =====
+    // =============================
+    sc_time startTime = sc_time_stamp();
+    sc_start();
+    sc_time stopTime = sc_time_stamp();
+    sc_logger::flush(); // the records of the run come before the reports
+
+    cout << "Simulated for " << (stopTime - startTime) << endl;
+    latency_tracker::print_report();
+    perf_counters::finish();
+    if (at_multiplier) at_multiplier->print_report();
+    else lt_multiplier->print_report();
+
+    // final state
+    memoryWrite(argv, memory);
+    memoryPrint(memory, kernel_dim);
+
+    return 0;
+}
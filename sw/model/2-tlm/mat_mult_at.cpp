@@ -0,0 +1,173 @@
+
+#include "mat_mult_at.h"
+#include "system.h"
+#include "systemc.h"
+
+#include <iostream>
+
+at_in_fifo::at_in_fifo(sc_module_name name)
+    : at_target(name), _head(0), _count(0), _reserved(0)
+{
+}
+
+uint32_t at_in_fifo::peek(uint64_t *packets, uint32_t n) const {
+    if (n > _count) n = _count;
+    for (uint32_t i = 0; i < n; i++) {
+        packets[i] = _packets[(_head + i) & IN_FIFO_PTR_MASK];
+    }
+    return n;
+}
+
+void at_in_fifo::pop(uint32_t n) {
+    _head += n;
+    _count -= n;
+    notify_space();
+}
+
+bool at_in_fifo::try_accept(tlm::tlm_generic_payload &trans) {
+    uint32_t n = trans.get_data_length() / sizeof(uint64_t);
+    if (_count + _reserved + n > IN_FIFO_BUF_SIZE) return false;
+    _reserved += n;
+    return true;
+}
+
+void at_in_fifo::transfer(tlm::tlm_generic_payload &trans) {
+    uint32_t n = trans.get_data_length() / sizeof(uint64_t);
+    const uint64_t *packets = (const uint64_t*)trans.get_data_ptr();
+    for (uint32_t i = 0; i < n; i++) {
+        _packets[(_head + _count + i) & IN_FIFO_PTR_MASK] = packets[i];
+    }
+    _count += n;
+    _reserved -= n;
+    _data_event.notify(SC_ZERO_TIME);
+    trans.set_response_status(tlm::TLM_OK_RESPONSE);
+}
+
+at_memory_port::at_memory_port(sc_module_name name, uint64_t mem_size)
+    : sc_module(name), memory_if<uint64_t>(name, mem_size), _pending(0)
+{
+    // byte addresses
+    _addr_step = sizeof(uint64_t);
+}
+
+void at_memory_port::issued(uint64_t n) {
+    _pending -= n;
+    _issue_event.notify(SC_ZERO_TIME);
+}
+
+void at_memory_port::mark_interrupt() {
+    if (_writes.empty()) {
+        _writes.push_back({ 0, std::vector<uint64_t>(), true });
+        _write_event.notify(SC_ZERO_TIME);
+    }
+    else {
+        _writes.back().interrupt = true;
+    }
+}
+
+bool at_memory_port::do_write(uint64_t addr, uint64_t data) {
+    return do_write_block(addr, &data, 1);
+}
+
+bool at_memory_port::do_write_block(uint64_t addr, const uint64_t *data, uint64_t n) {
+    _writes.push_back({ addr, std::vector<uint64_t>(data, data + n), false });
+    _pending += n;
+    _write_event.notify(SC_ZERO_TIME);
+    return true;
+}
+
+mat_mult_at::mat_mult_at(sc_module_name name, uint32_t max_outstanding)
+    : mat_mult(name, 1, true), _in_transport(false), _compute_time(SC_ZERO_TIME), _out_stall_time(SC_ZERO_TIME)
+{
+    host = new at_initiator("host", max_outstanding);
+    payload = new at_in_fifo("payload");
+    mem_master = new at_initiator("mem_master", max_outstanding);
+
+    _mem_port = new at_memory_port("mem_port", MEM_SIZE);
+    mem_if(*_mem_port);
+
+    SC_THREAD(compute);
+    SC_THREAD(writeback);
+}
+
+bool mat_mult_at::receive_packet(uint64_t addr, uint64_t packet) {
+    if (_in_transport) return mat_mult::receive_packet(addr, packet);
+    host->write(addr, &packet, 1);
+    return true;
+}
+
+bool mat_mult_at::receive_packets(uint64_t addr, const uint64_t *packets, uint32_t n) {
+    if (_in_transport) return mat_mult::receive_packets(addr, packets, n);
+
+    // bursts within the wrapped payload window
+    for (uint32_t i = 0; i < n; i += AT_BURST_LEN) {
+        uint32_t len = n - i < AT_BURST_LEN ? n - i : AT_BURST_LEN;
+        host->write(BURST_ADDR(addr, i), packets + i, len);
+    }
+    return true;
+}
+
+void mat_mult_at::signal_ack() {
+    _mem_port->mark_interrupt();
+}
+
+void mat_mult_at::compute() {
+    uint64_t packets[AT_BURST_LEN];
+
+    while (true) {
+        while (!payload->count()) {
+            wait(payload->data_event());
+        }
+
+        // back-pressure from the output write path
+        if (_mem_port->pending() >= AT_OUT_BUF_SIZE) {
+            sc_time start = sc_time_stamp();
+            while (_mem_port->pending() >= AT_OUT_BUF_SIZE) {
+                wait(_mem_port->issue_event());
+            }
+            _out_stall_time += sc_time_stamp() - start;
+        }
+
+        // one packet per core cycle
+        uint32_t n = payload->peek(packets, AT_BURST_LEN);
+        wait(CC_CORE(n), SC_NS);
+        _compute_time += sc_time(CC_CORE(n), SC_NS);
+
+        _in_transport = true;
+        mat_mult::receive_packets(OFFSET_PAYLOAD, packets, n);
+        _in_transport = false;
+        payload->pop(n);
+    }
+}
+
+void mat_mult_at::writeback() {
+    std::deque<at_memory_port::at_write_t> &writes = _mem_port->writes();
+
+    while (true) {
+        while (writes.empty()) {
+            wait(_mem_port->write_event());
+        }
+        at_memory_port::at_write_t &w = writes.front();
+
+        uint32_t n = (uint32_t)w.data.size();
+        for (uint32_t i = 0; i < n; i += AT_BURST_LEN) {
+            uint32_t len = n - i < AT_BURST_LEN ? n - i : AT_BURST_LEN;
+            mem_master->write(w.addr + ((uint64_t)i << 3), w.data.data() + i, len);
+            _mem_port->issued(len);
+        }
+
+        // the interrupt follows the write response of the acknowledge packet
+        if (w.interrupt) {
+            mem_master->wait_idle();
+            cmd_if->raise_interrupt();
+        }
+        writes.pop_front();
+    }
+}
+
+void mat_mult_at::print_report() {
+    host->print_report();
+    payload->print_report();
+    mem_master->print_report();
+    std::cout << "Compute " << this->name() << ": busy for " << _compute_time << ", stalled by the output for " << _out_stall_time << std::endl;
+}
@@ -0,0 +1,175 @@
+
+#include "systemc.h"
+#include "tlm.h"
+
+#include "system.h"
+#include "memory_if.hpp"
+#include "tlm_at.h"
+#include "../0-appl/mat_mult.h"
+
+#include <deque>
+#include <vector>
+
+#ifndef MAT_MULT_AT_H
+#define MAT_MULT_AT_H
+
+// output packets buffered ahead of the write path before the computation stalls
+#define AT_OUT_BUF_SIZE 256
+
+/**
+ * @brief Input FIFO of the matrix multiplier as the payload target. A burst is
+ *        accepted once there is room for all its packets.
+ */
+class at_in_fifo : public at_target {
+
+    public:
+
+        /** Constructor. */
+        at_in_fifo(sc_module_name name);
+
+        /** Packets in the FIFO. */
+        uint32_t count() const { return _count; }
+
+        /** Copy up to `n` packets from the head of the FIFO, returns the number copied. */
+        uint32_t peek(uint64_t *packets, uint32_t n) const;
+
+        /** Drop `n` packets from the head of the FIFO. */
+        void pop(uint32_t n);
+
+        /** Notified when packets are pushed. */
+        const sc_event &data_event() const { return _data_event; }
+
+    private:
+
+        uint64_t _packets[IN_FIFO_BUF_SIZE];
+        uint32_t _head;
+        uint32_t _count;
+
+        /** Room reserved by the accepted bursts in their data phase. */
+        uint32_t _reserved;
+
+        sc_event _data_event;
+
+        /** at_target overrides. */
+        bool try_accept(tlm::tlm_generic_payload &trans);
+        void transfer(tlm::tlm_generic_payload &trans);
+
+};
+
+/**
+ * @brief Output write path of the matrix multiplier. The writes through `memory_if`
+ *        are buffered in order until they are issued on the memory socket.
+ */
+class at_memory_port : public sc_module, public memory_if<uint64_t> {
+
+    public:
+
+        /** Buffered write. */
+        struct at_write_t {
+            uint64_t addr;
+            std::vector<uint64_t> data;
+            bool interrupt; // raise the interrupt once the write is answered
+        };
+
+        /**
+         * @brief Constructor.
+         *
+         * @param name     SystemC module name.
+         * @param mem_size Number of bytes behind the port.
+         */
+        at_memory_port(sc_module_name name, uint64_t mem_size);
+
+        /** Buffered writes, oldest first. */
+        std::deque<at_write_t> &writes() { return _writes; }
+
+        /** Packets buffered and not yet issued. */
+        uint64_t pending() const { return _pending; }
+
+        /** Account for `n` packets issued. */
+        void issued(uint64_t n);
+
+        /** Raise the interrupt after the last buffered write. */
+        void mark_interrupt();
+
+        /** Notified when a write is buffered, or when packets are issued. */
+        const sc_event &write_event() const { return _write_event; }
+        const sc_event &issue_event() const { return _issue_event; }
+
+    private:
+
+        std::deque<at_write_t> _writes;
+        uint64_t _pending;
+        sc_event _write_event;
+        sc_event _issue_event;
+
+        /** memory_if overrides, the path only writes. */
+        bool do_read(uint64_t addr, uint64_t& data) { return false; }
+        bool do_write(uint64_t addr, uint64_t data);
+        bool do_write_block(uint64_t addr, const uint64_t *data, uint64_t n);
+
+};
+
+/**
+ * @brief Approximately-timed matrix multiplier. The command FSM and the computation
+ *        are the application-level ones, streaming rows. The command host writes the
+ *        packets in bursts to the input FIFO, the computation takes one packet per core
+ *        cycle from the FIFO, and the output rows are written back in bursts, so the
+ *        three stages overlap with several bursts in flight. A full input FIFO holds
+ *        the payload requests, and a full output buffer stalls the computation.
+ */
+class mat_mult_at : public mat_mult {
+
+    public:
+
+        /** Bus master of the command host, the payload target and the memory master. */
+        at_initiator *host;
+        at_in_fifo *payload;
+        at_initiator *mem_master;
+
+        SC_HAS_PROCESS(mat_mult_at);
+
+        /**
+         * @brief Constructor.
+         *
+         * @param name            SystemC module name.
+         * @param max_outstanding Bursts in flight per initiator.
+         */
+        mat_mult_at(sc_module_name name, uint32_t max_outstanding = AT_DEFAULT_OUTSTANDING);
+
+        /** Print the bandwidths and the stalls of each stage. */
+        void print_report();
+
+    protected:
+
+        /** Write a header packet to the input FIFO. */
+        bool receive_packet(uint64_t addr, uint64_t packet);
+
+        /** Write the payload to the input FIFO in bursts. */
+        bool receive_packets(uint64_t addr, const uint64_t *packets, uint32_t n);
+
+        /** Defer the interrupt until the acknowledge packet is written back. */
+        void signal_ack();
+
+        /** The FIFO is decoded in order, so the next command is written behind the payload. */
+        bool queues_input() const { return true; }
+
+    private:
+
+        at_memory_port *_mem_port;
+
+        /** Whether the packets are being received from the FIFO rather than delivered to it. */
+        bool _in_transport;
+
+        /** Statistics. */
+        sc_time _compute_time;
+        sc_time _out_stall_time;
+
+        /** Take the packets from the input FIFO. */
+        void compute();
+
+        /** Issue the buffered writes on the memory socket. */
+        void writeback();
+
+};
+
+#endif // MAT_MULT_AT_H
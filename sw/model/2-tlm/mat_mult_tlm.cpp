@@ -0,0 +1,121 @@
+
+#include "mat_mult_tlm.h"
+#include "system.h"
+#include "systemc.h"
+
+#include <iostream>
+
+mat_mult_tlm::mat_mult_tlm(sc_module_name name, tlm_memory_port *mem_port, uint32_t n_threads)
+    : mat_mult(name, n_threads, true), socket("socket"), host_socket("host_socket"), _mem_port(mem_port),
+      _in_transport(false), _ack_pending(false), _payload_read_delay(SC_ZERO_TIME), _n_transactions(0), _n_bytes(0)
+{
+    mem_if(*mem_port);
+    socket.register_b_transport(this, &mat_mult_tlm::b_transport);
+}
+
+bool mat_mult_tlm::receive_packet(uint64_t addr, uint64_t packet) {
+    if (_in_transport) return mat_mult::receive_packet(addr, packet);
+    return deliver(addr, &packet, 1);
+}
+
+bool mat_mult_tlm::receive_packets(uint64_t addr, const uint64_t *packets, uint32_t n) {
+    if (_in_transport) return mat_mult::receive_packets(addr, packets, n);
+    return deliver(addr, packets, n);
+}
+
+bool mat_mult_tlm::send_payload(uint8_t *ext_mem, uint64_t in_addr, uint32_t n) {
+    uint64_t n_bytes = n * sizeof(uint64_t);
+
+    // request the grant once, and again when the memory invalidated it, a refusal is kept until then
+    if (!_mem_port->dmi_current(_payload_dmi)) {
+        _payload_dmi = memory_dmi_t();
+        _mem_port->get_direct_mem_ptr(in_addr, _payload_dmi);
+    }
+
+    const uint64_t *packets;
+    if (_payload_dmi.read_allowed && _payload_dmi.covers(in_addr, n_bytes)) {
+        packets = (const uint64_t*)(_payload_dmi.ptr + (in_addr - _payload_dmi.start_addr));
+        _mem_port->count_dmi(in_addr, n, false);
+    }
+    else {
+        _payload_buf.resize(n);
+        _mem_port->read_block(in_addr, _payload_buf.data(), n);
+        packets = _payload_buf.data();
+    }
+
+    // the payload streams in as it is read, so the read overlaps the transaction
+    _payload_read_delay = _mem_port->take_delay();
+    return deliver(OFFSET_PAYLOAD, packets, n);
+}
+
+void mat_mult_tlm::signal_ack() {
+    _ack_pending = true;
+}
+
+bool mat_mult_tlm::deliver(uint64_t addr, const uint64_t *packets, uint32_t n) {
+    // the packets are passed in place, the target only reads the data of a write
+    tlm::tlm_generic_payload trans;
+    trans.set_command(tlm::TLM_WRITE_COMMAND);
+    trans.set_address(addr);
+    trans.set_data_ptr((unsigned char*)packets);
+    trans.set_data_length(n * sizeof(uint64_t));
+    trans.set_streaming_width(n * sizeof(uint64_t));
+    trans.set_byte_enable_ptr(nullptr);
+    trans.set_dmi_allowed(false);
+    trans.set_response_status(tlm::TLM_INCOMPLETE_RESPONSE);
+
+    sc_time delay = SC_ZERO_TIME;
+    host_socket->b_transport(trans, delay);
+    if (delay < _payload_read_delay) delay = _payload_read_delay;
+    _payload_read_delay = SC_ZERO_TIME;
+    _qk.inc(delay);
+
+    if (_ack_pending) {
+        // the command host observes the acknowledge once the transaction is over
+        _qk.sync();
+        _ack_pending = false;
+        cmd_if->raise_interrupt();
+    }
+    else if (_qk.need_sync()) {
+        _qk.sync();
+    }
+
+    return trans.is_response_ok();
+}
+
+void mat_mult_tlm::b_transport(tlm::tlm_generic_payload &trans, sc_time &delay) {
+    uint32_t n = trans.get_data_length() / sizeof(uint64_t);
+    if (!trans.is_write() || !n || trans.get_byte_enable_ptr()) {
+        trans.set_response_status(tlm::TLM_COMMAND_ERROR_RESPONSE);
+        return;
+    }
+
+    _in_transport = true;
+    if (n == 1) {
+        mat_mult::receive_packet(trans.get_address(), *(uint64_t*)trans.get_data_ptr());
+    }
+    else {
+        mat_mult::receive_packets(trans.get_address(), (const uint64_t*)trans.get_data_ptr(), n);
+    }
+    _in_transport = false;
+
+    // one packet per bus cycle in, decoded in a core cycle, while the output rows are
+    // written through the memory port
+    sc_time in_delay = sc_time(CC_MAIN(n), SC_NS) + sc_time(CC_CORE_NS, SC_NS);
+    sc_time out_delay = _mem_port->take_delay();
+    delay += in_delay > out_delay ? in_delay : out_delay;
+
+    // the last output row leaves the kernel pipeline after one core cycle per kernel row
+    if (_ack_pending) {
+        delay += sc_time(CC_CORE(_kern_dim), SC_NS);
+    }
+
+    _n_transactions++;
+    _n_bytes += trans.get_data_length();
+    trans.set_response_status(tlm::TLM_OK_RESPONSE);
+}
+
+void mat_mult_tlm::print_report() {
+    std::cout << "Transactions " << this->name() << ": " << _n_transactions << ", " << _n_bytes << " bytes" << std::endl;
+    _qk.print_report(this->name());
+}
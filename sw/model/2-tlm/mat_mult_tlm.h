@@ -0,0 +1,95 @@
+
+#include "systemc.h"
+#include "tlm.h"
+#include "tlm_utils/simple_target_socket.h"
+#include "tlm_utils/simple_initiator_socket.h"
+
+#include "system.h"
+#include "quantum_keeper.hpp"
+#include "tlm_memory.h"
+#include "../0-appl/mat_mult.h"
+
+#include <vector>
+
+#ifndef MAT_MULT_TLM_H
+#define MAT_MULT_TLM_H
+
+// default quantum of the command delivery, in AXI bus cycles
+#define TLM_DEFAULT_QUANTUM 1024
+
+/**
+ * @brief Loosely-timed matrix multiplier. The command FSM and the computation are
+ *        the application-level ones, streaming rows. The packets reach the module
+ *        through a TLM-2.0 socket, and each transaction is annotated with the time
+ *        the hardware takes to transfer it over the AXI bus, overlapped with the
+ *        output written through the memory port.
+ */
+class mat_mult_tlm : public mat_mult {
+
+    public:
+
+        /** Command and payload port. */
+        tlm_utils::simple_target_socket<mat_mult_tlm> socket;
+
+        /** Bus master delivering the posted commands, bound to `socket`. */
+        tlm_utils::simple_initiator_socket<mat_mult_tlm> host_socket;
+
+        /**
+         * @brief Constructor.
+         *
+         * @param name      SystemC module name.
+         * @param mem_port  Memory port, bound to `mem_if`.
+         * @param n_threads Number of host threads computing output bands.
+         */
+        mat_mult_tlm(sc_module_name name, tlm_memory_port *mem_port, uint32_t n_threads = 1);
+
+        /** Print the transactions and the synchronizations of the command delivery. */
+        void print_report();
+
+    protected:
+
+        /** Deliver a header packet through the socket. */
+        bool receive_packet(uint64_t addr, uint64_t packet);
+
+        /** Deliver the payload through the socket in a single transaction. */
+        bool receive_packets(uint64_t addr, const uint64_t *packets, uint32_t n);
+
+        /** Read the payload from the CPU memory through a DMI grant of the memory port, then deliver it. */
+        bool send_payload(uint8_t *ext_mem, uint64_t in_addr, uint32_t n);
+
+        /** Defer the interrupt until the simulation time reaches the end of the transaction. */
+        void signal_ack();
+
+    private:
+
+        tlm_memory_port *_mem_port;
+
+        /** Local time of the command delivery. */
+        quantum_keeper _qk;
+
+        /** Whether the packets are being received from the socket rather than delivered to it. */
+        bool _in_transport;
+
+        /** Acknowledge packet written, interrupt not yet raised. */
+        bool _ack_pending;
+
+        /** Grant of the memory port for the payload, with a buffer for the reads without it. */
+        memory_dmi_t _payload_dmi;
+        std::vector<uint64_t> _payload_buf;
+
+        /** Time to read the payload being delivered, which the transaction cannot beat. */
+        sc_time _payload_read_delay;
+
+        /** Statistics. */
+        uint64_t _n_transactions;
+        uint64_t _n_bytes;
+
+        /** Issue a write of `n` packets to `socket`, then synchronize as needed. */
+        bool deliver(uint64_t addr, const uint64_t *packets, uint32_t n);
+
+        /** Target side of `socket`. */
+        void b_transport(tlm::tlm_generic_payload &trans, sc_time &delay);
+
+};
+
+#endif // MAT_MULT_TLM_H
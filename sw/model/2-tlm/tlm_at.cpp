@@ -0,0 +1,194 @@
+
+#include "tlm_at.h"
+#include "system.h"
+
+#include <iostream>
+#include <string.h>
+
+at_target::at_target(sc_module_name name)
+    : sc_module(name), socket("socket"), _n_held(0), _held_time(SC_ZERO_TIME)
+{
+    socket.register_nb_transport_fw(this, &at_target::nb_transport_fw);
+    socket.register_b_transport(this, &at_target::b_transport);
+    socket.register_get_direct_mem_ptr(this, &at_target::get_direct_mem_ptr);
+    socket.register_transport_dbg(this, &at_target::transport_dbg);
+
+    SC_THREAD(req_thread);
+    SC_THREAD(data_thread);
+}
+
+tlm::tlm_sync_enum at_target::nb_transport_fw(tlm::tlm_generic_payload &trans, tlm::tlm_phase &phase, sc_time &delay) {
+    if (phase == tlm::BEGIN_REQ) {
+        _req_queue.push_back(&trans);
+        _req_event.notify(delay);
+        return tlm::TLM_ACCEPTED;
+    }
+
+    // END_RESP, the transaction is over
+    return tlm::TLM_COMPLETED;
+}
+
+void at_target::req_thread() {
+    while (true) {
+        while (_req_queue.empty()) {
+            wait(_req_event);
+        }
+        tlm::tlm_generic_payload *trans = _req_queue.front();
+
+        // back-pressure until there is room for the request
+        if (!try_accept(*trans)) {
+            sc_time start = sc_time_stamp();
+            _n_held++;
+            do {
+                wait(_space_event);
+            } while (!try_accept(*trans));
+            _held_time += sc_time_stamp() - start;
+        }
+
+        // address handshake
+        POS_MAIN();
+        _req_queue.pop_front();
+
+        tlm::tlm_phase phase = tlm::END_REQ;
+        sc_time delay = SC_ZERO_TIME;
+        socket->nb_transport_bw(*trans, phase, delay);
+
+        _data_queue.push_back(trans);
+        _data_event.notify(SC_ZERO_TIME);
+    }
+}
+
+void at_target::data_thread() {
+    while (true) {
+        while (_data_queue.empty()) {
+            wait(_data_event);
+        }
+        tlm::tlm_generic_payload *trans = _data_queue.front();
+
+        // one beat per bus cycle
+        uint32_t beats = (trans->get_data_length() + sizeof(uint64_t) - 1) / sizeof(uint64_t);
+        wait(sc_time(CC_MAIN(beats), SC_NS));
+        transfer(*trans);
+        _data_queue.pop_front();
+
+        tlm::tlm_phase phase = tlm::BEGIN_RESP;
+        sc_time delay = SC_ZERO_TIME;
+        socket->nb_transport_bw(*trans, phase, delay);
+    }
+}
+
+void at_target::print_report() {
+    std::cout << "Target " << this->name() << ": " << _n_held << " requests held by back-pressure for " << _held_time << std::endl;
+}
+
+at_initiator::at_initiator(sc_module_name name, uint32_t max_outstanding)
+    : sc_module(name), socket("socket"), _bursts(max_outstanding), _req_trans(nullptr),
+      _n_bursts(0), _n_bytes(0), _max_in_flight(0), _first_req(SC_ZERO_TIME), _last_resp(SC_ZERO_TIME), _stall_time(SC_ZERO_TIME)
+{
+    for (uint32_t i = 0; i < max_outstanding; i++) {
+        _free.push_back(&_bursts[i]);
+    }
+
+    socket.register_nb_transport_bw(this, &at_initiator::nb_transport_bw);
+}
+
+void at_initiator::write(uint64_t addr, const uint64_t *packets, uint32_t n) {
+    for (uint32_t i = 0; i < n; i += AT_BURST_LEN) {
+        uint32_t len = n - i < AT_BURST_LEN ? n - i : AT_BURST_LEN;
+        write_burst(addr + ((uint64_t)i << 3), packets + i, len);
+    }
+}
+
+void at_initiator::write_burst(uint64_t addr, const uint64_t *packets, uint32_t n) {
+    // wait for the request channel and a burst slot
+    sc_time start = sc_time_stamp();
+    while (_req_trans || _free.empty()) {
+        wait(_phase_event);
+    }
+    _stall_time += sc_time_stamp() - start;
+
+    at_burst_t *burst = _free.back();
+    _free.pop_back();
+    memcpy(burst->data, packets, n * sizeof(uint64_t));
+
+    tlm::tlm_generic_payload &trans = burst->trans;
+    trans.set_command(tlm::TLM_WRITE_COMMAND);
+    trans.set_address(addr);
+    trans.set_data_ptr((unsigned char*)burst->data);
+    trans.set_data_length(n * sizeof(uint64_t));
+    trans.set_streaming_width(n * sizeof(uint64_t));
+    trans.set_byte_enable_ptr(nullptr);
+    trans.set_dmi_allowed(false);
+    trans.set_response_status(tlm::TLM_INCOMPLETE_RESPONSE);
+
+    // statistics
+    if (!_n_bursts) _first_req = sc_time_stamp();
+    _n_bursts++;
+    _n_bytes += n * sizeof(uint64_t);
+    uint32_t in_flight = (uint32_t)(_bursts.size() - _free.size());
+    if (in_flight > _max_in_flight) _max_in_flight = in_flight;
+
+    _req_trans = &trans;
+    tlm::tlm_phase phase = tlm::BEGIN_REQ;
+    sc_time delay = SC_ZERO_TIME;
+    tlm::tlm_sync_enum status = socket->nb_transport_fw(trans, phase, delay);
+    if (status == tlm::TLM_COMPLETED) {
+        wait(delay);
+        _req_trans = nullptr;
+        complete(trans);
+    }
+    else if (status == tlm::TLM_UPDATED && phase == tlm::END_REQ) {
+        wait(delay);
+        _req_trans = nullptr;
+    }
+
+    // return once the request is accepted
+    while (_req_trans) {
+        wait(_phase_event);
+    }
+}
+
+void at_initiator::wait_idle() {
+    while (_free.size() < _bursts.size()) {
+        wait(_phase_event);
+    }
+}
+
+tlm::tlm_sync_enum at_initiator::nb_transport_bw(tlm::tlm_generic_payload &trans, tlm::tlm_phase &phase, sc_time &delay) {
+    if (phase == tlm::END_REQ) {
+        if (&trans == _req_trans) _req_trans = nullptr;
+        _phase_event.notify(delay);
+        return tlm::TLM_ACCEPTED;
+    }
+
+    // BEGIN_RESP, an implicit END_REQ if it answers the pending request, the response of an earlier burst leaves it pending
+    if (phase == tlm::BEGIN_RESP) {
+        if (trans.is_response_error()) {
+            LOG_ERROR(this->name(), "Write to %08llx failed", (unsigned long long)trans.get_address());
+        }
+        if (&trans == _req_trans) _req_trans = nullptr;
+        complete(trans);
+        _phase_event.notify(delay);
+    }
+    return tlm::TLM_COMPLETED;
+}
+
+void at_initiator::complete(tlm::tlm_generic_payload &trans) {
+    for (at_burst_t &burst : _bursts) {
+        if (&burst.trans == &trans) {
+            _free.push_back(&burst);
+            break;
+        }
+    }
+    _last_resp = sc_time_stamp();
+}
+
+void at_initiator::print_report() {
+    double elapsed_s = (_last_resp - _first_req).to_seconds();
+    double bandwidth = elapsed_s > 0 ? _n_bytes / elapsed_s : 0.0;
+
+    std::cout << "Initiator " << this->name() << ": " << _n_bursts << " bursts, " << _n_bytes << " bytes in " << (_last_resp - _first_req)
+              << ", at most " << _max_in_flight << " in flight, stalled for " << _stall_time << std::endl;
+    printf("Initiator %s: %.1f MB/s of %.1f MB/s AXI capacity (%.1f%%)\n", this->name(),
+        bandwidth * 1e-6, AXI_BYTES_PER_S * 1e-6, 100.0 * bandwidth / AXI_BYTES_PER_S);
+}
@@ -0,0 +1,172 @@
+
+#include "systemc.h"
+#include "tlm.h"
+#include "tlm_utils/simple_target_socket.h"
+#include "tlm_utils/simple_initiator_socket.h"
+
+#include "system.h"
+#include "mat_mult_if.h"
+
+#include <deque>
+#include <vector>
+
+#ifndef TLM_AT_H
+#define TLM_AT_H
+
+// beats in a burst, the size of the wrapped payload window
+#define AT_BURST_LEN (SIZE_PAYLOAD / sizeof(uint64_t))
+
+// default bursts in flight per initiator
+#define AT_DEFAULT_OUTSTANDING 4
+#define AT_MAX_OUTSTANDING 16
+
+// AXI bus capacity, one 64-bit beat per bus cycle, in bytes per second
+#define AXI_BYTES_PER_S (sizeof(uint64_t) / (CC_MAIN_NS * 1e-9))
+
+/**
+ * @brief Approximately-timed target with the two stages of an AXI write slave. A
+ *        request (BEGIN_REQ) is accepted (END_REQ) in order, after a bus cycle for the
+ *        address, once the subclass has room for it. The data beats of the accepted
+ *        requests then follow one per bus cycle, and the response (BEGIN_RESP) is sent
+ *        after the last beat. Requests that cannot be accepted back-pressure the
+ *        initiator, which cannot issue another request until END_REQ.
+ */
+class at_target : public sc_module {
+
+    public:
+
+        tlm_utils::simple_target_socket<at_target> socket;
+
+        SC_HAS_PROCESS(at_target);
+
+        /**
+         * @brief Constructor.
+         *
+         * @param name SystemC module name.
+         */
+        at_target(sc_module_name name);
+
+        /** Print how long the requests were held by back-pressure. */
+        void print_report();
+
+    protected:
+
+        /**
+         * @brief Reserve room for a request before it is accepted.
+         *
+         * @retval Whether the request is accepted, otherwise it is held until `notify_space`.
+         */
+        virtual bool try_accept(tlm::tlm_generic_payload &trans) { return true; }
+
+        /** Move the data of a transaction once all its beats are transferred. */
+        virtual void transfer(tlm::tlm_generic_payload &trans) = 0;
+
+        /** Blocking transport, not supported unless the subclass overrides it. */
+        virtual void b_transport(tlm::tlm_generic_payload &trans, sc_time &delay) {
+            trans.set_response_status(tlm::TLM_COMMAND_ERROR_RESPONSE);
+        }
+
+        /** Direct memory interface, not granted unless the subclass overrides it. */
+        virtual bool get_direct_mem_ptr(tlm::tlm_generic_payload &trans, tlm::tlm_dmi &dmi) { return false; }
+
+        /** Debug transport, not supported unless the subclass overrides it. */
+        virtual unsigned int transport_dbg(tlm::tlm_generic_payload &trans) { return 0; }
+
+        /** Retry the held request, after room is freed. */
+        void notify_space() { _space_event.notify(SC_ZERO_TIME); }
+
+    private:
+
+        /** Requests not yet accepted, and accepted requests in their data phase. */
+        std::deque<tlm::tlm_generic_payload*> _req_queue;
+        std::deque<tlm::tlm_generic_payload*> _data_queue;
+        sc_event _req_event;
+        sc_event _data_event;
+        sc_event _space_event;
+
+        /** Statistics. */
+        uint64_t _n_held;
+        sc_time _held_time;
+
+        /** Forward path, queues the requests. */
+        tlm::tlm_sync_enum nb_transport_fw(tlm::tlm_generic_payload &trans, tlm::tlm_phase &phase, sc_time &delay);
+
+        /** Accept the requests in order. */
+        void req_thread();
+
+        /** Transfer the data beats and respond in order. */
+        void data_thread();
+
+};
+
+/**
+ * @brief Approximately-timed initiator of an AXI write master. Issues bursts with
+ *        BEGIN_REQ, one request at a time until END_REQ, with up to a number of
+ *        bursts in flight until their BEGIN_RESP. Measures the achieved bandwidth.
+ */
+class at_initiator : public sc_module {
+
+    public:
+
+        tlm_utils::simple_initiator_socket<at_initiator> socket;
+
+        /**
+         * @brief Constructor.
+         *
+         * @param name            SystemC module name.
+         * @param max_outstanding Bursts in flight, at most AT_MAX_OUTSTANDING.
+         */
+        at_initiator(sc_module_name name, uint32_t max_outstanding = AT_DEFAULT_OUTSTANDING);
+
+        /**
+         * @brief Write consecutive packets, in bursts of at most AT_BURST_LEN packets at
+         *        consecutive addresses. The data is copied, and the call returns once the
+         *        request of the last burst is accepted. Called from a thread.
+         *
+         * @param addr    Address of the first packet.
+         * @param packets Packets to write.
+         * @param n       Number of packets.
+         */
+        void write(uint64_t addr, const uint64_t *packets, uint32_t n);
+
+        /** Wait until all the bursts in flight are answered. Called from a thread. */
+        void wait_idle();
+
+        /** Print the achieved bandwidth against the AXI bus capacity. */
+        void print_report();
+
+    private:
+
+        /** Burst in flight with its own copy of the data. */
+        struct at_burst_t {
+            tlm::tlm_generic_payload trans;
+            uint64_t data[AT_BURST_LEN];
+        };
+
+        std::vector<at_burst_t> _bursts;
+        std::vector<at_burst_t*> _free;
+
+        /** Request in progress until its END_REQ, or the BEGIN_RESP of the same transaction, null if none. */
+        tlm::tlm_generic_payload *_req_trans;
+        sc_event _phase_event;
+
+        /** Statistics. */
+        uint64_t _n_bursts;
+        uint64_t _n_bytes;
+        uint32_t _max_in_flight;
+        sc_time _first_req;
+        sc_time _last_resp;
+        sc_time _stall_time;
+
+        /** Backward path, END_REQ and BEGIN_RESP. */
+        tlm::tlm_sync_enum nb_transport_bw(tlm::tlm_generic_payload &trans, tlm::tlm_phase &phase, sc_time &delay);
+
+        /** Issue a burst of at most AT_BURST_LEN packets. */
+        void write_burst(uint64_t addr, const uint64_t *packets, uint32_t n);
+
+        /** Release a burst once answered. */
+        void complete(tlm::tlm_generic_payload &trans);
+
+};
+
+#endif // TLM_AT_H
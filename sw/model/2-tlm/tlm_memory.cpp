@@ -0,0 +1,135 @@
+
+#include "tlm_memory.h"
+#include "system.h"
+
+#include <string.h>
+
+tlm_memory::tlm_memory(sc_module_name name, uint8_t *memory, uint64_t mem_size)
+    : at_target(name), _memory(memory), _mem_size(mem_size)
+{
+}
+
+unsigned int tlm_memory::access(tlm::tlm_generic_payload &trans) {
+    uint64_t addr = trans.get_address();
+    unsigned int len = trans.get_data_length();
+
+    // byte enables and streaming are not supported
+    if (trans.get_byte_enable_ptr() || trans.get_streaming_width() < len) {
+        trans.set_response_status(tlm::TLM_BYTE_ENABLE_ERROR_RESPONSE);
+        return 0;
+    }
+    if (addr >= _mem_size || len > _mem_size - addr) {
+        trans.set_response_status(tlm::TLM_ADDRESS_ERROR_RESPONSE);
+        return 0;
+    }
+
+    if (trans.is_read()) {
+        memcpy(trans.get_data_ptr(), _memory + addr, len);
+    }
+    else if (trans.is_write()) {
+        memcpy(_memory + addr, trans.get_data_ptr(), len);
+    }
+    trans.set_response_status(tlm::TLM_OK_RESPONSE);
+    return len;
+}
+
+void tlm_memory::b_transport(tlm::tlm_generic_payload &trans, sc_time &delay) {
+    unsigned int len = access(trans);
+
+    // one beat per bus cycle
+    delay += TLM_BEAT_DELAY * (double)((len + TLM_BEAT_BYTES - 1) / TLM_BEAT_BYTES);
+    trans.set_dmi_allowed(true);
+}
+
+bool tlm_memory::get_direct_mem_ptr(tlm::tlm_generic_payload &trans, tlm::tlm_dmi &dmi) {
+    dmi.set_dmi_ptr(_memory);
+    dmi.set_start_address(0);
+    dmi.set_end_address(_mem_size - 1);
+    dmi.allow_read_write();
+
+    // latencies per 64-bit word
+    dmi.set_read_latency(TLM_BEAT_DELAY);
+    dmi.set_write_latency(TLM_BEAT_DELAY);
+    return true;
+}
+
+void tlm_memory::transfer(tlm::tlm_generic_payload &trans) {
+    access(trans);
+}
+
+unsigned int tlm_memory::transport_dbg(tlm::tlm_generic_payload &trans) {
+    return access(trans);
+}
+
+tlm_memory_port::tlm_memory_port(sc_module_name name, uint64_t mem_size)
+    : sc_module(name), memory_if<uint64_t>(name, mem_size), socket("socket"), _delay(SC_ZERO_TIME)
+{
+    // byte addresses
+    _addr_step = sizeof(uint64_t);
+
+    socket.register_invalidate_direct_mem_ptr(this, &tlm_memory_port::invalidate_direct_mem_ptr);
+}
+
+sc_time tlm_memory_port::take_delay() {
+    sc_time delay = _delay;
+    _delay = SC_ZERO_TIME;
+    return delay;
+}
+
+bool tlm_memory_port::transport(tlm::tlm_command cmd, uint64_t addr, uint64_t *data, uint64_t n) {
+    tlm::tlm_generic_payload trans;
+    trans.set_command(cmd);
+    trans.set_address(addr);
+    trans.set_data_ptr((unsigned char*)data);
+    trans.set_data_length((unsigned int)(n * sizeof(uint64_t)));
+    trans.set_streaming_width((unsigned int)(n * sizeof(uint64_t)));
+    trans.set_byte_enable_ptr(nullptr);
+    trans.set_dmi_allowed(false);
+    trans.set_response_status(tlm::TLM_INCOMPLETE_RESPONSE);
+
+    socket->b_transport(trans, _delay);
+    return trans.is_response_ok();
+}
+
+bool tlm_memory_port::do_read(uint64_t addr, uint64_t& data) {
+    return transport(tlm::TLM_READ_COMMAND, addr, &data, 1);
+}
+
+bool tlm_memory_port::do_write(uint64_t addr, uint64_t data) {
+    return transport(tlm::TLM_WRITE_COMMAND, addr, &data, 1);
+}
+
+bool tlm_memory_port::do_read_block(uint64_t addr, uint64_t *data, uint64_t n) {
+    return transport(tlm::TLM_READ_COMMAND, addr, data, n);
+}
+
+bool tlm_memory_port::do_write_block(uint64_t addr, const uint64_t *data, uint64_t n) {
+    // the target only reads the data of a write
+    return transport(tlm::TLM_WRITE_COMMAND, addr, (uint64_t*)data, n);
+}
+
+bool tlm_memory_port::do_get_direct_mem_ptr(uint64_t addr, memory_dmi_t &dmi) {
+    tlm::tlm_generic_payload trans;
+    tlm::tlm_dmi tlm_dmi;
+    trans.set_command(tlm::TLM_READ_COMMAND);
+    trans.set_address(addr);
+
+    if (!socket->get_direct_mem_ptr(trans, tlm_dmi)) return false;
+
+    dmi.ptr = tlm_dmi.get_dmi_ptr();
+    dmi.start_addr = tlm_dmi.get_start_address();
+    dmi.end_addr = tlm_dmi.get_end_address();
+    dmi.read_allowed = tlm_dmi.is_read_allowed();
+    dmi.write_allowed = tlm_dmi.is_write_allowed();
+    _dmi_read_latency = tlm_dmi.get_read_latency();
+    _dmi_write_latency = tlm_dmi.get_write_latency();
+    return true;
+}
+
+void tlm_memory_port::dmi_accessed(uint64_t addr, uint64_t n, bool is_write) {
+    _delay += (is_write ? _dmi_write_latency : _dmi_read_latency) * (double)n;
+}
+
+void tlm_memory_port::invalidate_direct_mem_ptr(sc_dt::uint64 start_range, sc_dt::uint64 end_range) {
+    invalidate_dmi();
+}
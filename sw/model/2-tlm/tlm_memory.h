@@ -0,0 +1,105 @@
+
+#include "systemc.h"
+#include "tlm.h"
+#include "tlm_utils/simple_target_socket.h"
+#include "tlm_utils/simple_initiator_socket.h"
+
+#include "system.h"
+#include "memory_if.hpp"
+#include "tlm_at.h"
+
+#ifndef TLM_MEMORY_H
+#define TLM_MEMORY_H
+
+// the memory transfers one 64-bit beat per AXI bus cycle
+#define TLM_BEAT_BYTES 8
+#define TLM_BEAT_DELAY sc_time(CC_MAIN_NS, SC_NS)
+
+/**
+ * @brief CPU memory as a TLM-2.0 target. Blocking transactions are annotated with
+ *        one AXI bus cycle per 64-bit beat, and the whole memory is granted for DMI.
+ *        The non-blocking transactions go through the phases of `at_target`.
+ */
+class tlm_memory : public at_target {
+
+    public:
+
+        /**
+         * @brief Constructor.
+         *
+         * @param name     SystemC module name.
+         * @param memory   Backing storage.
+         * @param mem_size Number of bytes.
+         */
+        tlm_memory(sc_module_name name, uint8_t *memory, uint64_t mem_size);
+
+    private:
+
+        uint8_t *_memory;
+        uint64_t _mem_size;
+
+        /** Blocking transport, reads and writes of any length within the memory. */
+        void b_transport(tlm::tlm_generic_payload &trans, sc_time &delay);
+
+        /** Grant the whole memory. */
+        bool get_direct_mem_ptr(tlm::tlm_generic_payload &trans, tlm::tlm_dmi &dmi);
+
+        /** Debug transport, without delays. */
+        unsigned int transport_dbg(tlm::tlm_generic_payload &trans);
+
+        /** at_target override, copies the data after the beats. */
+        void transfer(tlm::tlm_generic_payload &trans);
+
+        /** Copy the data of a transaction, returns the number of bytes or 0 if it is out of range. */
+        unsigned int access(tlm::tlm_generic_payload &trans);
+
+};
+
+/**
+ * @brief Memory interface of the models over a TLM-2.0 initiator socket. The
+ *        delays annotated by the target, including the DMI latencies of the
+ *        direct accesses, are accumulated until the model takes them.
+ */
+class tlm_memory_port : public sc_module, public memory_if<uint64_t> {
+
+    public:
+
+        tlm_utils::simple_initiator_socket<tlm_memory_port> socket;
+
+        /**
+         * @brief Constructor.
+         *
+         * @param name     SystemC module name.
+         * @param mem_size Number of bytes behind the socket.
+         */
+        tlm_memory_port(sc_module_name name, uint64_t mem_size);
+
+        /** Return the delay of the accesses since the last call, and clear it. */
+        sc_time take_delay();
+
+    private:
+
+        /** Accumulated delay. */
+        sc_time _delay;
+
+        /** Latencies of the current grant, per 64-bit word. */
+        sc_time _dmi_read_latency;
+        sc_time _dmi_write_latency;
+
+        /** memory_if overrides. */
+        bool do_read(uint64_t addr, uint64_t& data);
+        bool do_write(uint64_t addr, uint64_t data);
+        bool do_read_block(uint64_t addr, uint64_t *data, uint64_t n);
+        bool do_write_block(uint64_t addr, const uint64_t *data, uint64_t n);
+        bool do_get_direct_mem_ptr(uint64_t addr, memory_dmi_t &dmi);
+        void dmi_accessed(uint64_t addr, uint64_t n, bool is_write);
+
+        /** Issue a blocking transaction of `n` words. */
+        bool transport(tlm::tlm_command cmd, uint64_t addr, uint64_t *data, uint64_t n);
+
+        /** Backward path, drops the grants. */
+        void invalidate_direct_mem_ptr(sc_dt::uint64 start_range, sc_dt::uint64 end_range);
+
+};
+
+#endif // TLM_MEMORY_H
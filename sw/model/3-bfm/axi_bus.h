@@ -0,0 +1,85 @@
+
+#include "systemc.h"
+#include "system.h"
+#include "sc_trace.hpp"
+
+#include <string>
+
+#ifndef AXI_BUS_H
+#define AXI_BUS_H
+
+// burst constraints
+#define AXI_MAX_BURST_LEN 256 // beats, AXI4 INCR bursts
+#define AXI_BOUNDARY 4096     // bursts do not cross a 4KB boundary
+#define AXI_BEAT_BYTES 8      // 64-bit data bus
+
+// transaction IDs
+#define AXI_MAX_OUTSTANDING 16
+
+// write responses
+#define AXI_RESP_OKAY   0x0
+#define AXI_RESP_SLVERR 0x2
+
+// bus capacity, one beat per bus cycle, in bytes per second
+#define AXI_BYTES_PER_S (AXI_BEAT_BYTES / (CC_MAIN_NS * 1e-9))
+
+/**
+ * @brief Write channels of an AXI4 interface, clocked at CC_MAIN_NS. A transfer
+ *        takes place on a rising edge where both VALID and READY were high, and
+ *        both sides sample the signals written on the previous edge.
+ *
+ *        The read channels are left out, as the command host and the matrix
+ *        multiplier only write.
+ */
+struct axi_write_bus_t {
+
+    // write address channel
+    sc_signal<sc_logic> awvalid;
+    sc_signal<sc_logic> awready;
+    sc_signal<uint32_t> awid;
+    sc_signal<uint64_t> awaddr;
+    sc_signal<uint32_t> awlen; // beats - 1
+
+    // write data channel
+    sc_signal<sc_logic> wvalid;
+    sc_signal<sc_logic> wready;
+    sc_signal<sc_logic> wlast;
+    sc_signal<uint64_t> wdata;
+
+    // write response channel
+    sc_signal<sc_logic> bvalid;
+    sc_signal<sc_logic> bready;
+    sc_signal<uint32_t> bid;
+    sc_signal<uint32_t> bresp;
+
+    /** Constructor, the signals are prefixed with `name` so they are unique at the top level. */
+    axi_write_bus_t(const std::string &name)
+        : awvalid((name + "_awvalid").c_str()), awready((name + "_awready").c_str()), awid((name + "_awid").c_str()),
+          awaddr((name + "_awaddr").c_str()), awlen((name + "_awlen").c_str()),
+          wvalid((name + "_wvalid").c_str()), wready((name + "_wready").c_str()), wlast((name + "_wlast").c_str()),
+          wdata((name + "_wdata").c_str()),
+          bvalid((name + "_bvalid").c_str()), bready((name + "_bready").c_str()), bid((name + "_bid").c_str()),
+          bresp((name + "_bresp").c_str())
+    {
+    }
+
+    /** Trace the signals under `name`. */
+    void trace(const char *name) {
+        sc_tracer::trace(awvalid, name, "awvalid");
+        sc_tracer::trace(awready, name, "awready");
+        sc_tracer::trace(awid, name, "awid");
+        sc_tracer::trace(awaddr, name, "awaddr");
+        sc_tracer::trace(awlen, name, "awlen");
+        sc_tracer::trace(wvalid, name, "wvalid");
+        sc_tracer::trace(wready, name, "wready");
+        sc_tracer::trace(wlast, name, "wlast");
+        sc_tracer::trace(wdata, name, "wdata");
+        sc_tracer::trace(bvalid, name, "bvalid");
+        sc_tracer::trace(bready, name, "bready");
+        sc_tracer::trace(bid, name, "bid");
+        sc_tracer::trace(bresp, name, "bresp");
+    }
+
+};
+
+#endif // AXI_BUS_H
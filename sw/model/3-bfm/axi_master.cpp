@@ -0,0 +1,170 @@
+
+#include "axi_master.h"
+#include "system.h"
+
+#include <iostream>
+
+axi_master::axi_master(sc_module_name name, axi_write_bus_t &bus, uint32_t max_burst, uint32_t max_outstanding)
+    : sc_module(name), _bus(bus), _max_burst(max_burst), _max_outstanding(max_outstanding),
+      _n_addressed(0), _beat(0), _pending(0), _n_queued(0), _n_outstanding(0), _n_notified(0),
+      _n_bursts(0), _n_beats(0), _n_errors(0), _aw_stall(0), _w_stall(0), _id_stall(0), _max_in_flight(0),
+      _sum_latency(SC_ZERO_TIME), _first_time(SC_ZERO_TIME), _last_time(SC_ZERO_TIME)
+{
+    for (uint32_t i = 0; i < AXI_MAX_OUTSTANDING; i++) {
+        _id_busy[i] = false;
+        _id_seq[i] = 0;
+    }
+
+    _bus.awvalid.write(SC_LOGIC_0);
+    _bus.wvalid.write(SC_LOGIC_0);
+    _bus.wlast.write(SC_LOGIC_0);
+    _bus.bready.write(SC_LOGIC_1);
+
+    SC_THREAD(main);
+}
+
+void axi_master::write(uint64_t addr, const uint64_t *data, uint64_t n) {
+    while (n) {
+        // up to the burst length, without crossing a 4KB boundary
+        uint64_t len = (AXI_BOUNDARY - (addr & (AXI_BOUNDARY - 1))) / AXI_BEAT_BYTES;
+        if (len > _max_burst) len = _max_burst;
+        if (len > n) len = n;
+
+        _bursts.push_back({ addr, std::vector<uint64_t>(data, data + len), _n_queued++, -1, SC_ZERO_TIME });
+        _pending += len;
+
+        addr += len * AXI_BEAT_BYTES;
+        data += len;
+        n -= len;
+    }
+}
+
+void axi_master::notify_last() {
+    _notify_at.push_back(_n_queued);
+    check_notify();
+}
+
+void axi_master::check_notify() {
+    // oldest burst not answered yet, the responses of different IDs may come in any order
+    uint64_t oldest = _bursts.empty() ? _n_queued : _bursts.front().seq;
+    for (uint32_t i = 0; i < _max_outstanding; i++) {
+        if (_id_busy[i] && _id_seq[i] < oldest) oldest = _id_seq[i];
+    }
+
+    while (!_notify_at.empty() && _notify_at.front() <= oldest) {
+        _notify_at.pop_front();
+        _n_notified++;
+        _progress_event.notify(SC_ZERO_TIME);
+    }
+}
+
+int32_t axi_master::alloc_id() {
+    for (uint32_t i = 0; i < _max_outstanding; i++) {
+        if (!_id_busy[i]) return (int32_t)i;
+    }
+    return -1;
+}
+
+void axi_master::main() {
+    while (true) {
+        POS_MAIN();
+
+        // address transfer
+        if (_bus.awvalid.read() == SC_LOGIC_1) {
+            if (_bus.awready.read() == SC_LOGIC_1) _n_addressed++;
+            else _aw_stall++;
+        }
+
+        // data transfer, the bursts are removed after their last beat
+        if (_bus.wvalid.read() == SC_LOGIC_1) {
+            if (_bus.wready.read() == SC_LOGIC_1) {
+                _beat++;
+                _pending--;
+                _n_beats++;
+                if (_beat == _bursts.front().data.size()) {
+                    _bursts.pop_front();
+                    _n_addressed--;
+                    _beat = 0;
+                }
+                _progress_event.notify(SC_ZERO_TIME);
+            }
+            else {
+                _w_stall++;
+            }
+        }
+
+        // write response, frees the ID
+        if (_bus.bvalid.read() == SC_LOGIC_1 && _bus.bready.read() == SC_LOGIC_1) {
+            uint32_t id = _bus.bid.read();
+            if (_bus.bresp.read() != AXI_RESP_OKAY) {
+                LOG_ERROR(this->name(), "Write response %d for ID %d", _bus.bresp.read(), id);
+                _n_errors++;
+            }
+            _sum_latency += sc_time_stamp() - _id_start[id];
+            _last_time = sc_time_stamp();
+            _id_busy[id] = false;
+            _n_outstanding--;
+            _progress_event.notify(SC_ZERO_TIME);
+            check_notify();
+        }
+
+        // drive the address of the next burst once it has an ID
+        if (_n_addressed < _bursts.size()) {
+            axi_burst_t &burst = _bursts[_n_addressed];
+            if (burst.id < 0) {
+                burst.id = alloc_id();
+                if (burst.id >= 0) {
+                    _id_busy[burst.id] = true;
+                    _id_seq[burst.id] = burst.seq;
+                    _id_start[burst.id] = sc_time_stamp();
+                    if (!_n_bursts) _first_time = sc_time_stamp();
+                    _n_bursts++;
+                    _n_outstanding++;
+                    if (_n_outstanding > _max_in_flight) _max_in_flight = _n_outstanding;
+                }
+            }
+
+            if (burst.id >= 0) {
+                _bus.awvalid.write(SC_LOGIC_1);
+                _bus.awid.write((uint32_t)burst.id);
+                _bus.awaddr.write(burst.addr);
+                _bus.awlen.write((uint32_t)burst.data.size() - 1);
+            }
+            else {
+                _bus.awvalid.write(SC_LOGIC_0);
+                _id_stall++;
+            }
+        }
+        else {
+            _bus.awvalid.write(SC_LOGIC_0);
+        }
+
+        // drive the next beat of the first addressed burst
+        if (_n_addressed) {
+            axi_burst_t &burst = _bursts.front();
+            _bus.wvalid.write(SC_LOGIC_1);
+            _bus.wdata.write(burst.data[_beat]);
+            _bus.wlast.write(_beat + 1 == burst.data.size() ? SC_LOGIC_1 : SC_LOGIC_0);
+        }
+        else {
+            _bus.wvalid.write(SC_LOGIC_0);
+            _bus.wlast.write(SC_LOGIC_0);
+        }
+    }
+}
+
+void axi_master::print_report() {
+    double elapsed_s = (_last_time - _first_time).to_seconds();
+    double bandwidth = elapsed_s > 0 ? _n_beats * AXI_BEAT_BYTES / elapsed_s : 0.0;
+
+    std::cout << "AXI master " << this->name() << ": " << _n_bursts << " bursts of at most " << _max_burst << " beats, "
+              << _n_beats << " beats, " << _n_errors << " errors, at most " << _max_in_flight << " of " << _max_outstanding << " IDs in flight" << std::endl;
+    std::cout << "AXI master " << this->name() << ": stalled " << _aw_stall << " cycles on the address, " << _w_stall << " on the data, "
+              << _id_stall << " waiting for an ID";
+    if (_n_bursts) {
+        std::cout << ", " << (_sum_latency / (double)_n_bursts) << " from address to response on average";
+    }
+    std::cout << std::endl;
+    printf("AXI master %s: %.1f MB/s of %.1f MB/s bus capacity (%.1f%%)\n", this->name(),
+        bandwidth * 1e-6, AXI_BYTES_PER_S * 1e-6, 100.0 * bandwidth / AXI_BYTES_PER_S);
+}
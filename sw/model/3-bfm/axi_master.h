@@ -0,0 +1,115 @@
+
+#include "systemc.h"
+#include "system.h"
+#include "axi_bus.h"
+
+#include <deque>
+#include <vector>
+
+#ifndef AXI_MASTER_H
+#define AXI_MASTER_H
+
+/**
+ * @brief AXI write master. The queued writes are split into INCR bursts of at most
+ *        the configured length, without crossing a 4KB boundary. Each burst takes a
+ *        transaction ID on its address transfer and frees it on its write response,
+ *        so at most the configured number of bursts are outstanding. The data beats
+ *        follow the address transfers in order, one per bus cycle.
+ */
+class axi_master : public sc_module {
+
+    public:
+
+        SC_HAS_PROCESS(axi_master);
+
+        /**
+         * @brief Constructor.
+         *
+         * @param name            SystemC module name.
+         * @param bus             Write channels driven by the master.
+         * @param max_burst       Beats per burst, at most AXI_MAX_BURST_LEN.
+         * @param max_outstanding Transaction IDs, at most AXI_MAX_OUTSTANDING.
+         */
+        axi_master(sc_module_name name, axi_write_bus_t &bus, uint32_t max_burst, uint32_t max_outstanding);
+
+        /**
+         * @brief Queue a write of consecutive words.
+         *
+         * @param addr Byte address of the first word.
+         * @param data Words to write, copied.
+         * @param n    Number of words.
+         */
+        void write(uint64_t addr, const uint64_t *data, uint64_t n);
+
+        /** Signal once every burst queued so far is answered, right away when none is outstanding. */
+        void notify_last();
+
+        /** Beats queued and not yet transferred. */
+        uint64_t pending() const { return _pending; }
+
+        /** Notified on each data beat and write response. */
+        const sc_event &progress_event() const { return _progress_event; }
+
+        /** Number of signalled responses received. */
+        uint64_t n_notified() const { return _n_notified; }
+
+        /** Print the bursts, the stalls and the achieved bandwidth. */
+        void print_report();
+
+    private:
+
+        struct axi_burst_t {
+            uint64_t addr;
+            std::vector<uint64_t> data;
+            uint64_t seq;       // order in which the bursts are queued
+            int32_t id;         // -1 until the address is driven
+            sc_time start_time; // address driven
+        };
+
+        axi_write_bus_t &_bus;
+        uint32_t _max_burst;
+        uint32_t _max_outstanding;
+
+        /** Bursts whose data is not fully transferred, the first `_n_addressed` are addressed. */
+        std::deque<axi_burst_t> _bursts;
+        uint32_t _n_addressed;
+        uint32_t _beat;
+        uint64_t _pending;
+        uint64_t _n_queued;
+
+        /** Transaction IDs in flight until their write response. */
+        bool _id_busy[AXI_MAX_OUTSTANDING];
+        uint64_t _id_seq[AXI_MAX_OUTSTANDING];
+        sc_time _id_start[AXI_MAX_OUTSTANDING];
+        uint32_t _n_outstanding;
+
+        sc_event _progress_event;
+        uint64_t _n_notified;
+
+        /** Bursts queued before each pending notification, oldest first. */
+        std::deque<uint64_t> _notify_at;
+
+        /** Statistics. */
+        uint64_t _n_bursts;
+        uint64_t _n_beats;
+        uint64_t _n_errors;
+        uint64_t _aw_stall;  // cycles with the address not accepted
+        uint64_t _w_stall;   // cycles with a beat not accepted
+        uint64_t _id_stall;  // cycles with an address waiting for a free ID
+        uint32_t _max_in_flight;
+        sc_time _sum_latency; // address to response
+        sc_time _first_time;
+        sc_time _last_time;
+
+        /** Sample the handshakes on each rising edge, then drive the channels. */
+        void main();
+
+        /** Lowest free transaction ID, or -1. */
+        int32_t alloc_id();
+
+        /** Signal the pending notifications whose bursts are all answered. */
+        void check_notify();
+
+};
+
+#endif // AXI_MASTER_H
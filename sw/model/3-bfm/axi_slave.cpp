@@ -0,0 +1,74 @@
+
+#include "axi_slave.h"
+#include "system.h"
+
+#include <iostream>
+
+axi_slave::axi_slave(sc_module_name name, axi_write_bus_t &bus)
+    : sc_module(name), _bus(bus), _w_held(0)
+{
+    _bus.awready.write(SC_LOGIC_0);
+    _bus.wready.write(SC_LOGIC_0);
+    _bus.bvalid.write(SC_LOGIC_0);
+
+    SC_THREAD(main);
+}
+
+void axi_slave::main() {
+    while (true) {
+        POS_MAIN();
+
+        // address transfer
+        if (_bus.awvalid.read() == SC_LOGIC_1 && _bus.awready.read() == SC_LOGIC_1) {
+            _addrs.push_back({ _bus.awid.read(), _bus.awaddr.read(), _bus.awlen.read() + 1, 0, true });
+        }
+
+        // data transfer, to the oldest address
+        if (_bus.wvalid.read() == SC_LOGIC_1) {
+            if (_bus.wready.read() == SC_LOGIC_1) {
+                axi_addr_t &a = _addrs.front();
+                if (!write_beat(a.addr + (uint64_t)a.beat * AXI_BEAT_BYTES, _bus.wdata.read())) a.ok = false;
+                a.beat++;
+
+                // respond after the last beat
+                if (_bus.wlast.read() == SC_LOGIC_1 || a.beat == a.beats) {
+                    _resps.push_back({ a.id, a.ok && a.beat == a.beats ? (uint32_t)AXI_RESP_OKAY : (uint32_t)AXI_RESP_SLVERR });
+                    _addrs.pop_front();
+                }
+            }
+            else {
+                _w_held++;
+            }
+        }
+
+        // write response
+        if (_bus.bvalid.read() == SC_LOGIC_1 && _bus.bready.read() == SC_LOGIC_1) {
+            _resps.pop_front();
+        }
+
+        // drive the channels
+        _bus.awready.write(_addrs.size() < AXI_SLAVE_ADDR_DEPTH ? SC_LOGIC_1 : SC_LOGIC_0);
+        _bus.wready.write(!_addrs.empty() && can_write() ? SC_LOGIC_1 : SC_LOGIC_0);
+        if (!_resps.empty()) {
+            _bus.bvalid.write(SC_LOGIC_1);
+            _bus.bid.write(_resps.front().id);
+            _bus.bresp.write(_resps.front().resp);
+        }
+        else {
+            _bus.bvalid.write(SC_LOGIC_0);
+        }
+    }
+}
+
+void axi_slave::print_report() {
+    std::cout << "AXI slave " << this->name() << ": held the data for " << _w_held << " cycles" << std::endl;
+}
+
+axi_memory_slave::axi_memory_slave(sc_module_name name, axi_write_bus_t &bus, memory_if<uint64_t> *mem)
+    : axi_slave(name, bus), _mem(mem)
+{
+}
+
+bool axi_memory_slave::write_beat(uint64_t addr, uint64_t data) {
+    return _mem->write(addr, data);
+}
@@ -0,0 +1,102 @@
+
+#include "systemc.h"
+#include "system.h"
+#include "memory_if.hpp"
+#include "axi_bus.h"
+
+#include <deque>
+
+#ifndef AXI_SLAVE_H
+#define AXI_SLAVE_H
+
+// addresses accepted ahead of their data
+#define AXI_SLAVE_ADDR_DEPTH 4
+
+/**
+ * @brief AXI write slave. Accepts up to AXI_SLAVE_ADDR_DEPTH addresses ahead of
+ *        their data, takes the data beats in order while the subclass has room
+ *        for them, and answers each burst after its last beat, in order.
+ */
+class axi_slave : public sc_module {
+
+    public:
+
+        SC_HAS_PROCESS(axi_slave);
+
+        /**
+         * @brief Constructor.
+         *
+         * @param name SystemC module name.
+         * @param bus  Write channels answered by the slave.
+         */
+        axi_slave(sc_module_name name, axi_write_bus_t &bus);
+
+        /** Print the back-pressure. */
+        void print_report();
+
+    protected:
+
+        /** Whether a data beat can be taken on the next edge. */
+        virtual bool can_write() { return true; }
+
+        /**
+         * @brief Take a data beat.
+         *
+         * @param addr Byte address of the beat.
+         * @param data Data of the beat.
+         * @retval     Whether the write succeeded, otherwise the burst is answered with SLVERR.
+         */
+        virtual bool write_beat(uint64_t addr, uint64_t data) = 0;
+
+    private:
+
+        struct axi_addr_t {
+            uint32_t id;
+            uint64_t addr;
+            uint32_t beats;
+            uint32_t beat;
+            bool ok;
+        };
+
+        struct axi_resp_t {
+            uint32_t id;
+            uint32_t resp;
+        };
+
+        axi_write_bus_t &_bus;
+        std::deque<axi_addr_t> _addrs;
+        std::deque<axi_resp_t> _resps;
+
+        /** Statistics. */
+        uint64_t _w_held; // cycles with a beat not accepted
+
+        /** Sample the handshakes on each rising edge, then drive the channels. */
+        void main();
+
+};
+
+/**
+ * @brief AXI write slave in front of a memory.
+ */
+class axi_memory_slave : public axi_slave {
+
+    public:
+
+        /**
+         * @brief Constructor.
+         *
+         * @param name SystemC module name.
+         * @param bus  Write channels answered by the slave.
+         * @param mem  Memory written by the beats.
+         */
+        axi_memory_slave(sc_module_name name, axi_write_bus_t &bus, memory_if<uint64_t> *mem);
+
+    private:
+
+        memory_if<uint64_t> *_mem;
+
+        bool write_beat(uint64_t addr, uint64_t data);
+
+};
+
+#endif // AXI_SLAVE_H
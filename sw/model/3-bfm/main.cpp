@@ -0,0 +1,88 @@
+
+#include "system.h"
+#include "mat_mult_bfm.h"
+#include "mat_mult_if.h"
+#include "mat_mult_cmd.h"
+#include "memory_if.hpp"
+#include "axi_bus.h"
+#include "axi_slave.h"
+
+#include "systemc.h"
+#include <iostream>
+#include <string>
+
+int kernel_dim;
+int hf_kernel_dim;
+uint8_t *memory;
+
+sc_tracer sc_tracer::tracer;
+latency_tracker latency_tracker::tracker;
+
+int sc_main(int argc, char* argv[]) {
+    if (!parseCmdLine(argc, argv, &memory, &kernel_dim)) {
+        return 1;
+    }
+
+    // interconnect configuration
+    int max_burst = getOptionInt("burst", 16);             // beats per burst
+    int max_outstanding = getOptionInt("outstanding", 4); // transaction IDs per master
+    if (!optionsValid()) {
+        return 1;
+    }
+    if (max_burst < 1 || max_burst > AXI_MAX_BURST_LEN) {
+        std::cerr << "*** ERROR in main: invalid burst length " << max_burst << ", max is " << AXI_MAX_BURST_LEN << std::endl;
+        return 1;
+    }
+    if (max_outstanding < 1 || max_outstanding > AXI_MAX_OUTSTANDING) {
+        std::cerr << "*** ERROR in main: invalid outstanding transactions " << max_outstanding << ", max is " << AXI_MAX_OUTSTANDING << std::endl;
+        return 1;
+    }
+
+    // initial state
+    std::cout << "Matrix size: " << MAT_ROWS << "x" << MAT_COLS << ", kernel size: " << kernel_dim << "x" << kernel_dim << std::endl;
+    std::cout << "AXI bursts of at most " << max_burst << " beats, " << max_outstanding << " outstanding" << std::endl;
+    hf_kernel_dim = kernel_dim >> 1;
+    memoryPrint(memory, kernel_dim);
+
+    // =====================================
+    // ==== CREATE AND CONNECT MODULES =====
+    // =====================================
+
+    // buses of the command port and the memory port
+    axi_write_bus_t cmd_bus("cmd_bus");
+    axi_write_bus_t mem_bus("mem_bus");
+    cmd_bus.trace("cmd_bus");
+    mem_bus.trace("mem_bus");
+
+    // memory behind its AXI slave
+    simple_memory_mod<uint64_t> *mem = new simple_memory_mod<uint64_t>("mem", memory, MEM_SIZE);
+    axi_memory_slave *mem_slave = new axi_memory_slave("mem_slave", mem_bus, mem);
+
+    // matrix multiplier
+    mat_mult_bfm *matrix_multiplier = new mat_mult_bfm("matrix_multiplier", cmd_bus, mem_bus, max_burst, max_outstanding);
+
+    // command issuer (CPU)
+    mat_mult_cmd *cpu = new mat_mult_cmd("cpu", memory, kernel_dim);
+    cpu->mm_if(*matrix_multiplier);
+    matrix_multiplier->cmd_if(*cpu);
+
+    // =============================
+    // ==== RUN THE SIMULATION =====
+    // =============================
+    sc_time startTime = sc_time_stamp();
+    sc_start();
+    sc_time stopTime = sc_time_stamp();
+    sc_logger::flush(); // the records of the run come before the reports
+
+    cout << "Simulated for " << (stopTime - startTime) << endl;
+    latency_tracker::print_report();
+    perf_counters::finish();
+    matrix_multiplier->print_report();
+    mem_slave->print_report();
+
+    // final state
+    memoryWrite(argv, memory);
+    memoryPrint(memory, kernel_dim);
+
+    return 0;
+}
@@ -0,0 +1,121 @@
+
+#include "mat_mult_bfm.h"
+#include "system.h"
+#include "systemc.h"
+
+#include <iostream>
+
+axi_in_fifo::axi_in_fifo(sc_module_name name, axi_write_bus_t &bus)
+    : axi_slave(name, bus), _head(0), _count(0)
+{
+}
+
+uint64_t axi_in_fifo::pop() {
+    uint64_t packet = _packets[_head & IN_FIFO_PTR_MASK];
+    latency_tracker::capture(INPUT_PACKET, _head);
+    _head++;
+    _count--;
+    return packet;
+}
+
+bool axi_in_fifo::write_beat(uint64_t addr, uint64_t data) {
+    // the packets are decoded by the command FSM, the address is not
+    _packets[(_head + _count) & IN_FIFO_PTR_MASK] = data;
+    latency_tracker::publish(INPUT_PACKET, _head + _count);
+    _count++;
+    _data_event.notify(SC_ZERO_TIME);
+    return true;
+}
+
+axi_write_port::axi_write_port(sc_module_name name, axi_master *master, uint64_t mem_size)
+    : sc_module(name), memory_if<uint64_t>(name, mem_size), _master(master)
+{
+    // byte addresses
+    _addr_step = sizeof(uint64_t);
+}
+
+bool axi_write_port::do_write(uint64_t addr, uint64_t data) {
+    _master->write(addr, &data, 1);
+    return true;
+}
+
+bool axi_write_port::do_write_block(uint64_t addr, const uint64_t *data, uint64_t n) {
+    _master->write(addr, data, n);
+    return true;
+}
+
+mat_mult_bfm::mat_mult_bfm(sc_module_name name, axi_write_bus_t &cmd_bus, axi_write_bus_t &mem_bus, uint32_t max_burst, uint32_t max_outstanding)
+    : mat_mult(name, 1, true), _in_transport(false), _n_irqs(0), _busy_cycles(0), _out_stall_cycles(0)
+{
+    host = new axi_master("host", cmd_bus, max_burst, max_outstanding);
+    payload = new axi_in_fifo("payload", cmd_bus);
+    mem_master = new axi_master("mem_master", mem_bus, max_burst, max_outstanding);
+
+    _mem_port = new axi_write_port("mem_port", mem_master, MEM_SIZE);
+    mem_if(*_mem_port);
+
+    SC_THREAD(compute);
+    SC_THREAD(irq);
+}
+
+bool mat_mult_bfm::receive_packet(uint64_t addr, uint64_t packet) {
+    if (_in_transport) return mat_mult::receive_packet(addr, packet);
+    host->write(addr, &packet, 1);
+    return true;
+}
+
+bool mat_mult_bfm::receive_packets(uint64_t addr, const uint64_t *packets, uint32_t n) {
+    if (_in_transport) return mat_mult::receive_packets(addr, packets, n);
+
+    // bursts within the wrapped payload window
+    for (uint32_t i = 0; i < n; i += BFM_PAYLOAD_BURST_LEN) {
+        uint32_t len = n - i < BFM_PAYLOAD_BURST_LEN ? n - i : BFM_PAYLOAD_BURST_LEN;
+        host->write(BURST_ADDR(addr, i), packets + i, len);
+    }
+    return true;
+}
+
+void mat_mult_bfm::signal_ack() {
+    mem_master->notify_last();
+}
+
+void mat_mult_bfm::compute() {
+    while (true) {
+        if (!payload->count()) {
+            IDLE_CORE(payload->data_event());
+            continue;
+        }
+
+        // back-pressure from the output write path
+        if (mem_master->pending() >= BFM_OUT_BUF_SIZE) {
+            _out_stall_cycles++;
+            POS_CORE();
+            continue;
+        }
+
+        uint64_t packet = payload->pop();
+        _in_transport = true;
+        mat_mult::receive_packets(OFFSET_PAYLOAD, &packet, 1);
+        _in_transport = false;
+
+        _busy_cycles++;
+        POS_CORE();
+    }
+}
+
+void mat_mult_bfm::irq() {
+    while (true) {
+        wait(mem_master->progress_event());
+        while (_n_irqs < mem_master->n_notified()) {
+            _n_irqs++;
+            cmd_if->raise_interrupt();
+        }
+    }
+}
+
+void mat_mult_bfm::print_report() {
+    host->print_report();
+    payload->print_report();
+    mem_master->print_report();
+    std::cout << "Compute " << this->name() << ": busy for " << _busy_cycles << " core cycles, stalled by the output for " << _out_stall_cycles << std::endl;
+}
@@ -0,0 +1,149 @@
+
+#include "systemc.h"
+#include "system.h"
+#include "memory_if.hpp"
+#include "axi_bus.h"
+#include "axi_master.h"
+#include "axi_slave.h"
+#include "../0-appl/mat_mult.h"
+
+#ifndef MAT_MULT_BFM_H
+#define MAT_MULT_BFM_H
+
+// output beats queued on the memory master before the computation stalls
+#define BFM_OUT_BUF_SIZE 256
+
+// beats of a payload burst on the command port, the payload window wraps after them
+#define BFM_PAYLOAD_BURST_LEN (SIZE_PAYLOAD / sizeof(uint64_t))
+
+/**
+ * @brief Input FIFO of the matrix multiplier behind the AXI slave of the command
+ *        port. Holds the data channel while it is full.
+ */
+class axi_in_fifo : public axi_slave {
+
+    public:
+
+        /** Constructor. */
+        axi_in_fifo(sc_module_name name, axi_write_bus_t &bus);
+
+        /** Packets in the FIFO. */
+        uint32_t count() const { return _count; }
+
+        /** Remove the packet at the head of the FIFO. */
+        uint64_t pop();
+
+        /** Notified when a packet is pushed. */
+        const sc_event &data_event() const { return _data_event; }
+
+    private:
+
+        uint64_t _packets[IN_FIFO_BUF_SIZE];
+        uint32_t _head;
+        uint32_t _count;
+        sc_event _data_event;
+
+        /** axi_slave overrides. */
+        bool can_write() { return _count < IN_FIFO_BUF_SIZE; }
+        bool write_beat(uint64_t addr, uint64_t data);
+
+};
+
+/**
+ * @brief Output write path of the matrix multiplier, the writes through `memory_if`
+ *        are queued on the AXI master of the memory port.
+ */
+class axi_write_port : public sc_module, public memory_if<uint64_t> {
+
+    public:
+
+        /**
+         * @brief Constructor.
+         *
+         * @param name     SystemC module name.
+         * @param master   Master of the memory bus.
+         * @param mem_size Number of bytes behind the port.
+         */
+        axi_write_port(sc_module_name name, axi_master *master, uint64_t mem_size);
+
+    private:
+
+        axi_master *_master;
+
+        /** memory_if overrides, the path only writes. */
+        bool do_read(uint64_t addr, uint64_t& data) { return false; }
+        bool do_write(uint64_t addr, uint64_t data);
+        bool do_write_block(uint64_t addr, const uint64_t *data, uint64_t n);
+
+};
+
+/**
+ * @brief Bus functional model of the matrix multiplier. The command FSM and the
+ *        computation are the application-level ones, streaming rows. The command host
+ *        writes the packets over the AXI bus of the command port to the input FIFO,
+ *        the computation takes one packet per core cycle from the FIFO, and the output
+ *        rows and acknowledge packets are written over the AXI bus of the memory port.
+ *        The interrupt follows the write responses of every write up to the acknowledge packet.
+ */
+class mat_mult_bfm : public mat_mult {
+
+    public:
+
+        /** Master of the command host, slave of the command port and master of the memory port. */
+        axi_master *host;
+        axi_in_fifo *payload;
+        axi_master *mem_master;
+
+        SC_HAS_PROCESS(mat_mult_bfm);
+
+        /**
+         * @brief Constructor.
+         *
+         * @param name            SystemC module name.
+         * @param cmd_bus         Bus between the command host and the command port.
+         * @param mem_bus         Bus between the memory port and the memory.
+         * @param max_burst       Beats per burst of both masters.
+         * @param max_outstanding Transaction IDs of both masters.
+         */
+        mat_mult_bfm(sc_module_name name, axi_write_bus_t &cmd_bus, axi_write_bus_t &mem_bus, uint32_t max_burst, uint32_t max_outstanding);
+
+        /** Print the reports of the buses and the stalls of the computation. */
+        void print_report();
+
+    protected:
+
+        /** Queue a header packet on the command host. */
+        bool receive_packet(uint64_t addr, uint64_t packet);
+
+        /** Queue the payload on the command host, in bursts within the payload window. */
+        bool receive_packets(uint64_t addr, const uint64_t *packets, uint32_t n);
+
+        /** Raise the interrupt once the writes up to the acknowledge packet are answered. */
+        void signal_ack();
+
+        /** The FIFO is decoded in order, so the next command is written behind the payload. */
+        bool queues_input() const { return true; }
+
+    private:
+
+        axi_write_port *_mem_port;
+
+        /** Whether the packets are being received from the FIFO rather than delivered to it. */
+        bool _in_transport;
+
+        /** Interrupts raised. */
+        uint64_t _n_irqs;
+
+        /** Statistics, in core cycles. */
+        uint64_t _busy_cycles;
+        uint64_t _out_stall_cycles;
+
+        /** Take one packet per core cycle from the input FIFO. */
+        void compute();
+
+        /** Raise the interrupts signalled by the memory master. */
+        void irq();
+
+};
+
+#endif // MAT_MULT_BFM_H
@@ -0,0 +1,655 @@
+
+#include "casim.h"
+#include "system.h"
+#include "mat_mult_if.h"
+#include "conv_engine.h"
+
+#include <string.h>
+#include <chrono>
+#include <iostream>
+
+// last synchronizer stage, the pointer seen by the other clock domain
+#define SYNC_LAST (CASIM_SYNC_STAGES - 1)
+
+casim::casim(uint8_t *mem, uint8_t kernel_dim)
+    : _mem(mem), _kernel_dim(kernel_dim),
+    _t_core_ps(0), _t_main_ps(0), _core_cycles(0), _main_cycles(0), _last_beat_cycle(0), _wall_s(0.0),
+    _payload_cycles(0), _in_empty_cycles(0), _out_stall_cycles(0), _eor_cycles(0), _n_errors(0), _fatal(false),
+    _occ_fp(nullptr), _occ_last(-1)
+{
+    // one partial sum per packet in a row, plus the zero packet at the end of the row
+    _cmc_depth = MAT_COLS / PACKET_BYTES + 1;
+    _cmc = new uint32_t[MAX_N_CLUSTERS * MAX_KERN_BANK * (MAX_KERN_DIM - 1) * _cmc_depth]();
+
+    // kernel then frames
+    _n_cmds = 1 + N_FRAMES;
+
+    // reset
+    memset(_core_regs, 0, sizeof(_core_regs));
+    memset(_main_regs, 0, sizeof(_main_regs));
+    memset(_cmc_wq, 0, sizeof(_cmc_wq));
+    memset(_occupancy, 0, sizeof(_occupancy));
+    memset(_cluster_busy, 0, sizeof(_cluster_busy));
+    memset(_frame_cycles, 0, sizeof(_frame_cycles));
+    _core_regs[0].fsm.state = IFSM_RESTART;
+
+    _core_cur = _core_regs;
+    _core_nxt = _core_regs + 1;
+    _main_cur = _main_regs;
+    _main_nxt = _main_regs + 1;
+}
+
+casim::~casim() {
+    delete[] _cmc;
+    if (_occ_fp) {
+        fclose(_occ_fp);
+    }
+}
+
+bool casim::trace_occupancy(const char *file) {
+    _occ_fp = fopen(file, "w");
+    if (!_occ_fp) {
+        std::cerr << "*** ERROR in main: cannot open occupancy file " << file << std::endl;
+        return false;
+    }
+    fprintf(_occ_fp, "cycle,busy_clusters\n");
+    return true;
+}
+
+bool casim::run() {
+    std::chrono::steady_clock::time_point wall_start = std::chrono::steady_clock::now();
+
+    while (_main_cur->host.n_acked < _n_cmds && !_fatal) {
+        // next clock edge
+        uint64_t t = _t_core_ps < _t_main_ps ? _t_core_ps : _t_main_ps;
+        bool core_edge = _t_core_ps == t;
+        bool main_edge = _t_main_ps == t;
+
+        // every domain clocked at this instant evaluates from the current registers, then all commit
+        if (core_edge) eval_core();
+        if (main_edge) eval_main();
+        if (core_edge) commit_core();
+        if (main_edge) commit_main();
+
+        if (_main_cycles - _last_beat_cycle > CASIM_WATCHDOG_CYCLES) {
+            std::cerr << "*** ERROR in casim: no transfer for " << CASIM_WATCHDOG_CYCLES << " bus cycles, stopped at core cycle " << _core_cycles << std::endl;
+            _fatal = true;
+        }
+    }
+
+    _wall_s = std::chrono::duration<double>(std::chrono::steady_clock::now() - wall_start).count();
+    return !_fatal && !_n_errors;
+}
+
+// =============================
+// ===== CORE CLOCK DOMAIN =====
+// =============================
+
+void casim::eval_core() {
+    const casim_core_state_t &cur = *_core_cur;
+    casim_core_state_t &nxt = *_core_nxt;
+
+    // registers hold their value unless a module drives them
+    nxt = cur;
+
+    // synchronize the pointers of the bus clock domain
+    for (int i = SYNC_LAST; i > 0; --i) {
+        nxt.in_fifo.wptr_sync[i] = cur.in_fifo.wptr_sync[i-1];
+        nxt.out_fifo.rptr_sync[i] = cur.out_fifo.rptr_sync[i-1];
+    }
+    nxt.in_fifo.wptr_sync[0] = _main_cur->in_fifo.wptr;
+    nxt.out_fifo.rptr_sync[0] = _main_cur->out_fifo.rptr;
+
+    // the collector queue is popped before it is pushed
+    eval_out_fifo_write(cur, nxt);
+    eval_collector(cur, nxt);
+    eval_cores(cur, nxt);
+    eval_feeder(cur, nxt);
+    eval_input_fsm(cur, nxt);
+
+    record_occupancy(cur);
+}
+
+void casim::eval_input_fsm(const casim_core_state_t &cur, casim_core_state_t &nxt) {
+    const casim_input_fsm_t &f = cur.fsm;
+    casim_input_fsm_t &n = nxt.fsm;
+
+    // head of the input FIFO, as seen through the synchronized write pointer
+    bool rx_pkt = cur.in_fifo.wptr_sync[SYNC_LAST] != cur.in_fifo.rptr;
+    uint64_t rx_addr = _in_fifo_addr[cur.in_fifo.rptr & IN_FIFO_PTR_MASK];
+    uint64_t rx_data = _in_fifo_data[cur.in_fifo.rptr & IN_FIFO_PTR_MASK];
+    bool is_cmd = rx_pkt && (rx_addr & ADDR_MASK) >= OFFSET_COMMAND;
+    bool pop = false;
+
+    n.o_new = false;
+
+    switch (f.state) {
+    case IFSM_RESTART:
+    {
+        n.chksum = 0;
+        n.status = MM_STAT_OKAY;
+        n.eor = false;
+        n.ack_beat = 0;
+        n.state = IFSM_WAIT_CMD_S_KEY;
+        break;
+    }
+    case IFSM_WAIT_CMD_S_KEY:
+    case IFSM_WAIT_CMD_SIZE:
+    case IFSM_WAIT_CMD_TID:
+    case IFSM_WAIT_CMD_E_KEY:
+    {
+        // payload packets outside of a command are dropped
+        pop = rx_pkt;
+        if (!is_cmd) break;
+
+        // latch the two fields of the packet and accumulate the checksum
+        memcpy((uint32_t*)&n.cmd + 2 * (f.state - IFSM_WAIT_CMD_S_KEY), &rx_data, sizeof(uint64_t));
+        n.chksum = f.chksum ^ (uint32_t)rx_data ^ (uint32_t)(rx_data >> 32);
+
+        if (f.state == IFSM_WAIT_CMD_S_KEY && n.cmd.s_key != MM_S_KEY) n.status |= MM_STAT_ERR_KEY;
+        if (f.state == IFSM_WAIT_CMD_E_KEY && n.cmd.e_key != MM_E_KEY) n.status |= MM_STAT_ERR_KEY;
+
+        n.state = f.state + 1;
+        break;
+    }
+    case IFSM_CHECK_CHKSUM:
+    {
+        // the checksum field cancels the other fields
+        if (f.chksum) n.status |= MM_STAT_ERR_CHKSM;
+
+        if (GET_CMD_TYPE(f.cmd) == MM_CMD_KERN) {
+            uint32_t rows = GET_CMD_SIZE_ROWS(f.cmd);
+            uint32_t cols = GET_CMD_SIZE_COLS(f.cmd);
+            if ((rows != cols) ||      // kernel must be square
+                ((rows & 0b1) == 0) || // kernel must have an odd dimension
+                (rows > MAX_KERN_DIM) || // kernel size constraint
+                (GET_CMD_SIZE_NELS(f.cmd) != rows * cols * GET_CMD_KERN_BANK(f.cmd))) // payload holds the whole bank
+                n.status |= MM_STAT_ERR_SIZE;
+        }
+        else {
+            uint32_t rows = GET_CMD_SIZE_SUBJ_ROWS(f.cmd);
+            uint32_t cols = GET_CMD_SIZE_SUBJ_COLS(f.cmd);
+            if (!cur.krf.kern_dim) {
+                n.status |= MM_STAT_ERR_ORD;
+            }
+            else if (!cols || cols > MAT_COLS || rows <= (uint32_t)(cur.krf.kern_dim >> 1)) {
+                // the cluster memories hold one row of MAT_COLS
+                n.status |= MM_STAT_ERR_SIZE;
+            }
+        }
+
+        if (n.status != MM_STAT_OKAY) {
+            n.state = IFSM_ACK_STAT_TX;
+            break;
+        }
+
+        // activate the command
+        if (GET_CMD_TYPE(f.cmd) == MM_CMD_KERN) {
+            nxt.krf.kern_dim = (uint8_t)GET_CMD_SIZE_ROWS(f.cmd);
+            nxt.krf.n_kern = (uint8_t)GET_CMD_KERN_BANK(f.cmd);
+            n.kern_cursor = 0;
+            n.exp_cols = 0;
+            n.cur_pkts = (GET_CMD_SIZE_NELS(f.cmd) + PACKET_BYTES - 1) / PACKET_BYTES;
+        }
+        else {
+            n.exp_cols = GET_CMD_SIZE_SUBJ_COLS(f.cmd) / PACKET_BYTES;
+            n.cur_cols = n.exp_cols;
+            n.cur_pkts = GET_CMD_SIZE_SUBJ_ROWS(f.cmd) * n.exp_cols;
+            n.row = 0;
+            n.col = 0;
+        }
+        n.state = n.cur_pkts ? IFSM_PAYLOAD_RX : IFSM_WAIT_RES_TX;
+        break;
+    }
+    case IFSM_PAYLOAD_RX:
+    {
+        bool is_subj = GET_CMD_TYPE(f.cmd) == MM_CMD_SUBJ;
+        _payload_cycles++;
+
+        // hold the input while the output packets of the packets in flight may not fit in the collector
+        uint32_t in_flight = f.o_new + cur.feeder.valid + cur.cores.mb_valid + cur.cores.mac_valid;
+        bool out_stall = is_subj && cur.coll.count + (in_flight + 1) * cur.krf.n_kern > COLL_QUEUE_SIZE;
+
+        if (out_stall) {
+            _out_stall_cycles++;
+        }
+        else if (f.eor) {
+            // zero packet after each subject row, shifting the padding of the next row in the feeders
+            n.o_new = true;
+            n.o_packet = 0;
+            n.o_row = f.row;
+            n.o_col = f.col;
+            n.row = f.row + 1;
+            n.col = 0;
+            n.eor = false;
+            if (!f.cur_pkts) n.state = IFSM_WAIT_RES_TX;
+            _eor_cycles++;
+        }
+        else if (!rx_pkt) {
+            _in_empty_cycles++;
+        }
+        else if (is_cmd) {
+            // command packets are not expected before the payload is complete
+            pop = true;
+        }
+        else {
+            pop = true;
+            if (is_subj) {
+                n.o_new = true;
+                n.o_packet = rx_data;
+                n.o_row = f.row;
+                n.o_col = f.col;
+                n.col = f.col + 1;
+                n.cur_cols = f.cur_cols - 1;
+                if (!n.cur_cols) {
+                    n.eor = true;
+                    n.cur_cols = f.exp_cols;
+                }
+            }
+            else if (f.kern_cursor + PACKET_BYTES <= KERN_BANK_SIZE_ROUNDED) {
+                memcpy(nxt.krf.kern + f.kern_cursor, &rx_data, PACKET_BYTES);
+                n.kern_cursor = f.kern_cursor + PACKET_BYTES;
+            }
+
+            n.cur_pkts = f.cur_pkts - 1;
+            if (!n.cur_pkts && !n.eor) n.state = IFSM_WAIT_RES_TX;
+        }
+        break;
+    }
+    case IFSM_WAIT_RES_TX:
+    {
+        if (results_written(cur)) n.state = IFSM_ACK_STAT_TX;
+        break;
+    }
+    case IFSM_ACK_STAT_TX:
+    {
+        mat_mult_ack_t ack;
+        ack.s_key = MM_S_KEY;
+        ack.command = f.cmd.command;
+        ack.size = f.cmd.size;
+        ack.tx_addr = f.cmd.tx_addr;
+        ack.trans_id = f.cmd.trans_id;
+        ack.status = f.status;
+        ack.e_key = MM_E_KEY;
+        ack.chksum = (uint32_t)CALC_ACK_CHKSUM(ack);
+
+        // one acknowledge packet per cycle, the last one raises the interrupt once written
+        if (nxt.coll.count < COLL_QUEUE_SIZE) {
+            bool last = f.ack_beat == N_PACKETS_IN_CMD - 1;
+            coll_push(nxt.coll, (uint64_t)f.cmd.tx_addr + f.ack_beat * sizeof(uint64_t), ((uint64_t*)&ack)[f.ack_beat], last);
+            n.ack_beat = f.ack_beat + 1;
+            if (last) n.state = IFSM_RESTART;
+        }
+        break;
+    }
+    default:
+    {
+        n.state = IFSM_RESTART;
+        break;
+    }
+    };
+
+    if (pop) {
+        nxt.in_fifo.rptr = cur.in_fifo.rptr + 1;
+    }
+}
+
+void casim::eval_feeder(const casim_core_state_t &cur, casim_core_state_t &nxt) {
+    nxt.feeder.valid = cur.fsm.o_new;
+    if (!cur.fsm.o_new) return;
+
+    // keep the last kern_dim-1 pixels of the previous packet in front of the new one
+    uint32_t n_prev = cur.krf.kern_dim - 1;
+    memcpy(nxt.feeder.pixels, cur.feeder.pixels + PACKET_BYTES, n_prev);
+    memcpy(nxt.feeder.pixels + n_prev, &cur.fsm.o_packet, PACKET_BYTES);
+    nxt.feeder.row = cur.fsm.o_row;
+    nxt.feeder.col = cur.fsm.o_col;
+}
+
+void casim::eval_cores(const casim_core_state_t &cur, casim_core_state_t &nxt) {
+    uint32_t kern_dim = cur.krf.kern_dim;
+    uint32_t n_cores = kern_dim * cur.krf.n_kern;
+    uint32_t i, c;
+
+    // MAC, add the partial sum of the previous kernel row to the dot product
+    nxt.cores.mac_valid = cur.cores.mb_valid;
+    if (cur.cores.mb_valid) {
+        nxt.cores.mac_row = cur.cores.mb_row;
+        nxt.cores.mac_col = cur.cores.mb_col;
+        for (i = 0; i < MAX_N_CLUSTERS; ++i) {
+            for (c = 0; c < n_cores; ++c) {
+                nxt.cores.mac_res[i][c] = conv_core_result(cur.cores.mb_dot[i][c] + cur.cores.mb_sub[i][c]);
+            }
+        }
+    }
+
+    // math blocks, core `c` of a cluster holds row `c % kern_dim` of kernel `c / kern_dim`
+    nxt.cores.mb_valid = cur.feeder.valid;
+    if (cur.feeder.valid) {
+        uint32_t row = cur.feeder.row;
+        uint32_t col = cur.feeder.col;
+        nxt.cores.mb_row = row;
+        nxt.cores.mb_col = col;
+        for (i = 0; i < MAX_N_CLUSTERS; ++i) {
+            const uint8_t *window = cur.feeder.pixels + i;
+            for (c = 0; c < n_cores; ++c) {
+                uint32_t kern_row = c % kern_dim;
+                nxt.cores.mb_dot[i][c] = conv_dot_dim((uint8_t)kern_dim, 0, cur.krf.kern + c * kern_dim, window);
+
+                // the first kernel row starts the sum, the memories of the first subject row hold the previous frame
+                nxt.cores.mb_sub[i][c] = (kern_row && row) ? cmc(i, c / kern_dim, kern_row - 1, col) : 0;
+            }
+        }
+    }
+}
+
+void casim::eval_collector(const casim_core_state_t &cur, casim_core_state_t &nxt) {
+    if (!cur.cores.mac_valid) return;
+
+    uint32_t kern_dim = cur.krf.kern_dim;
+    uint32_t hf_kern_dim = kern_dim >> 1;
+    uint32_t last = kern_dim - 1;
+    uint32_t col = cur.cores.mac_col;
+    uint32_t i, k;
+
+    // the last kernel row of subject row `r` completes output row `r - hf_kern_dim`
+    uint32_t rows = GET_CMD_SIZE_SUBJ_ROWS(cur.fsm.cmd);
+    uint32_t cols = GET_CMD_SIZE_SUBJ_COLS(cur.fsm.cmd);
+    uint64_t out_addr = GET_CMD_OUT_ADDR(cur.fsm.cmd);
+    uint64_t plane_size = (uint64_t)(rows - hf_kern_dim) * cols;
+    bool row_valid = cur.cores.mac_row >= hf_kern_dim;
+    uint64_t row_addr = out_addr + (uint64_t)(cur.cores.mac_row - hf_kern_dim) * cols;
+
+    for (k = 0; k < cur.krf.n_kern; ++k) {
+        uint8_t *line = nxt.coll.line[k];
+        uint32_t core = k * kern_dim + last;
+
+        // cluster `i` is centered on column `col * PACKET_BYTES + i - hf_kern_dim`, the first ones complete the previous packet
+        for (i = 0; i < hf_kern_dim; ++i) {
+            line[PACKET_BYTES - hf_kern_dim + i] = (uint8_t)cur.cores.mac_res[i][core];
+        }
+        if (col && row_valid) {
+            uint64_t packet;
+            memcpy(&packet, line, PACKET_BYTES);
+            coll_push(nxt.coll, row_addr + k * plane_size + (col - 1) * PACKET_BYTES, packet, false);
+        }
+        for (; i < MAX_N_CLUSTERS; ++i) {
+            line[i - hf_kern_dim] = (uint8_t)cur.cores.mac_res[i][core];
+        }
+    }
+
+    // store the partial sums of the other kernel rows for the next subject row
+    if (kern_dim > 1) {
+        cmc_write_t &w = _cmc_wq[(_core_cycles + CMC_WR_DELAY) % (CMC_WR_DELAY + 1)];
+        w.valid = true;
+        w.col = col;
+        for (i = 0; i < MAX_N_CLUSTERS; ++i) {
+            memcpy(w.res[i], cur.cores.mac_res[i], kern_dim * cur.krf.n_kern * sizeof(uint32_t));
+        }
+    }
+}
+
+void casim::eval_out_fifo_write(const casim_core_state_t &cur, casim_core_state_t &nxt) {
+    // one packet per cycle while the FIFO has room, as seen through the synchronized read pointer
+    uint32_t used = cur.out_fifo.wptr - cur.out_fifo.rptr_sync[SYNC_LAST];
+    if (!cur.coll.count || used >= OUT_FIFO_BUF_SIZE) return;
+
+    _out_fifo[cur.out_fifo.wptr & OUT_FIFO_PTR_MASK] = cur.coll.queue[cur.coll.head];
+    nxt.out_fifo.wptr = cur.out_fifo.wptr + 1;
+    nxt.coll.head = (cur.coll.head + 1) % COLL_QUEUE_SIZE;
+    nxt.coll.count--;
+}
+
+void casim::coll_push(casim_collector_t &coll, uint64_t addr, uint64_t data, bool irq) {
+    casim_out_pkt_t &pkt = coll.queue[(coll.head + coll.count) % COLL_QUEUE_SIZE];
+    pkt.addr = addr;
+    pkt.data = data;
+    pkt.irq = irq;
+    coll.count++;
+}
+
+bool casim::results_written(const casim_core_state_t &cur) {
+    return !cur.fsm.o_new && !cur.feeder.valid && !cur.cores.mb_valid && !cur.cores.mac_valid && !cur.coll.count;
+}
+
+void casim::record_occupancy(const casim_core_state_t &cur) {
+    // a cluster is busy while its cores hold a packet, the clusters are fed in lock-step so they are all busy at once
+    uint32_t n_busy = 0;
+    for (uint32_t i = 0; i < MAX_N_CLUSTERS; ++i) {
+        if (cur.cores.mb_valid || cur.cores.mac_valid) {
+            _cluster_busy[i]++;
+            n_busy++;
+        }
+    }
+    _occupancy[n_busy]++;
+
+    if (_occ_fp && (int32_t)n_busy != _occ_last) {
+        fprintf(_occ_fp, "%llu,%u\n", (unsigned long long)_core_cycles, n_busy);
+        _occ_last = (int32_t)n_busy;
+    }
+}
+
+void casim::commit_core() {
+    // cluster memory writes due this cycle
+    cmc_write_t &w = _cmc_wq[_core_cycles % (CMC_WR_DELAY + 1)];
+    if (w.valid) {
+        uint32_t kern_dim = _core_nxt->krf.kern_dim;
+        for (uint32_t i = 0; i < MAX_N_CLUSTERS; ++i) {
+            for (uint32_t k = 0; k < _core_nxt->krf.n_kern; ++k) {
+                for (uint32_t r = 0; r + 1 < kern_dim; ++r) {
+                    cmc(i, k, r, w.col) = w.res[i][k * kern_dim + r];
+                }
+            }
+        }
+        w.valid = false;
+    }
+
+    casim_core_state_t *tmp = _core_cur;
+    _core_cur = _core_nxt;
+    _core_nxt = tmp;
+
+    _core_cycles++;
+    _t_core_ps += CASIM_CORE_PS;
+}
+
+// ============================
+// ===== BUS CLOCK DOMAIN =====
+// ============================
+
+void casim::eval_main() {
+    const casim_main_state_t &cur = *_main_cur;
+    casim_main_state_t &nxt = *_main_nxt;
+
+    // registers hold their value unless a module drives them
+    nxt = cur;
+
+    // synchronize the pointers of the core clock domain
+    for (int i = SYNC_LAST; i > 0; --i) {
+        nxt.in_fifo.rptr_sync[i] = cur.in_fifo.rptr_sync[i-1];
+        nxt.out_fifo.wptr_sync[i] = cur.out_fifo.wptr_sync[i-1];
+    }
+    nxt.in_fifo.rptr_sync[0] = _core_cur->in_fifo.rptr;
+    nxt.out_fifo.wptr_sync[0] = _core_cur->out_fifo.wptr;
+
+    eval_out_fifo_read(cur, nxt);
+    eval_host(cur, nxt);
+}
+
+void casim::eval_out_fifo_read(const casim_main_state_t &cur, casim_main_state_t &nxt) {
+    if (cur.out_fifo.wptr_sync[SYNC_LAST] == cur.out_fifo.rptr) return;
+
+    // one packet per bus cycle to the CPU memory
+    const casim_out_pkt_t &pkt = _out_fifo[cur.out_fifo.rptr & OUT_FIFO_PTR_MASK];
+    if (pkt.addr + sizeof(uint64_t) <= MEM_SIZE) {
+        memcpy(_mem + pkt.addr, &pkt.data, sizeof(uint64_t));
+    }
+    else {
+        std::cerr << "*** ERROR in casim: output packet to " << pkt.addr << " is out of the memory" << std::endl;
+        _n_errors++;
+    }
+    if (pkt.irq) {
+        nxt.host.n_irqs++;
+    }
+
+    nxt.out_fifo.rptr = cur.out_fifo.rptr + 1;
+    _last_beat_cycle = _main_cycles;
+}
+
+void casim::eval_host(const casim_main_state_t &cur, casim_main_state_t &nxt) {
+    const casim_host_t &h = cur.host;
+    casim_host_t &n = nxt.host;
+
+    // verify the oldest command once its interrupt is raised, the commands complete in order
+    if (h.n_irqs > h.n_acked) {
+        verify_ack(h);
+        n.n_acked = h.n_acked + 1;
+    }
+
+    // post the next command while a queue slot is free
+    if (h.n_posted < _n_cmds && h.n_posted - h.n_acked < QUEUE_DEPTH) {
+        post_cmd(h, n);
+    }
+
+    // one packet per bus cycle while the input FIFO has room, as seen through the synchronized read pointer
+    if (h.n_sent == h.n_posted || cur.in_fifo.wptr - cur.in_fifo.rptr_sync[SYNC_LAST] >= IN_FIFO_BUF_SIZE) return;
+
+    uint32_t slot = h.n_sent % QUEUE_DEPTH;
+    uint64_t addr;
+    uint64_t data;
+    if (h.beat < N_PACKETS_IN_CMD) {
+        addr = OFFSET_COMMAND + h.beat * sizeof(uint64_t);
+        data = ((const uint64_t*)&h.cmds[slot])[h.beat];
+    }
+    else {
+        uint32_t i = h.beat - N_PACKETS_IN_CMD;
+        addr = BURST_ADDR(OFFSET_PAYLOAD, i);
+        memcpy(&data, _mem + h.in_addr[slot] + (uint64_t)i * sizeof(uint64_t), sizeof(uint64_t));
+    }
+    _in_fifo_addr[cur.in_fifo.wptr & IN_FIFO_PTR_MASK] = addr;
+    _in_fifo_data[cur.in_fifo.wptr & IN_FIFO_PTR_MASK] = data;
+    nxt.in_fifo.wptr = cur.in_fifo.wptr + 1;
+    _last_beat_cycle = _main_cycles;
+
+    n.beat = h.beat + 1;
+    if (n.beat == N_PACKETS_IN_CMD + h.n_packets[slot]) {
+        n.beat = 0;
+        n.n_sent = h.n_sent + 1;
+    }
+}
+
+void casim::post_cmd(const casim_host_t &cur, casim_host_t &nxt) {
+    uint32_t trans_id = cur.n_posted;
+    uint32_t slot = trans_id % QUEUE_DEPTH;
+    uint32_t hf_kernel_dim = _kernel_dim >> 1;
+    uint32_t cmd_type, rows, cols, n_kern;
+    uint64_t in_addr, out_addr;
+
+    if (!trans_id) {
+        // kernel once for the whole sequence
+        cmd_type = MM_CMD_KERN;
+        rows = _kernel_dim;
+        cols = _kernel_dim;
+        n_kern = N_KERN;
+        in_addr = KERN_ADDR;
+        out_addr = 0;
+    }
+    else {
+        // a frame buffer is reused once the frame before in the buffer is acknowledged
+        uint32_t frame = trans_id - 1;
+        uint32_t n_frames_done = cur.n_acked ? cur.n_acked - 1 : 0;
+        if (frame >= n_frames_done + N_FRAME_BUFS) return;
+        if (frame && !frameLoad(_mem, frame)) {
+            _fatal = true;
+            return;
+        }
+
+        // with the padding rows below the frame
+        cmd_type = MM_CMD_SUBJ;
+        rows = MAT_ROWS + hf_kernel_dim;
+        cols = MAT_COLS;
+        n_kern = 1;
+        in_addr = FRAME_MAT_ADDR(frame);
+        out_addr = FRAME_OUT_ADDR(frame);
+    }
+
+    // construct command
+    mat_mult_cmd_t &cmd = nxt.cmds[slot];
+    cmd.s_key = MM_S_KEY;
+    cmd.command = GEN_COMMAND(cmd_type, out_addr);
+    if (cmd_type == MM_CMD_KERN) {
+        cmd.size = GEN_KERN_SIZE(rows, cols, n_kern);
+        cmd.reserved = GEN_KERN_RSVD(n_kern);
+    }
+    else {
+        cmd.size = GEN_SUBJ_SIZE(rows, cols);
+        cmd.reserved = GEN_SUBJ_RSVD(rows, cols);
+    }
+    cmd.tx_addr = (uint32_t)BUILD_ACK_ADDR(slot);
+    cmd.trans_id = trans_id;
+    cmd.e_key = MM_E_KEY;
+    cmd.chksum = CALC_CMD_CHKSUM(cmd);
+
+    nxt.in_addr[slot] = in_addr;
+    nxt.n_packets[slot] = (rows * cols * n_kern + PACKET_BYTES - 1) / PACKET_BYTES;
+    nxt.post_cycle[slot] = _main_cycles;
+    nxt.n_posted = trans_id + 1;
+}
+
+void casim::verify_ack(const casim_host_t &cur) {
+    uint32_t slot = cur.n_acked % QUEUE_DEPTH;
+    const mat_mult_cmd_t &cmd = cur.cmds[slot];
+    mat_mult_ack_t ack;
+    memcpy(&ack, _mem + cmd.tx_addr, sizeof(ack));
+
+    uint64_t latency = _main_cycles - cur.post_cycle[slot];
+    LOG_DEBUG("casim", "bus cycle %llu: acknowledged transaction %d, status %d, latency %llu bus cycles",
+        _main_cycles, ack.trans_id, ack.status, latency);
+
+    if (!CMP_CMD_ACK(cmd, ack) || ack.chksum != (uint32_t)(CALC_ACK_CHKSUM(ack)) || ack.status != MM_STAT_OKAY) {
+        std::cerr << "*** ERROR in casim: acknowledge packet of transaction " << cmd.trans_id << " does not match, status " << ack.status << std::endl;
+        _n_errors++;
+    }
+
+    // frames follow the kernel
+    if (cmd.trans_id) {
+        if (cmd.trans_id == 1) _frame_cycles[0] = _main_cycles;
+        _frame_cycles[1] = _main_cycles;
+    }
+}
+
+void casim::commit_main() {
+    casim_main_state_t *tmp = _main_cur;
+    _main_cur = _main_nxt;
+    _main_nxt = tmp;
+
+    _main_cycles++;
+    _t_main_ps += CASIM_MAIN_PS;
+}
+
+void casim::print_report() {
+    double sim_ns = CC_CORE(_core_cycles);
+    printf("Simulated for %.0f ns: %llu core cycles, %llu bus cycles, in %.3f s on the host (%.2f M core cycles/s)\n",
+        sim_ns, (unsigned long long)_core_cycles, (unsigned long long)_main_cycles, _wall_s,
+        _wall_s > 0 ? _core_cycles / _wall_s * 1e-6 : 0.0);
+
+    // sustained rate between the first and the last frame
+    if (N_FRAMES > 1 && _frame_cycles[1] > _frame_cycles[0]) {
+        uint64_t frame_cycles = _frame_cycles[1] - _frame_cycles[0];
+        printf("Frames: %d, %.2f frames/s (simulated)\n", N_FRAMES, (N_FRAMES - 1) / (CC_MAIN(frame_cycles) * 1e-9));
+    }
+
+    printf("Input FSM: payload for %llu core cycles, waited for the input FIFO for %llu, held by the output for %llu, %llu end of row packets\n",
+        (unsigned long long)_payload_cycles, (unsigned long long)_in_empty_cycles,
+        (unsigned long long)_out_stall_cycles, (unsigned long long)_eor_cycles);
+
+    printf("Cluster occupancy:\n");
+    for (int i = 0; i <= MAX_N_CLUSTERS; ++i) {
+        if (!_occupancy[i]) continue;
+        printf("  %d clusters busy: %llu core cycles (%.1f%%)\n", i, (unsigned long long)_occupancy[i],
+            _core_cycles ? 100.0 * _occupancy[i] / _core_cycles : 0.0);
+    }
+    for (int i = 0; i < MAX_N_CLUSTERS; ++i) {
+        printf("  cluster %d: busy for %llu core cycles (%.1f%%)\n", i, (unsigned long long)_cluster_busy[i],
+            _core_cycles ? 100.0 * _cluster_busy[i] / _core_cycles : 0.0);
+    }
+}
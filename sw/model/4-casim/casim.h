@@ -0,0 +1,322 @@
+
+#include "system.h"
+#include "mat_mult_if.h"
+#include "conv_engine.h"
+
+#include <stdio.h>
+#include <stdint.h>
+
+#ifndef CASIM_H
+#define CASIM_H
+
+// clock periods in picoseconds, so the edges of the two clocks are exact
+#define CASIM_CORE_PS 4000  // CC_CORE_NS
+#define CASIM_MAIN_PS 15625 // CC_MAIN_NS
+
+// flip-flops synchronizing a FIFO pointer in the other clock domain
+#define CASIM_SYNC_STAGES 2
+
+// output FIFO of the matrix multiplier, in packets
+#define OUT_FIFO_BUF_N_BITS 6
+#define OUT_FIFO_BUF_SIZE (1 << OUT_FIFO_BUF_N_BITS)
+#define OUT_FIFO_PTR_MASK (OUT_FIFO_BUF_SIZE - 1)
+
+// registered stages between the input FSM and the output collector: FSM output, feeder, math blocks, MAC
+#define CASIM_PIPE_DEPTH 4
+
+// output packets waiting in the collector for the output FIFO
+#define COLL_QUEUE_SIZE (2 * MAX_KERN_BANK * (CASIM_PIPE_DEPTH + 1))
+
+// core cycles between a MAC result and its write in the cluster memory
+#define CMC_WR_DELAY 4
+
+// bus cycles without a beat on either FIFO before the simulation is declared stuck
+#define CASIM_WATCHDOG_CYCLES 100000
+
+/**
+ * States of the input FSM, as in `input_fsm.vhd`. The register host is not
+ * modelled, so an erroneous command is acknowledged and dropped instead of
+ * waiting in WAIT_ERR_ACK.
+ */
+enum casim_fsm_state_e {
+    IFSM_RESTART,
+    IFSM_WAIT_CMD_S_KEY,
+    IFSM_WAIT_CMD_SIZE,
+    IFSM_WAIT_CMD_TID,
+    IFSM_WAIT_CMD_E_KEY,
+    IFSM_CHECK_CHKSUM,
+    IFSM_PAYLOAD_RX,
+    IFSM_WAIT_RES_TX,
+    IFSM_ACK_STAT_TX,
+};
+
+// ======================================
+// ===== CORE CLOCK DOMAIN (MACCLK) =====
+// ======================================
+
+/** Read side of an asynchronous FIFO, the write pointer is synchronized into the read domain. */
+struct casim_fifo_r_t {
+    uint32_t rptr;
+    uint32_t wptr_sync[CASIM_SYNC_STAGES];
+};
+
+/** Write side of an asynchronous FIFO, the read pointer is synchronized into the write domain. */
+struct casim_fifo_w_t {
+    uint32_t wptr;
+    uint32_t rptr_sync[CASIM_SYNC_STAGES];
+};
+
+/** Input FSM registers, `input_fsm.vhd`. */
+struct casim_input_fsm_t {
+    uint8_t state;
+    uint32_t chksum;       // running XOR of the command packets, zero after a valid command
+    uint32_t status;       // acknowledge status
+    mat_mult_cmd_t cmd;    // latched command
+    uint32_t exp_cols;     // packets per subject row
+    uint32_t cur_cols;     // packets left in the row
+    uint32_t cur_pkts;     // payload packets left
+    uint32_t row;          // subject row of the next packet
+    uint32_t col;          // packet in the row of the next packet
+    bool eor;              // end of row, the zero packet is due
+    uint32_t kern_cursor;  // bytes loaded in the kernel register file
+    uint32_t ack_beat;     // acknowledge packets queued
+
+    // outputs to the cluster feeders, registered
+    bool o_new;
+    uint64_t o_packet;
+    uint32_t o_row;
+    uint32_t o_col;
+};
+
+/** Kernel register file, `krf.vhd`. */
+struct casim_krf_t {
+    uint8_t kern_dim;  // zero until a kernel is loaded
+    uint8_t n_kern;
+    uint8_t kern[KERN_BANK_SIZE_ROUNDED];
+};
+
+/**
+ * Cluster feeders, `cluster_feeder.vhd`. All feeders shift the same packet, the
+ * feeder of cluster `i` presents the window starting at pixel `i` to its cores.
+ */
+struct casim_feeder_t {
+    bool valid;
+    uint32_t row;
+    uint32_t col;
+    uint8_t pixels[MAX_CLUSTER_INPUT_SIZE]; // last kern_dim-1 pixels of the previous packet, then the packet
+};
+
+/**
+ * Core pipeline of every cluster, `core.vhd`. The math blocks register the dot
+ * product of each kernel row with the window and the partial sum read from the
+ * cluster memory, the MAC registers their 18-bit sum. The clusters are fed in
+ * lock-step, so they share the valid bits and the position.
+ */
+struct casim_cores_t {
+    bool mb_valid;
+    uint32_t mb_row;
+    uint32_t mb_col;
+    uint32_t mb_dot[MAX_N_CLUSTERS][MAX_N_CORES_PER_CLUSTER];
+    uint32_t mb_sub[MAX_N_CLUSTERS][MAX_N_CORES_PER_CLUSTER];
+
+    bool mac_valid;
+    uint32_t mac_row;
+    uint32_t mac_col;
+    uint32_t mac_res[MAX_N_CLUSTERS][MAX_N_CORES_PER_CLUSTER];
+};
+
+/** Output packet, to the output FIFO. */
+struct casim_out_pkt_t {
+    uint64_t addr;
+    uint64_t data;
+    bool irq; // last packet of the acknowledge, raises the interrupt once written
+};
+
+/**
+ * Output collector. Gathers the pixels of the last kernel row of each cluster in
+ * aligned output packets and queues them for the output FIFO.
+ */
+struct casim_collector_t {
+    uint8_t line[MAX_KERN_BANK][PACKET_BYTES]; // output packet in progress for each kernel
+    casim_out_pkt_t queue[COLL_QUEUE_SIZE];
+    uint32_t head;
+    uint32_t count;
+};
+
+/** Registers clocked by the core clock. */
+struct casim_core_state_t {
+    casim_fifo_r_t in_fifo;
+    casim_input_fsm_t fsm;
+    casim_krf_t krf;
+    casim_feeder_t feeder;
+    casim_cores_t cores;
+    casim_collector_t coll;
+    casim_fifo_w_t out_fifo;
+};
+
+// ===================================
+// ===== BUS CLOCK DOMAIN (ACLK) =====
+// ===================================
+
+/** Command host, posts the kernel then the frames and verifies the acknowledge packets. */
+struct casim_host_t {
+    uint32_t n_posted;  // commands built, kernel first
+    uint32_t n_sent;    // commands whose packets were all written
+    uint32_t n_acked;   // commands verified
+    uint32_t n_irqs;    // interrupts raised by the output path
+    uint32_t beat;      // packet of the command being sent, header then payload
+    mat_mult_cmd_t cmds[MAX_QUEUE_DEPTH];
+    uint64_t in_addr[MAX_QUEUE_DEPTH];
+    uint32_t n_packets[MAX_QUEUE_DEPTH];
+    uint64_t post_cycle[MAX_QUEUE_DEPTH];
+};
+
+/** Registers clocked by the bus clock. */
+struct casim_main_state_t {
+    casim_fifo_w_t in_fifo;
+    casim_fifo_r_t out_fifo;
+    casim_host_t host;
+};
+
+/**
+ * @brief Cycle-based simulator of `mat_conv_top` without the SystemC kernel. Each
+ *        clock edge evaluates the next state of the registers of its domain from the
+ *        current state of both domains, then the registers of every domain clocked at
+ *        that instant are committed at once. The cluster memories are written at the
+ *        commit.
+ *
+ *        The input and output FIFOs cross between the bus clock of the host and the
+ *        core clock of the clusters, with synchronized pointers.
+ */
+class casim {
+
+    public:
+
+        /**
+         * @brief Constructor.
+         *
+         * @param mem        CPU memory, holding the kernels and the frames.
+         * @param kernel_dim Kernel dimension posted by the host.
+         */
+        casim(uint8_t *mem, uint8_t kernel_dim);
+
+        /** Destructor. */
+        ~casim();
+
+        /**
+         * @brief Dump the cluster occupancy to `file`, one line per change as
+         *        `<core cycle>,<busy clusters>`.
+         *
+         * @retval Whether the file could be opened.
+         */
+        bool trace_occupancy(const char *file);
+
+        /**
+         * @brief Run until every frame is acknowledged.
+         *
+         * @retval Whether the commands completed without error.
+         */
+        bool run();
+
+        /** Print the cycle counts, stalls and the cluster occupancy. */
+        void print_report();
+
+    private:
+
+        /** Configuration. */
+        uint8_t *_mem;
+        uint8_t _kernel_dim;
+        uint32_t _cmc_depth; // cluster memory entries per kernel row, one per packet in a row
+        uint32_t _n_cmds;    // kernel and frames
+
+        /** Double-buffered registers of both clock domains. */
+        casim_core_state_t _core_regs[2];
+        casim_main_state_t _main_regs[2];
+        casim_core_state_t *_core_cur;
+        casim_core_state_t *_core_nxt;
+        casim_main_state_t *_main_cur;
+        casim_main_state_t *_main_nxt;
+
+        /** FIFO memories, a slot is only visible to the reader once its pointer is synchronized. */
+        uint64_t _in_fifo_addr[IN_FIFO_BUF_SIZE];
+        uint64_t _in_fifo_data[IN_FIFO_BUF_SIZE];
+        casim_out_pkt_t _out_fifo[OUT_FIFO_BUF_SIZE];
+
+        /** Cluster memories, indexed by cluster, kernel, kernel row and packet in the row. */
+        uint32_t *_cmc;
+
+        /** Cluster memory writes in flight, applied CMC_WR_DELAY cycles after the MAC result. */
+        struct cmc_write_t {
+            bool valid;
+            uint32_t col;
+            uint32_t res[MAX_N_CLUSTERS][MAX_N_CORES_PER_CLUSTER];
+        };
+        cmc_write_t _cmc_wq[CMC_WR_DELAY + 1];
+
+        /** Time. */
+        uint64_t _t_core_ps;
+        uint64_t _t_main_ps;
+        uint64_t _core_cycles;
+        uint64_t _main_cycles;
+        uint64_t _last_beat_cycle; // bus cycle of the last beat on either FIFO
+        double _wall_s;
+
+        /** Statistics, in core cycles. */
+        uint64_t _payload_cycles;
+        uint64_t _in_empty_cycles;   // waiting for the input FIFO during a payload
+        uint64_t _out_stall_cycles;  // input held by the output path
+        uint64_t _eor_cycles;
+        uint64_t _occupancy[MAX_N_CLUSTERS + 1]; // cycles with each number of busy clusters
+        uint64_t _cluster_busy[MAX_N_CLUSTERS];  // cycles each cluster is busy
+        uint64_t _frame_cycles[2]; // first and last frame acknowledged, in bus cycles
+        uint32_t _n_errors;
+        bool _fatal;
+
+        /** Occupancy trace. */
+        FILE *_occ_fp;
+        int32_t _occ_last;
+
+        /** Cluster memory entry. */
+        uint32_t &cmc(uint32_t cluster, uint32_t kern, uint32_t row, uint32_t col) {
+            return _cmc[((cluster * MAX_KERN_BANK + kern) * (MAX_KERN_DIM - 1) + row) * _cmc_depth + col];
+        }
+
+        /** Evaluate the registers of the core clock domain. */
+        void eval_core();
+
+        /** Evaluate the registers of the bus clock domain. */
+        void eval_main();
+
+        /** Core clock domain modules, reading `_core_cur` and writing `_core_nxt`. */
+        void eval_input_fsm(const casim_core_state_t &cur, casim_core_state_t &nxt);
+        void eval_feeder(const casim_core_state_t &cur, casim_core_state_t &nxt);
+        void eval_cores(const casim_core_state_t &cur, casim_core_state_t &nxt);
+        void eval_collector(const casim_core_state_t &cur, casim_core_state_t &nxt);
+        void eval_out_fifo_write(const casim_core_state_t &cur, casim_core_state_t &nxt);
+
+        /** Bus clock domain modules, reading `_main_cur` and writing `_main_nxt`. */
+        void eval_out_fifo_read(const casim_main_state_t &cur, casim_main_state_t &nxt);
+        void eval_host(const casim_main_state_t &cur, casim_main_state_t &nxt);
+
+        /** Commit the registers and memories of a clock domain. */
+        void commit_core();
+        void commit_main();
+
+        /** Build the next command of the host, once its frame buffer is free. */
+        void post_cmd(const casim_host_t &cur, casim_host_t &nxt);
+
+        /** Verify the acknowledge packet of the oldest command in flight. */
+        void verify_ack(const casim_host_t &cur);
+
+        /** Queue an output packet in the collector. */
+        static void coll_push(casim_collector_t &coll, uint64_t addr, uint64_t data, bool irq);
+
+        /** Whether the collector and the core pipeline are empty. */
+        static bool results_written(const casim_core_state_t &cur);
+
+        /** Record the cluster occupancy of the current core cycle. */
+        void record_occupancy(const casim_core_state_t &cur);
+
+};
+
+#endif // CASIM_H
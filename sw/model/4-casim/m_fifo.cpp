@@ -12,18 +12,18 @@ FIFO_ASYNC_RTL<T, ADDR_SIZE>::FIFO_ASYNC_RTL(sc_module_name name) : sc_module(na
 
 template <typename T, unsigned int ADDR_SIZE>
 bool FIFO_ASYNC_RTL<T, ADDR_SIZE>::is_full() {
-    return (wptr & addr_mask == rptr & addr_mask) && (wptr & wrap_mask != rptr & wrap_mask);
+    return ((wptr & addr_mask) == (rptr & addr_mask)) && ((wptr & wrap_mask) != (rptr & wrap_mask));
 }
 
 template <typename T, unsigned int ADDR_SIZE>
 bool FIFO_ASYNC_RTL<T, ADDR_SIZE>::is_empty() {
-    return (wptr & addr_mask == rptr & addr_mask) && (wptr & wrap_mask == rptr & wrap_mask);
+    return ((wptr & addr_mask) == (rptr & addr_mask)) && ((wptr & wrap_mask) == (rptr & wrap_mask));
 }
 
 template <typename T, unsigned int ADDR_SIZE>
 void FIFO_ASYNC_RTL<T, ADDR_SIZE>::p_read() {
     if (ren.read().to_bool() && !is_empty()) {
-        dataOut.write(mem[rptr]);
+        dataOut.write(mem[rptr & addr_mask]);
         rptr++;
         rvalid.write(SC_LOGIC_1);
     }
@@ -35,7 +35,7 @@ void FIFO_ASYNC_RTL<T, ADDR_SIZE>::p_read() {
 template <typename T, unsigned int ADDR_SIZE>
 void FIFO_ASYNC_RTL<T, ADDR_SIZE>::p_write() {
     if (wen.read().to_bool() && !is_full()) {
-        mem[wptr] = dataIn.read();
+        mem[wptr & addr_mask] = dataIn.read();
         wptr++;
         wvalid.write(SC_LOGIC_1);
     }
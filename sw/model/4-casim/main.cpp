@@ -0,0 +1,44 @@
+
+#include "system.h"
+#include "casim.h"
+#include "sc_trace.hpp"
+
+#include "systemc.h"
+#include <iostream>
+#include <string>
+
+int kernel_dim;
+uint8_t *memory;
+
+sc_tracer sc_tracer::tracer;
+latency_tracker latency_tracker::tracker;
+
+int sc_main(int argc, char* argv[]) {
+    if (!parseCmdLine(argc, argv, &memory, &kernel_dim)) {
+        return 1;
+    }
+
+    // initial state
+    std::cout << "Subject size: " << MAT_ROWS << "x" << MAT_COLS << ", kernel size: " << kernel_dim << "x" << kernel_dim << std::endl;
+    memoryPrint(memory, kernel_dim);
+
+    // cycle-based simulator, with its own clocks, the SystemC kernel is never started
+    casim *sim = new casim(memory, kernel_dim);
+    if (hasOption("occupancy") && !sim->trace_occupancy(getOption("occupancy").c_str())) {
+        return 1;
+    }
+
+    // =============================
+    // ==== RUN THE SIMULATION =====
+    // =============================
+    bool ok = sim->run();
+    sc_logger::flush(); // the records of the run come before the reports
+    sim->print_report();
+    delete sim;
+
+    // final state
+    memoryWrite(argv, memory);
+    memoryPrint(memory, kernel_dim);
+
+    return ok ? 0 : 1;
+}
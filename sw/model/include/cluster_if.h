@@ -6,7 +6,11 @@
 #ifndef CLUSTER_IF_H
 #define CLUSTER_IF_H
 
-#define INTERNAL_MEMORY_SIZE_PER_GROUP ((MAT_COLS / MAX_N_CLUSTERS) + 1)
+// sub results of every kernel in the bank are interleaved in the internal memories
+#define INTERNAL_MEMORY_SIZE_PER_GROUP (((MAT_COLS / MAX_N_CLUSTERS) + 1) * N_KERN)
+
+// distance between the output pixel buffers of consecutive kernels in the bank
+#define CLUSTER_RESULTS_STRIDE (PACKET_BYTES * 2)
 
 /**
  * @brief Interface to interact with an internal cluster.
@@ -18,19 +22,34 @@ class cluster_if : virtual public sc_interface {
         /** Constructor. */
         cluster_if(uint32_t start_group, uint32_t n_groups, uint32_t n_cores, uint32_t packet_size);
 
-        /** Once the command header has been received, activate the cluster. */
-        virtual void activate(uint32_t command_type, uint32_t r, uint32_t c) = 0;
+        /**
+         * @brief Once the command header has been received, activate the cluster.
+         *
+         * @param command_type `MM_CMD_KERN` or `MM_CMD_SUBJ`.
+         * @param r            Number of rows in the matrix.
+         * @param c            Number of columns in the matrix.
+         * @param n_kern       Number of kernels in the filter bank.
+         */
+        virtual void activate(uint32_t command_type, uint32_t r, uint32_t c, uint32_t n_kern) = 0;
 
         /** Disable the kernel after all payload packets received. */
         virtual void disable() = 0;
 
-        /** Receive data to process (kernel values or input image data). */
+        /**
+         * @brief Receive data to process (kernel values or input image data).
+         *
+         * @param out_ptr Where to store the output pixels of the first kernel, the pixels of
+         *                the next kernels are `CLUSTER_RESULTS_STRIDE` apart.
+         */
         virtual void receive_packet(uint64_t addr, uint64_t packet, uint8_t *out_ptr) = 0;
 
         /** Clear write signal. */
         virtual void clear_packet() = 0;
 
-        /** Return the complete results for each group assigned to the cluster. */
+        /**
+         * @brief Return the complete results for each group assigned to the cluster,
+         *        for each kernel `CLUSTER_RESULTS_STRIDE` apart.
+         */
         virtual bool get_results(uint8_t *res) = 0;
 
         /** Reset the cluster. */
@@ -0,0 +1,140 @@
+#include <stdint.h>
+
+#ifndef CONV_ENGINE_H
+#define CONV_ENGINE_H
+
+/**
+ * Instruction set used by the convolution engine. The engines are
+ * bit-exact with each other, so the selection only affects speed.
+ */
+enum conv_isa_e {
+    CONV_ISA_SCALAR, // portable C++ loop
+    CONV_ISA_AVX2,   // 16 output pixels per iteration
+    CONV_ISA_AVX512, // 32 output pixels per iteration (requires AVX-512BW)
+};
+
+/**
+ * @brief Detect the fastest engine supported by the host CPU.
+ */
+conv_isa_e conv_detect_isa();
+
+/**
+ * @brief Printable name of an engine.
+ */
+const char *conv_isa_name(conv_isa_e isa);
+
+/**
+ * @brief Convolve a single output row with a kernel of fixed dimension.
+ *
+ * @param in_rows  Kernel dimension pointers to the subject rows covered by the
+ *                 kernel, top to bottom. A null pointer is a row of zero padding.
+ * @param cols     Number of columns in the subject.
+ * @param kern     Kernel values, row-major.
+ * @param out      Destination for the `cols` output pixels.
+ */
+typedef void (*conv_row_fn)(const uint8_t *const *in_rows, uint32_t cols, const uint8_t *kern, uint8_t *out);
+
+/**
+ * @brief Select the row convolution specialized for an engine and kernel dimension.
+ *
+ * @retval The function, or null if `kern_dim` is not a legal kernel dimension.
+ */
+conv_row_fn conv_select(conv_isa_e isa, uint8_t kern_dim);
+
+/**
+ * @brief Convolve a single output row with each kernel of a filter bank of fixed dimension.
+ *
+ * The subject rows are walked once in tiles of columns, and each tile is
+ * convolved with every kernel while it is still in cache.
+ *
+ * @param in_rows    Kernel dimension pointers to the subject rows covered by the
+ *                   kernel, top to bottom. A null pointer is a row of zero padding.
+ * @param cols       Number of columns in the subject.
+ * @param kern       Kernel values, row-major, kernels packed back to back.
+ * @param n_kern     Number of kernels, at most `MAX_KERN_BANK`.
+ * @param out        Destination for the `cols` output pixels of the first kernel.
+ * @param out_stride Distance between the output rows of consecutive kernels.
+ */
+typedef void (*conv_bank_fn)(const uint8_t *const *in_rows, uint32_t cols, const uint8_t *kern, uint32_t n_kern, uint8_t *out, uint64_t out_stride);
+
+/**
+ * @brief Select the filter bank row convolution specialized for an engine and kernel dimension.
+ *
+ * @retval The function, or null if `kern_dim` is not a legal kernel dimension.
+ */
+conv_bank_fn conv_select_bank(conv_isa_e isa, uint8_t kern_dim);
+
+/**
+ * @brief Convolve a single output row.
+ *
+ * Each output pixel is the low byte of the 32-bit sum of the unsigned products
+ * between the kernel and the pixel neighbourhood, with zero padding outside of
+ * the subject.
+ *
+ * @param isa      Engine to use.
+ * @param in_rows  `kern_dim` pointers to the subject rows covered by the kernel,
+ *                 top to bottom. A null pointer is a row of zero padding.
+ * @param cols     Number of columns in the subject.
+ * @param kern     Kernel values, row-major.
+ * @param kern_dim Kernel dimension (odd, at most `MAX_KERN_DIM`).
+ * @param out      Destination for the `cols` output pixels.
+ *
+ * @retval Whether the dimension has an engine, `out` is left unchanged otherwise.
+ */
+bool conv_row(conv_isa_e isa, const uint8_t *const *in_rows, uint32_t cols, const uint8_t *kern, uint8_t kern_dim, uint8_t *out);
+
+/**
+ * @brief Row dot product unrolled for a kernel dimension known at compile time.
+ */
+template <int KDIM>
+inline uint32_t conv_dot(uint32_t carry, const uint8_t *kern_row, const uint8_t *group) {
+    for (int i = 0; i < KDIM; i++) {
+        carry += (uint32_t)kern_row[i] * (uint32_t)group[i];
+    }
+    return carry;
+}
+
+// partial sums passed between the cores of a cluster are 18 bits wide
+#define CONV_CORE_RES_MASK 0x3ffff
+
+/**
+ * @brief Mask a core row result to the width passed between cores.
+ */
+inline uint32_t conv_core_result(uint32_t carry) {
+    return carry & CONV_CORE_RES_MASK;
+}
+
+/**
+ * @brief Round a SQ0.7 sum to an output pixel, adding 0.5 then truncating the
+ *        7 fractional bits.
+ */
+inline uint8_t conv_round(uint32_t sum) {
+    return (uint8_t)(((sum + (1 << 6)) >> 7) & 0xff);
+}
+
+/**
+ * @brief Whether `kern_dim` is a legal kernel dimension.
+ */
+inline bool conv_dot_legal(uint32_t kern_dim) {
+    return kern_dim == 1 || kern_dim == 3 || kern_dim == 5 || kern_dim == 7;
+}
+
+/**
+ * @brief Dot product of a kernel row with a group of pixels, added to `carry`.
+ *
+ * The dimension selects an unrolled instantiation. The cores compute one row
+ * result per call, so the switch is taken on every call.
+ *
+ * @retval The sum, or `carry` for a dimension of 0 (unused core) or an illegal one.
+ */
+inline uint32_t conv_dot_dim(uint8_t kern_dim, uint32_t carry, const uint8_t *kern_row, const uint8_t *group) {
+    switch (kern_dim) {
+    case 1: return conv_dot<1>(carry, kern_row, group);
+    case 3: return conv_dot<3>(carry, kern_row, group);
+    case 5: return conv_dot<5>(carry, kern_row, group);
+    case 7: return conv_dot<7>(carry, kern_row, group);
+    default: return carry;
+    };
+}
+
+#endif // CONV_ENGINE_H
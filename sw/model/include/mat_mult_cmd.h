@@ -2,6 +2,8 @@
 #include "systemc.h"
 #include "mat_mult_if.h"
 
+#include <chrono>
+
 #ifndef MAT_MULT_CMD_H
 #define MAT_MULT_CMD_H
 
@@ -40,7 +42,7 @@ class mat_mult_cmd : public sc_module, public cmd_host_if {
          */
         mat_mult_cmd(sc_module_name name, uint8_t *memory, int kernel_size, bool extra_padding = false, bool do_wait = false);
 
-        /** Execute the command sequence. */
+        /** Execute the command sequence, the kernel then `N_FRAMES` subjects. */
         void do_mat_mult();
 
         /** cmd_host_if.raise_interrupt */
@@ -55,8 +57,25 @@ class mat_mult_cmd : public sc_module, public cmd_host_if {
         int _kernel_size;
 
         /** Internal state. */
-        bool _verif_ack;
-        bool _sent_subject;
+        uint32_t _n_posted;
+        uint32_t _kern_trans_id;
+        uint32_t _n_frames_done;
+
+        /** Frame statistics. */
+        sc_time _first_frame_time;
+        sc_time _min_latency;
+        sc_time _max_latency;
+        sc_time _sum_latency;
+        std::chrono::steady_clock::time_point _wall_start;
+
+        /** Acknowledge address of the next command posted. */
+        uint32_t next_ack_addr();
+
+        /** Wait for an acknowledge packet. */
+        void wait_ack();
+
+        /** Count an acknowledged frame, then report and stop after the last frame. */
+        void frame_done();
 
 };
 
@@ -1,5 +1,6 @@
 
 #include "systemc.h"
+#include "system.h"
 
 #ifndef MAT_MULT_IF_H
 #define MAT_MULT_IF_H
@@ -31,9 +32,37 @@
 #define GET_CMD_SIZE_COLS(cmd) ((cmd.size >>  0) & 0xF)
 #define GET_CMD_SIZE_NELS(cmd) ((cmd.size >> 15) & 0x7FFF)
 #define GET_CMD_SIZE_ROWS(cmd) ((cmd.size >>  4) & 0x7FF)
-#define GET_CMD_SIZE_SUBJ_COLS(cmd) ((GET_CMD_SIZE_COLS(cmd)) << 7)
-#define GET_CMD_SIZE_SUBJ_NELS(cmd) ((GET_CMD_SIZE_NELS(cmd)) << 7)
-#define GET_CMD_SIZE_SUBJ_ROWS(cmd) (GET_CMD_SIZE_ROWS(cmd))
+
+// reserved field values, extend the subject size beyond 1920x2047 (zero for smaller subjects)
+#define GET_CMD_RSVD_COLS(cmd) ((cmd.reserved >>  0) & 0xF)  // bits above the 4 bits of the size field
+#define GET_CMD_RSVD_ROWS(cmd) ((cmd.reserved >>  4) & 0x1F) // bits above the 11 bits of the size field
+
+// reserved field values for kernel commands, number of kernels in the filter bank (zero for a single kernel)
+#define GET_CMD_RSVD_KERN_BANK(cmd) ((cmd.reserved >> 0) & 0x7)
+#define GET_CMD_KERN_BANK(cmd) (GET_CMD_RSVD_KERN_BANK(cmd) + 1)
+
+// subject dimensions
+#define GET_CMD_SIZE_SUBJ_COLS(cmd) (((GET_CMD_RSVD_COLS(cmd) << 4) | GET_CMD_SIZE_COLS(cmd)) << 7)
+#define GET_CMD_SIZE_SUBJ_ROWS(cmd) ((GET_CMD_RSVD_ROWS(cmd) << 11) | GET_CMD_SIZE_ROWS(cmd))
+#define GET_CMD_SIZE_SUBJ_NELS(cmd) (GET_CMD_SIZE_SUBJ_ROWS(cmd) * GET_CMD_SIZE_SUBJ_COLS(cmd))
+
+// generate command field
+#define GEN_COMMAND(type, out_addr) \
+    ((type & 0b1) << 30) | ((out_addr & 0xffffffff) >> 3)
+
+// generate size field
+#define GEN_KERN_SIZE(rows, cols, n_kern) \
+    ((((rows * cols * n_kern) & 0x7fff) << 15) | ((rows & 0x7ff) << 4) | (cols & 0xf))
+#define GEN_SUBJ_SIZE(rows, cols) \
+    ((((rows * (cols >> 7)) & 0x7fff) << 15) | ((rows & 0x7ff) << 4)  | ((cols >> 7) & 0xf))
+
+// generate reserved field, with the filter bank size
+#define GEN_KERN_RSVD(n_kern) \
+    ((n_kern - 1) & 0x7)
+
+// generate reserved field, extending the subject size
+#define GEN_SUBJ_RSVD(rows, cols) \
+    ((((rows >> 11) & 0x1f) << 4) | ((cols >> 11) & 0xf))
 
 // calculate the checksum of a command packet
 #define CALC_CMD_CHKSUM(cmd) \
@@ -67,6 +96,16 @@ struct mat_mult_ack_t {
 
 #define N_PACKETS_IN_CMD sizeof(mat_mult_cmd_t) / sizeof(uint64_t)
 
+/** Command in the queue, from posting until its acknowledge packet is verified. */
+struct mat_mult_queue_entry_t {
+    mat_mult_cmd_t cmd;
+    uint8_t *ext_mem;   // CPU memory holding the payload
+    uint32_t in_addr;   // start address of the payload
+    uint32_t n_packets; // payload packets
+    bool outstanding;   // posted and not yet acknowledged
+    sc_time post_time;  // simulation time of posting
+};
+
 #define CMP_CMD_ACK(cmd, ack) ((cmd.s_key == ack.s_key) && (cmd.command == ack.command) && (cmd.size == ack.size) && (cmd.tx_addr == ack.tx_addr) && (cmd.trans_id == ack.trans_id) && (cmd.e_key == ack.e_key))
 
 // ==========================================
@@ -109,6 +148,10 @@ enum mat_mult_state_e {
 #define SIZE_PAYLOAD   0x80 // wrapped size
 #define SIZE_COMMAND   0x20
 
+// address of the `i`th packet of a burst starting at `addr`, wrapping within the payload or command window
+#define BURST_ADDR(addr, i) \
+    (((addr) & ~(uint64_t)(SIZE_PAYLOAD - 1)) | (((addr) + ((uint64_t)(i) << 3)) & (SIZE_PAYLOAD - 1)))
+
 /**
  * Interface with the matrix multiplier module to issue commands.
  */
@@ -120,24 +163,54 @@ class mat_mult_if : virtual public sc_interface {
         mat_mult_if();
 
         /**
-         * @brief Issue a command to the module to load a matrix.
+         * @brief Post a command to the queue and return without waiting for the module,
+         *        which decodes it when the previous commands are complete. Waits while
+         *        `QUEUE_DEPTH` commands are in flight.
          *
          * @param ext_mem  CPU memory which will eventually contain the acknowledge packet.
          * @param cmd_type `MM_CMD_KERN` or `MM_CMD_SUBJ`.
          * @param rows     Number of rows in the matrix.
          * @param cols     Number of columns in the matrix. Must be a multiple of 8.
-         * @param tx_addr  Where to write the acknowledge packet.
-         * @param out_addr Where to write the output matrix. Ignored for `MM_CMD_KERN`.
+         * @param tx_addr  Where to write the acknowledge packet, one per command in flight.
+         * @param out_addr Where to write the output matrix. Ignored for `MM_CMD_KERN`. With a
+         *                 filter bank, the output of each kernel follows the previous one.
          * @param in_addr  The start address of the payload in ext_mem.
+         * @param n_kern   Number of kernels in the filter bank, packed back to back in the
+         *                 payload. Ignored for `MM_CMD_SUBJ`.
+         * @retval The transaction ID of the command.
          */
-        void send_cmd(uint8_t *ext_mem, unsigned int cmd_type, unsigned int rows, unsigned int cols, unsigned int tx_addr, unsigned int out_addr, unsigned int in_addr);
+        uint32_t post_cmd(uint8_t *ext_mem, unsigned int cmd_type, unsigned int rows, unsigned int cols, unsigned int tx_addr, unsigned int out_addr, unsigned int in_addr, unsigned int n_kern = 1);
 
         /**
-         * @brief Verify the acknowledge packet in `ext_mem` at `tx_addr`.
+         * @brief Verify the acknowledge packet in `ext_mem` at `tx_addr` against the command
+         *        in flight with the same transaction ID.
          *
+         * @param trans_id Set to the transaction ID of the acknowledged command, if not null.
          * @retval The status in the acknowledge packet.
          */
-        int verify_ack(uint8_t *ext_mem, unsigned int tx_addr);
+        int verify_ack(uint8_t *ext_mem, unsigned int tx_addr, uint32_t *trans_id = nullptr);
+
+        /**
+         * @brief Verify one acknowledge packet written for any command in flight, so
+         *        commands can complete in any order.
+         *
+         * @param trans_id Set to the transaction ID of the acknowledged command.
+         * @retval The status in the acknowledge packet, or -1 if no command in flight
+         *         has been acknowledged.
+         */
+        int collect_ack(uint8_t *ext_mem, uint32_t *trans_id);
+
+        /** Number of commands posted and not yet acknowledged. */
+        uint32_t n_outstanding() const { return _n_outstanding; }
+
+        /** Largest number of commands in flight since the reset. */
+        uint32_t max_outstanding() const { return _max_outstanding; }
+
+        /** Time between posting and acknowledging the last verified command. */
+        sc_time last_latency() const { return _last_latency; }
+
+        /** Event notified when a command is acknowledged. */
+        const sc_event &ack_event() const { return _ack_event; }
 
         /** Total reset. */
         void reset();
@@ -147,16 +220,45 @@ class mat_mult_if : virtual public sc_interface {
         /** Receive a 64-bit `packet` on the module, addressed to `addr`. */
         virtual bool receive_packet(uint64_t addr, uint64_t packet) = 0;
 
+        /**
+         * @brief Receive a burst of `n` consecutive 64-bit packets on the module, the first one
+         *        addressed to `addr`. By default, each packet is passed to `receive_packet`.
+         */
+        virtual bool receive_packets(uint64_t addr, const uint64_t *packets, uint32_t n);
+
+        /**
+         * @brief Send the payload of `n` packets at `in_addr` in the CPU memory `ext_mem` to the
+         *        module. By default, the packets are passed in place to `receive_packets`.
+         */
+        virtual bool send_payload(uint8_t *ext_mem, uint64_t in_addr, uint32_t n);
+
         /** Subclass resets. */
         virtual void protected_reset() = 0;
 
+        /** Whether a posted command waits to be delivered. */
+        bool cmd_queued() const { return _deliver_trans_id != _cur_trans_id; }
+
+        /** Event notified when a command is posted. */
+        const sc_event &cmd_posted_event() const { return _posted_event; }
+
+        /** Deliver the oldest posted command to the module, header then payload. */
+        void deliver_cmd();
+
     private:
 
-        /** Variables to write to the module. */
-        uint32_t _cur_trans_id;
-        mat_mult_cmd_t _cmd;
+        /** Command queue, indexed by transaction ID modulo `QUEUE_DEPTH`. */
+        mat_mult_queue_entry_t _queue[MAX_QUEUE_DEPTH];
+        uint32_t _cur_trans_id;     // next transaction ID to post
+        uint32_t _deliver_trans_id; // next transaction ID to deliver
+        uint32_t _n_outstanding;
+        uint32_t _max_outstanding;
+        sc_time _last_latency;
+        sc_event _posted_event;
+        sc_event _ack_event;
         mat_mult_ack_t _ack;
-        uint64_t *_packets;
+
+        /** Build a command in the slot of the next transaction ID. */
+        uint32_t enqueue_cmd(uint8_t *ext_mem, unsigned int cmd_type, unsigned int rows, unsigned int cols, unsigned int tx_addr, unsigned int out_addr, unsigned int in_addr, unsigned int n_kern);
 
         /** Reset the module. */
         void private_reset();
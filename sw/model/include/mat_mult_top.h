@@ -17,6 +17,8 @@ class mat_mult_top : public mat_mult_if, public sc_module {
         sc_port<memory_if<uint64_t>> mem_if;
         sc_port<cmd_host_if> cmd_if;
 
+        SC_HAS_PROCESS(mat_mult_top);
+
         mat_mult_top(sc_module_name name);
 
     protected:
@@ -40,15 +42,92 @@ class mat_mult_top : public mat_mult_if, public sc_module {
         void calculate_next_state();
 
         /**
-         * @brief Assign _next_state to _cur_state.
+         * @brief Called when a kernel command of a legal size is decoded, so the
+         *        computation can be specialized for the kernel dimension.
+         *
+         * @param kern_dim Kernel dimension.
+         * @param n_kern   Number of kernels in the filter bank.
+         * @retval Whether the module supports the configuration. Filter banks are
+         *         rejected unless the subclass overrides this function.
+         */
+        virtual bool configure_kernel(uint8_t kern_dim, uint8_t n_kern) { return n_kern == 1; }
+
+        /**
+         * @brief Assign _next_state to _cur_state, and wake the queue thread once the
+         *        module accepts the next command.
          */
         void advance_state();
 
+        /**
+         * @brief Whether the packets are queued in an input FIFO and decoded in order,
+         *        so the next command can be delivered behind the payload of the current
+         *        one and its transfer overlaps the computation.
+         *
+         * @retval False unless the subclass overrides this function, the next command
+         *         is then delivered once the module is idle.
+         */
+        virtual bool queues_input() const { return false; }
+
         /**
          * @brief Write the current acknowledge packet to the command host, then issue an interrupt.
          */
         void write_ack();
 
+        /**
+         * @brief Notify the command host that the acknowledge packet is written. Issues
+         *        the interrupt unless the subclass defers it.
+         */
+        virtual void signal_ack();
+
+        /**
+         * @brief Write consecutive output packets to the external memory, directly
+         *        through a DMI grant when the memory gives one.
+         *
+         * @param addr    Address of the first packet.
+         * @param packets Packets to write.
+         * @param n       Number of packets.
+         */
+        void write_mem(uint64_t addr, const uint64_t *packets, uint64_t n);
+
+    private:
+
+        /** Grant of the external memory, requested on the first write. */
+        memory_dmi_t _mem_dmi;
+
+        /** Notified when the module accepts the next command, so the queue thread sleeps until then. */
+        sc_event _accept_event;
+
+        /** Commands delivered, and command headers decoded. */
+        uint64_t _n_delivered;
+        uint64_t _n_decoded;
+
+        /** Performance counters. */
+        uint64_t _output_packets; // 64-bit packets, whatever the size of the writes of a level
+        uint64_t _output_bytes;
+        uint64_t _ack_writes;
+
+        /** Whether the module completed its command and waits for the next one. */
+        bool idle() const {
+            return _cur_state == WAIT_CMD_SKEY && _regs.status_reg.ready;
+        }
+
+        /**
+         * Whether the module decoded the header of the last command delivered, and
+         * is idle or queues its input. At most one command waits behind the current one.
+         */
+        bool accepts_cmd() const {
+            return _n_decoded == _n_delivered && (idle() || queues_input());
+        }
+
+        /** Write consecutive packets to the external memory, uncounted. */
+        void store_mem(uint64_t addr, const uint64_t *packets, uint64_t n);
+
+        /**
+         * @brief Thread delivering the posted commands in order, each one once the
+         *        module accepts it.
+         */
+        void process_queue();
+
 };
 
 #endif // MAT_MULT_TOP_H
@@ -1,12 +1,42 @@
 
 #include "systemc.h"
 #include "sc_trace.hpp"
+#include "perf_counters.h"
 
 #include <math.h>
+#include <string.h>
 
 #ifndef MEM_IF_HPP
 #define MEM_IF_HPP
 
+// access statistics, 0 compiles the counting out of the read and write paths
+#ifndef MEM_IF_STATS
+    #define MEM_IF_STATS 1
+#endif
+
+// default statistics granularity, accesses are counted per bucket of 2^bits addresses (a cache line)
+#define MEM_IF_BUCKET_BITS 6
+
+/**
+ * Direct memory interface grant, similar to TLM-2.0 DMI: a host pointer to a
+ * region of the memory which the holder may access without calling `read` or
+ * `write`. A grant is valid until the memory invalidates it.
+ */
+struct memory_dmi_t {
+    uint8_t *ptr = nullptr;  // host pointer to `start_addr`
+    uint64_t start_addr = 0; // first address of the region
+    uint64_t end_addr = 0;   // last address of the region
+    bool read_allowed = false;
+    bool write_allowed = false;
+    bool refused = false;    // the memory gave no grant
+    uint64_t generation = 0; // invalidation generation of the memory when granted or refused
+
+    /** Whether the `n` addresses from `addr` are in the region. */
+    bool covers(uint64_t addr, uint64_t n) const {
+        return ptr && n && addr >= start_addr && addr + n - 1 <= end_addr;
+    }
+};
+
 /**
  * Interface with memory to be overridden for different abstraction levels.
  *
@@ -18,23 +48,35 @@ class memory_if : virtual public sc_interface {
 
     public:
 
-        memory_if(sc_module_name name, uint32_t mem_size) : _name(name), _mem_size(mem_size)
+        /**
+         * @brief Constructor.
+         *
+         * @param name        Name in the traces and reports.
+         * @param mem_size    Number of addresses.
+         * @param bucket_bits Accesses are counted per bucket of `2^bucket_bits` consecutive addresses.
+         */
+        memory_if(sc_module_name name, uint64_t mem_size, uint8_t bucket_bits = MEM_IF_BUCKET_BITS)
+            : _name(name), _mem_size(mem_size), _addr_step(1), _bucket_bits(bucket_bits), _n_buckets(0), _reads(nullptr), _writes(nullptr), _n_reads(0), _n_writes(0), _bytes_read(0), _bytes_written(0), _dmi_generation(0)
         {
             if (mem_size) {
-                _reads = new uint32_t[mem_size];
-                _writes = new uint32_t[mem_size];
+#if MEM_IF_STATS
+                _n_buckets = ((mem_size - 1) >> bucket_bits) + 1;
+                _reads = new uint64_t[_n_buckets]();
+                _writes = new uint64_t[_n_buckets]();
+#endif
 
                 sc_tracer::trace(_raddr, _name, "raddr");
                 sc_tracer::trace(_waddr, _name, "waddr");
                 sc_tracer::trace(_mem_size, _name, "size");
+
+                perf_counters::add((const char*)_name, "bytes_read", &_bytes_read);
+                perf_counters::add((const char*)_name, "bytes_written", &_bytes_written);
             }
         }
 
         virtual ~memory_if() noexcept {
-            if (_mem_size) {
-                delete _reads;
-                delete _writes;
-            }
+            delete[] _reads;
+            delete[] _writes;
         }
 
         /**
@@ -46,8 +88,12 @@ class memory_if : virtual public sc_interface {
          */
         bool read(addr_t addr, data_t& data) {
             bool success = do_read(addr, data);
-            if (success) _reads[addr] += 1;
+#if MEM_IF_STATS
+            if (success) count(_reads, _n_reads, addr);
+#endif
+            if (success) _bytes_read += sizeof(data_t);
             _raddr = addr;
+            sc_tracer::update(_raddr);
             return success;
         }
 
@@ -60,40 +106,192 @@ class memory_if : virtual public sc_interface {
          */
         bool write(addr_t addr, data_t data){
             bool success = do_write(addr, data);
-            if (success) _writes[addr] += 1;
+#if MEM_IF_STATS
+            if (success) count(_writes, _n_writes, addr);
+#endif
+            if (success) _bytes_written += sizeof(data_t);
+            _waddr = addr;
+            sc_tracer::update(_waddr);
+            return success;
+        }
+
+        /**
+         * Read a block of consecutive words from the memory.
+         *
+         * @param addr The address of the first word.
+         * @param data Buffer holding the output.
+         * @param n    Number of words.
+         * @retval     Whether the read was successful.
+         */
+        bool read_block(addr_t addr, data_t *data, uint64_t n) {
+            bool success = do_read_block(addr, data, n);
+#if MEM_IF_STATS
+            if (success) count_block(_reads, _n_reads, addr, n);
+#endif
+            if (success) _bytes_read += n * sizeof(data_t);
+            _raddr = addr;
+            sc_tracer::update(_raddr);
+            return success;
+        }
+
+        /**
+         * Write a block of consecutive words to the memory.
+         *
+         * @param addr The address of the first word.
+         * @param data The data to write.
+         * @param n    Number of words.
+         * @retval     Whether the write was successful.
+         */
+        bool write_block(addr_t addr, const data_t *data, uint64_t n) {
+            bool success = do_write_block(addr, data, n);
+#if MEM_IF_STATS
+            if (success) count_block(_writes, _n_writes, addr, n);
+#endif
+            if (success) _bytes_written += n * sizeof(data_t);
             _waddr = addr;
+            sc_tracer::update(_waddr);
             return success;
         }
 
+        /**
+         * Request a direct memory interface grant for the region containing `addr`.
+         *
+         * @param addr The address to access.
+         * @param dmi  The grant, only valid if the request succeeds.
+         * @retval     Whether the memory granted direct access.
+         */
+        bool get_direct_mem_ptr(addr_t addr, memory_dmi_t &dmi) {
+            dmi.refused = !do_get_direct_mem_ptr(addr, dmi);
+            dmi.generation = _dmi_generation;
+            return !dmi.refused;
+        }
+
+        /** Whether a grant has not been invalidated since it was given. */
+        bool dmi_valid(const memory_dmi_t &dmi) const {
+            return dmi.ptr && dmi.generation == _dmi_generation;
+        }
+
+        /**
+         * Whether a grant or a refusal was given since the last invalidation, so
+         * the holder need not request it again.
+         */
+        bool dmi_current(const memory_dmi_t &dmi) const {
+            return (dmi.ptr || dmi.refused) && dmi.generation == _dmi_generation;
+        }
+
+        /** Invalidate all the direct memory interface grants, when the backing of the memory changes. */
+        void invalidate_dmi() {
+            _dmi_generation++;
+        }
+
+        /**
+         * Count `n` words accessed from `addr` through a direct memory interface
+         * grant, so the statistics include them.
+         */
+        void count_dmi(addr_t addr, uint64_t n, bool is_write) {
+            dmi_accessed(addr, n, is_write);
+#if MEM_IF_STATS
+            if (is_write) count_block(_writes, _n_writes, addr, n);
+            else count_block(_reads, _n_reads, addr, n);
+#endif
+            if (is_write) {
+                _bytes_written += n * sizeof(data_t);
+                _waddr = addr;
+                sc_tracer::update(_waddr);
+            }
+            else {
+                _bytes_read += n * sizeof(data_t);
+                _raddr = addr;
+                sc_tracer::update(_raddr);
+            }
+        }
+
         void print_report() {
             std::cout << "Memory " << _name << std::endl;
-            analyze_array("Reads", _reads, _mem_size);
-            analyze_array("Writes", _writes, _mem_size);
+#if MEM_IF_STATS
+            analyze_array("Reads", _reads, _n_reads);
+            analyze_array("Writes", _writes, _n_writes);
+#else
+            std::cout << "Statistics compiled out (MEM_IF_STATS=0)" << std::endl;
+#endif
         }
 
     protected:
 
         /** Statistics. */
         sc_module_name _name;
-        uint32_t _mem_size;
+        uint64_t _mem_size;
+        uint64_t _addr_step; // address increment between consecutive words
         addr_t _raddr;
         addr_t _waddr;
-        uint32_t *_reads;
-        uint32_t *_writes;
+        uint8_t _bucket_bits;
+        uint64_t _n_buckets;
+        uint64_t *_reads;  // accesses per bucket
+        uint64_t *_writes;
+        uint64_t _n_reads; // accesses in total
+        uint64_t _n_writes;
+        uint64_t _bytes_read; // performance counters
+        uint64_t _bytes_written;
+        uint64_t _dmi_generation;
 
         /** Subclass methods specify internal functionality of the memory. */
         virtual bool do_write(addr_t addr, data_t data) = 0;
         virtual bool do_read(addr_t addr, data_t& data) = 0;
 
+        /** Block transfers, word by word unless the subclass overrides them. */
+        virtual bool do_read_block(addr_t addr, data_t *data, uint64_t n) {
+            for (uint64_t i = 0; i < n; ++i) {
+                if (!do_read((addr_t)(addr + i * _addr_step), data[i])) return false;
+            }
+            return true;
+        }
+        virtual bool do_write_block(addr_t addr, const data_t *data, uint64_t n) {
+            for (uint64_t i = 0; i < n; ++i) {
+                if (!do_write((addr_t)(addr + i * _addr_step), data[i])) return false;
+            }
+            return true;
+        }
+
+        /** Direct memory interface, not granted unless the subclass overrides it. */
+        virtual bool do_get_direct_mem_ptr(addr_t addr, memory_dmi_t &dmi) {
+            return false;
+        }
+
+        /** Called for the accesses through a grant, so the subclass can account for them. */
+        virtual void dmi_accessed(addr_t addr, uint64_t n, bool is_write) {
+        }
+
     private:
 
-        void analyze_array(const char *arr_name, uint32_t *arr, uint32_t n) {
+        /** Count an access to `addr`. */
+        void count(uint64_t *arr, uint64_t &total, addr_t addr) {
+            uint64_t bucket = (uint64_t)addr >> _bucket_bits;
+            if (bucket < _n_buckets) arr[bucket] += 1;
+            total += 1;
+        }
+
+        /** Count `n` consecutive words from `addr`, bucket by bucket. */
+        void count_block(uint64_t *arr, uint64_t &total, addr_t addr, uint64_t n) {
+            uint64_t a = (uint64_t)addr;
+            uint64_t end = a + n * _addr_step;
+            while (a < end) {
+                uint64_t bucket = a >> _bucket_bits;
+                uint64_t bucket_end = (bucket + 1) << _bucket_bits;
+                uint64_t words = ((bucket_end < end ? bucket_end : end) - a + _addr_step - 1) / _addr_step;
+                if (bucket < _n_buckets) arr[bucket] += words;
+                a += words * _addr_step;
+            }
+            total += n;
+        }
+
+        void analyze_array(const char *arr_name, const uint64_t *arr, uint64_t total) {
+            uint64_t n = _n_buckets;
             double mean = 0.0;
             double max = 0.0;
             double stddev = 0.0;
 
             // calculate mean
-            for (uint32_t i = 0; i < n; ++i) {
+            for (uint64_t i = 0; i < n; ++i) {
                 mean += (double)arr[i];
                 if (arr[i] > max) {
                     max = (double)arr[i];
@@ -102,13 +300,13 @@ class memory_if : virtual public sc_interface {
             mean /= (double)n;
 
             // calculate standard deviation
-            for (uint32_t i = 0; i < n; ++i) {
-                double var = arr[i] - mean;
+            for (uint64_t i = 0; i < n; ++i) {
+                double var = (double)arr[i] - mean;
                 stddev += var * var;
             }
-            stddev = sqrt(stddev / (double)(n - 1));
+            stddev = n > 1 ? sqrt(stddev / (double)(n - 1)) : 0.0;
 
-            std::cout << arr_name << " per address: Mean " << mean << ", maximum " << max << ", stddev " << stddev << std::endl;
+            std::cout << arr_name << " per " << (1ull << _bucket_bits) << " addresses: Mean " << mean << ", maximum " << max << ", stddev " << stddev << ", total " << total << std::endl;
         }
 
 };
@@ -125,27 +323,55 @@ class simple_memory_mod : public sc_module, public memory_if<data_t, addr_t> {
     public:
 
         simple_memory_mod(sc_module_name name, uint8_t *memory, uint64_t mem_size)
-            : sc_module(name), memory_if<data_t, addr_t>(name, mem_size), memory(memory), mem_size(mem_size) {}
+            : sc_module(name), memory_if<data_t, addr_t>(name, mem_size), memory(memory), mem_size(mem_size)
+        {
+            // byte addresses
+            this->_addr_step = sizeof(data_t);
+        }
 
     private:
 
         bool do_read(addr_t addr, data_t& data) {
-            if (!check_addr(addr)) return false;
-            data = *(addr_t*)(memory + addr);
+            if (!check_addr(addr, 1)) return false;
+            data = *(data_t*)(memory + addr);
             return true;
         }
 
         bool do_write(addr_t addr, data_t data) {
-            if (!check_addr(addr)) return false;
+            if (!check_addr(addr, 1)) return false;
             *((data_t*)(memory + addr)) = data;
             return true;
         }
 
+        bool do_read_block(addr_t addr, data_t *data, uint64_t n) {
+            if (!check_addr(addr, n)) return false;
+            memcpy(data, memory + addr, n * sizeof(data_t));
+            return true;
+        }
+
+        bool do_write_block(addr_t addr, const data_t *data, uint64_t n) {
+            if (!check_addr(addr, n)) return false;
+            memcpy(memory + addr, data, n * sizeof(data_t));
+            return true;
+        }
+
+        /** The whole memory is granted. */
+        bool do_get_direct_mem_ptr(addr_t addr, memory_dmi_t &dmi) {
+            if (!check_addr(addr, 1)) return false;
+            dmi.ptr = memory;
+            dmi.start_addr = 0;
+            dmi.end_addr = mem_size - 1;
+            dmi.read_allowed = true;
+            dmi.write_allowed = true;
+            return true;
+        }
+
         uint8_t *memory;
         uint64_t mem_size;
 
-        bool check_addr(uint64_t addr) {
-            return addr < mem_size;
+        /** Whether the `n` words from `addr` are in the memory. */
+        bool check_addr(uint64_t addr, uint64_t n) {
+            return addr < mem_size && n * sizeof(data_t) <= mem_size - addr;
         }
 
 };
@@ -0,0 +1,115 @@
+#include <stdint.h>
+#include <stdio.h>
+#include <string>
+#include <vector>
+
+#ifndef PERF_COUNTERS_H
+#define PERF_COUNTERS_H
+
+// register file of the counters, one 64-bit register per counter
+#define PERF_REG_BASE   0x0
+#define PERF_REG_STRIDE 8
+
+// counters whose name ends with this are cycle counts, reported as a fraction of the run
+#define PERF_CYCLES_SUFFIX "_cycles"
+#define PERF_BUSY_SUFFIX   "busy_cycles"
+#define PERF_IDLE_SUFFIX   "idle_cycles" // derived from the busy cycles, as idle modules may sleep
+
+// registered counter
+struct perf_reg_t {
+    std::string name;     // module path and counter name, separated by a dot
+    const uint64_t *value; // owned by the module, which increments it
+};
+
+// configuration value of the run, reported with the counters
+struct perf_config_t {
+    std::string name;
+    uint64_t value;
+};
+
+// values of all the registers at a point of the run
+struct perf_sample_t {
+    double time_ns;
+    std::vector<uint64_t> values;
+};
+
+/**
+ * Hardware performance counters of the models. A module owns its counters as
+ * plain 64-bit members which it increments on its own, and registers their
+ * addresses once, so the counting costs no more than an add. The counters are
+ * then readable like a register file, one register per counter in the order
+ * of registration, and are written as JSON at the end of the run, with
+ * optional samples every `period` core cycles.
+ */
+class perf_counters; // forward declaration for global singleton
+class perf_counters {
+
+    public:
+
+        /** Global singleton instance */
+        static perf_counters counters;
+
+        perf_counters();
+
+        /**
+         * @brief Register a counter.
+         *
+         * @param module Path of the module owning the counter.
+         * @param name   Name of the counter in the module.
+         * @param value  Counter, valid until the end of the run.
+         * @retval       Address of the register of the counter.
+         */
+        static uint32_t add(const std::string &module, const char *name, const uint64_t *value);
+
+        /**
+         * @brief Read a register.
+         *
+         * @param addr Address of the register.
+         * @param data Value of the counter.
+         * @retval     Whether a counter is mapped at the address.
+         */
+        static bool read(uint32_t addr, uint64_t &data);
+
+        /**
+         * @brief Find the register of a counter.
+         *
+         * @param name Full name of the counter, `<module>.<counter>`.
+         * @param addr Address of the register.
+         * @retval     Whether the counter is registered.
+         */
+        static bool find(const std::string &name, uint32_t &addr);
+
+        /** Record a configuration value of the run, a value set twice keeps the last. */
+        static void set_config(const char *name, uint64_t value);
+
+        /**
+         * @brief Set the output of the counters, nothing is written by default.
+         *
+         * @param file   Path of the JSON file.
+         * @param period Core cycles between samples, 0 for the final values only.
+         * @retval       Whether the file was opened.
+         */
+        static bool configure(const std::string &file, uint64_t period);
+
+        /** Sample the registers at the current simulation time. */
+        static void sample();
+
+        /** Take the final sample and write the file. */
+        static void finish();
+
+    private:
+
+        std::vector<perf_reg_t> _regs;
+        std::vector<perf_config_t> _config;
+        std::vector<perf_sample_t> _samples;
+        FILE *_out;
+
+        /** Write the JSON document. */
+        void write_json();
+
+        /** Write a cycle count of the summary and its fraction of `total`. */
+        void write_cycles(const std::string &name, uint64_t n, uint64_t total);
+
+};
+
+#endif // PERF_COUNTERS_H
@@ -0,0 +1,114 @@
+
+#include "systemc.h"
+
+#include <iostream>
+
+#ifndef QUANTUM_KEEPER_HPP
+#define QUANTUM_KEEPER_HPP
+
+/**
+ * Local time of a temporally decoupled process, in the style of
+ * `tlm_utils::tlm_quantumkeeper`. The process runs ahead of the simulation
+ * time by accumulating its delays, and only waits when the local time
+ * reaches the end of the current global quantum or before a hand-off with
+ * another process. A null global quantum disables the decoupling.
+ */
+class quantum_keeper {
+
+    public:
+
+        /** Set the global quantum shared by all the keepers. */
+        static void set_global_quantum(const sc_time &quantum) {
+            global_quantum() = quantum;
+        }
+
+        static const sc_time &get_global_quantum() {
+            return global_quantum();
+        }
+
+        quantum_keeper()
+            : _local_time(SC_ZERO_TIME), _next_sync_point(SC_ZERO_TIME), _n_syncs(0), _max_offset(SC_ZERO_TIME), _total_offset(SC_ZERO_TIME)
+        {
+        }
+
+        /** Add a delay to the local time. */
+        void inc(const sc_time &t) {
+            _local_time += t;
+        }
+
+        /** Offset of the local time ahead of the simulation time. */
+        sc_time get_local_time() const {
+            return _local_time;
+        }
+
+        /** Time of the process. */
+        sc_time get_current_time() const {
+            return sc_time_stamp() + _local_time;
+        }
+
+        /** Whether the local time reached the end of the current quantum. */
+        bool need_sync() const {
+            return sc_time_stamp() + _local_time >= _next_sync_point;
+        }
+
+        /** Wait until the simulation time catches up with the local time. */
+        void sync() {
+            if (_local_time != SC_ZERO_TIME) {
+                // statistics
+                _n_syncs++;
+                _total_offset += _local_time;
+                if (_local_time > _max_offset) _max_offset = _local_time;
+
+                wait(_local_time);
+                _local_time = SC_ZERO_TIME;
+            }
+            compute_next_sync_point();
+        }
+
+        /** Drop the local time and start a new quantum. */
+        void reset() {
+            _local_time = SC_ZERO_TIME;
+            compute_next_sync_point();
+        }
+
+        /**
+         * @brief Print the synchronizations and how far the process ran ahead of the
+         *        simulation time, which bounds the timing error of its transactions.
+         */
+        void print_report(const char *name) const {
+            std::cout << "Quantum keeper " << name << ": quantum " << get_global_quantum() << ", " << _n_syncs << " synchronizations";
+            if (_n_syncs) {
+                std::cout << ", ahead by " << (_total_offset / (double)_n_syncs) << " on average and at most " << _max_offset;
+            }
+            std::cout << std::endl;
+        }
+
+    private:
+
+        /** Function-local so the header does not need a definition in a source file. */
+        static sc_time &global_quantum() {
+            static sc_time quantum = SC_ZERO_TIME;
+            return quantum;
+        }
+
+        /** The quanta are aligned to multiples of the global quantum, as in TLM-2.0. */
+        void compute_next_sync_point() {
+            const sc_time &quantum = get_global_quantum();
+            if (quantum == SC_ZERO_TIME) {
+                _next_sync_point = sc_time_stamp();
+                return;
+            }
+            _next_sync_point = sc_time::from_value((sc_time_stamp().value() / quantum.value() + 1) * quantum.value());
+        }
+
+        sc_time _local_time;
+        sc_time _next_sync_point;
+
+        /** Statistics. */
+        uint64_t _n_syncs;
+        sc_time _max_offset;
+        sc_time _total_offset;
+
+};
+
+#endif // QUANTUM_KEEPER_HPP
@@ -0,0 +1,254 @@
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <atomic>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <type_traits>
+
+#ifndef SC_LOG_H
+#define SC_LOG_H
+
+// severity levels, lower is more severe
+#define LOG_LVL_ERROR 0
+#define LOG_LVL_WARN  1
+#define LOG_LVL_INFO  2
+#define LOG_LVL_DEBUG 3
+
+// most verbose level compiled in, the calls above it compile to nothing
+#ifndef LOG_LEVEL
+#define LOG_LEVEL LOG_LVL_DEBUG
+#endif
+
+// ring of records between the simulation and the writer thread
+#define LOG_RING_N_BITS 12
+#define LOG_RING_SIZE (1 << LOG_RING_N_BITS)
+#define LOG_RING_PTR_MASK (LOG_RING_SIZE - 1)
+
+// record capacity
+#define LOG_MAX_ARGS 16
+#define LOG_STR_SIZE 128   // string arguments and preformatted messages
+#define LOG_STR_TRUNC "..." // end of a truncated preformatted message
+#define LOG_MODULE_SIZE 48
+#define LOG_MAX_RULES 16
+
+// binary log file
+#define LOG_BIN_MAGIC "SCLOG\x01"
+#define LOG_BIN_NO_FMT 0xFFFFFFFF
+
+// types of the arguments captured in a record
+enum log_arg_type_e {
+    LOG_ARG_INT,
+    LOG_ARG_UINT,
+    LOG_ARG_DOUBLE,
+    LOG_ARG_PTR,
+    LOG_ARG_STR
+};
+
+// argument captured in a record, formatted by the writer thread
+struct log_arg_t {
+    uint8_t type;
+    union {
+        int64_t i;
+        uint64_t u;
+        double d;
+        const void *p;
+        uint32_t str; // offset in the string area of the record
+    };
+};
+
+// log record, the format string is a literal so only its address is kept
+struct log_record_t {
+    uint64_t time;        // simulation time, in time resolution units
+    const char *fmt;      // nullptr for a preformatted message in `str`
+    uint8_t level;
+    uint8_t n_args;
+    uint16_t str_len;     // bytes used in `str`
+    char module[LOG_MODULE_SIZE];
+    log_arg_t args[LOG_MAX_ARGS];
+    char str[LOG_STR_SIZE];
+};
+
+// slot of the ring, `seq` tells whether it holds a record for the writer
+struct log_slot_t {
+    std::atomic<uint64_t> seq;
+    log_record_t rec;
+};
+
+// runtime filter of a module, a trailing `*` matches any suffix
+struct log_rule_t {
+    char pattern[LOG_MODULE_SIZE];
+    uint32_t len;
+    bool prefix;
+    int level;
+};
+
+/**
+ * Asynchronous logger. The simulation captures the format string and the raw
+ * arguments of a record in a lock-free ring, and a writer thread formats them
+ * and writes them out, so logging costs no I/O on the simulation thread.
+ */
+class sc_logger; // forward declaration for global singleton
+class sc_logger {
+
+    public:
+
+        /** Global singleton instance */
+        static sc_logger logger;
+
+        sc_logger();
+        ~sc_logger();
+
+        /**
+         * @brief Set the filters and the output of the logs.
+         *
+         * @param filters Comma-separated `[<MODULE>:]<LEVEL>` rules, where the level is
+         *                `error`, `warn`, `info` or `debug`. A rule without a module
+         *                sets the default level, and the last rule matching a module
+         *                applies.
+         * @param file    Output file, empty for the standard output.
+         * @param binary  Write raw records, see `scripts/logdec.py`.
+         *
+         * @retval Whether the options are valid and the file was opened.
+         */
+        static bool configure(const std::string &filters, const std::string &file, bool binary);
+
+        /** Whether a record of `level` from `module` is kept. */
+        static bool enabled(int level, const char *module) {
+            if (level > logger._max_level) return false;
+            if (!logger._n_rules) return true;
+            return logger.module_enabled(level, module);
+        }
+
+        /**
+         * @brief Queue a record, its arguments are formatted by the writer thread.
+         *        Only the pointer to `fmt` is stored, so it must be a string literal.
+         */
+        template <typename... Args>
+        static void logf(int level, const char *module, const char *fmt, const Args&... args) {
+            static_assert(sizeof...(Args) <= LOG_MAX_ARGS, "too many log arguments");
+
+            uint64_t pos;
+            log_record_t *rec = logger.acquire(&pos);
+            rec->time = now();
+            rec->fmt = fmt;
+            rec->level = (uint8_t)level;
+            rec->n_args = 0;
+            rec->str_len = 0;
+            copy_str(rec->module, module, LOG_MODULE_SIZE);
+            (capture(rec, args), ...);
+            logger.release(pos);
+        }
+
+        /** Queue a preformatted record, cut to LOG_STR_SIZE bytes with a trailing LOG_STR_TRUNC. */
+        static void log_str(int level, const char *module, const std::string &msg);
+
+        /** Block until the writer thread wrote all the queued records. */
+        static void flush();
+
+    private:
+
+        // filters, set before the simulation starts
+        int _default_level;
+        int _max_level;
+        uint32_t _n_rules;
+        log_rule_t _rules[LOG_MAX_RULES];
+
+        // ring, multiple producers and the writer thread as the consumer
+        log_slot_t *_ring;
+        std::atomic<uint64_t> _enq;
+        uint64_t _deq;
+        std::atomic<uint64_t> _written; // records written and flushed
+
+        // writer thread
+        std::atomic<bool> _started;
+        std::atomic<bool> _stop;
+        std::once_flag _start_flag;
+        std::thread _writer;
+        double _res_ns; // time resolution
+        FILE *_out;
+        bool _binary;
+
+        /** Match `module` against the rules. */
+        bool module_enabled(int level, const char *module) const;
+
+        /** Reserve a slot, wait while the ring is full. */
+        log_record_t *acquire(uint64_t *pos);
+
+        /** Hand the slot reserved at `pos` to the writer thread. */
+        void release(uint64_t pos) {
+            _ring[pos & LOG_RING_PTR_MASK].seq.store(pos + 1, std::memory_order_release);
+        }
+
+        /** Start the writer thread on the first record. */
+        void start();
+
+        /** Writer thread, drain the ring until stopped. */
+        void drain();
+
+        /** Write a record as text or binary. */
+        void write_text(const log_record_t &rec);
+        void write_binary(const log_record_t &rec);
+
+        /** Current simulation time, in time resolution units. */
+        static uint64_t now();
+
+        /** Copy a string with truncation, return the bytes copied without the terminator. */
+        static uint32_t copy_str(char *dst, const char *src, uint32_t size) {
+            uint32_t n = 0;
+            if (src) {
+                while (n + 1 < size && src[n]) {
+                    dst[n] = src[n];
+                    n++;
+                }
+            }
+            if (size) dst[n] = '\0';
+            return n;
+        }
+
+        /** Capture an argument in the record. */
+        template <typename T>
+        static void capture(log_record_t *rec, const T &value) {
+            log_arg_t &arg = rec->args[rec->n_args++];
+            if constexpr (std::is_convertible<const T&, const char*>::value) {
+                arg.type = LOG_ARG_STR;
+                arg.str = rec->str_len;
+                if (rec->str_len < LOG_STR_SIZE) {
+                    rec->str_len += copy_str(rec->str + rec->str_len, value, LOG_STR_SIZE - rec->str_len) + 1;
+                }
+                else {
+                    arg.str = LOG_STR_SIZE - 1; // truncated to the terminator of the last string
+                }
+            }
+            else if constexpr (std::is_floating_point<T>::value) {
+                arg.type = LOG_ARG_DOUBLE;
+                arg.d = (double)value;
+            }
+            else if constexpr (std::is_enum<T>::value || (std::is_integral<T>::value && std::is_signed<T>::value)) {
+                arg.type = LOG_ARG_INT;
+                arg.i = (int64_t)value;
+            }
+            else if constexpr (std::is_integral<T>::value) {
+                arg.type = LOG_ARG_UINT;
+                arg.u = (uint64_t)value;
+            }
+            else {
+                static_assert(std::is_pointer<T>::value, "unsupported log argument");
+                arg.type = LOG_ARG_PTR;
+                arg.p = (const void*)value;
+            }
+        }
+
+};
+
+// level-filtered logging, `module` names the source for the runtime filters and the format is a string literal
+#define LOG_AT(level, module, ...) do { \
+        if ((level) <= LOG_LEVEL && sc_logger::enabled(level, module)) sc_logger::logf(level, module, __VA_ARGS__); \
+    } while (0)
+#define LOG_ERROR(module, ...) LOG_AT(LOG_LVL_ERROR, module, __VA_ARGS__)
+#define LOG_WARN(module, ...)  LOG_AT(LOG_LVL_WARN, module, __VA_ARGS__)
+#define LOG_INFO(module, ...)  LOG_AT(LOG_LVL_INFO, module, __VA_ARGS__)
+#define LOG_DEBUG(module, ...) LOG_AT(LOG_LVL_DEBUG, module, __VA_ARGS__)
+
+#endif // SC_LOG_H
@@ -1,12 +1,136 @@
 
+#include <fnmatch.h>
 #include <map>
 #include <sstream>
+#include <string>
+#include <type_traits>
+#include <unordered_map>
+#include <vector>
 
 #include "systemc.h"
+#include "sc_wave.h"
 
 #ifndef SC_TRACE_HPP
 #define SC_TRACE_HPP
 
+// trace backends
+enum sc_trace_format_e {
+    TRACE_FMT_VCD, // SystemC VCD, every traced value for the whole run
+    TRACE_FMT_WAVE // compressed waveform of sc_wave_writer, within a capture window
+};
+
+// capture window trigger counting the simulation time, in ns
+#define TRACE_TRIGGER_TIME "ns"
+
+/** Width and kind of a value in the waveform, only integers and logic values are supported. */
+template <class T>
+struct wave_type {
+    static const bool supported = std::is_integral<T>::value || std::is_enum<T>::value;
+    static const uint32_t width = sizeof(T) * 8;
+    static const wave_kind_e kind = WAVE_KIND_INT;
+};
+template <>
+struct wave_type<bool> {
+    static const bool supported = true;
+    static const uint32_t width = 1;
+    static const wave_kind_e kind = WAVE_KIND_INT;
+};
+template <>
+struct wave_type<sc_logic> {
+    static const bool supported = true;
+    static const uint32_t width = 1;
+    static const wave_kind_e kind = WAVE_KIND_LOGIC;
+};
+
+/** Value of a signal in the waveform. */
+template <class T>
+inline uint64_t wave_value(const T &value) {
+    return (uint64_t)value;
+}
+inline uint64_t wave_value(const sc_logic &value) {
+    switch (value.to_char()) {
+    case '0': return WAVE_LOGIC_0;
+    case '1': return WAVE_LOGIC_1;
+    case 'Z': return WAVE_LOGIC_Z;
+    default:  return WAVE_LOGIC_X;
+    }
+}
+
+// traced variable, its changes are reported with `sc_tracer::update`
+struct wave_var_t {
+    const void *ptr;
+    uint64_t (*read)(const void *ptr);
+    uint32_t id;
+};
+
+template <class T>
+uint64_t wave_read_var(const void *ptr) {
+    return wave_value(*(const T*)ptr);
+}
+
+/**
+ * Capture window of the waveform. It opens when its trigger reaches `start`
+ * and closes `length` units later, or at the end of the run if `length` is 0.
+ * The time trigger is counted by the window itself, the others are reported
+ * by the models with `sc_tracer::trigger`.
+ */
+class sc_wave_window : public sc_module {
+
+    public:
+
+        SC_HAS_PROCESS(sc_wave_window);
+
+        sc_wave_window(sc_module_name name, const std::string &trigger, uint64_t start, uint64_t length)
+            : sc_module(name), _trigger(trigger), _start(start), _length(length), _opened(false), _closed(false)
+        {
+            if (_trigger == TRACE_TRIGGER_TIME) {
+                SC_THREAD(count_time);
+            }
+        }
+
+        /** Events of the window, notified a delta cycle after it opens or closes. */
+        const sc_event &open_event() const { return _open_event; }
+        const sc_event &close_event() const { return _close_event; }
+
+        /** Whether the window still follows `trigger`. */
+        bool follows(const char *trigger) const {
+            return !_closed && _trigger == trigger;
+        }
+
+        /** New value of the trigger. */
+        void on_trigger(uint64_t value) {
+            if (!_opened && value >= _start) open();
+            if (_opened && _length && value >= _start + _length) close();
+        }
+
+    private:
+
+        sc_event _open_event;
+        sc_event _close_event;
+        std::string _trigger;
+        uint64_t _start;
+        uint64_t _length;
+        bool _opened;
+        bool _closed;
+
+        /** Open and close the window on the simulation time. */
+        void count_time() {
+            if (_start) wait(sc_time((double)_start, SC_NS));
+            open();
+            if (_length) {
+                wait(sc_time((double)_length, SC_NS));
+                close();
+            }
+        }
+
+        void open();
+        void close();
+
+};
+
+template <class T>
+class sc_wave_probe;
+
 /** SystemC signal and variable tracer wrapper. */
 class sc_tracer; // forward declaration for global singleton
 class sc_tracer {
@@ -25,13 +149,54 @@ class sc_tracer {
             }
         }
 
+        /**
+         * @brief Initializer of the compressed waveform, captured within a window.
+         *
+         * @param out_file Output file, without the WAVE_EXT extension.
+         * @param trigger  Trigger of the window, TRACE_TRIGGER_TIME for the simulation time.
+         * @param start    Value of the trigger opening the window.
+         * @param length   Units of the trigger the window stays open for, 0 until the end.
+         * @retval         Whether the file was opened.
+         */
+        static bool init_wave(const char *out_file, const std::string &trigger, uint64_t start, uint64_t length) {
+            if (!tracer._enabled) return true;
+
+            std::string file = std::string(out_file) + WAVE_EXT;
+            std::cout << "Opening waveform " << file << std::endl;
+            if (!tracer._wave.open(file.c_str(), sc_get_time_resolution().to_seconds() * 1e9)) {
+                std::cerr << "*** ERROR in main: cannot open waveform " << file << std::endl;
+                return false;
+            }
+            tracer._format = TRACE_FMT_WAVE;
+            tracer._capture_id = tracer._wave.add_signal("tracer.capture", 1, WAVE_KIND_INT);
+            tracer._window = new sc_wave_window("wave_window", trigger, start, length);
+            return true;
+        }
+
+        /** Only trace the values whose `<module>.<signal>` name matches one of the comma-separated globs. */
+        static void filter(const std::string &globs) {
+            size_t start = 0;
+            while (start < globs.size()) {
+                size_t end = globs.find(',', start);
+                if (end == std::string::npos) end = globs.size();
+                if (end > start) tracer._globs.push_back(globs.substr(start, end - start));
+                start = end + 1;
+            }
+        }
+
         /** Trace a signal. */
         template <class T>
         static void trace(T& value, sc_module_name module_name, const char *signal_name) {
             if (tracer._enabled) {
                 std::ostringstream ss;
                 ss << module_name << "." << signal_name;
-                sc_trace(tracer._tf, value, ss.str().c_str());
+                if (!tracer.selected(ss.str())) return;
+                if (tracer._format == TRACE_FMT_WAVE) {
+                    tracer.add_wave(value, ss.str());
+                }
+                else {
+                    sc_trace(tracer._tf, value, ss.str().c_str());
+                }
             }
         }
 
@@ -47,6 +212,56 @@ class sc_tracer {
             trace(value, sc_module_name(module_name.c_str()), signal_name);
         }
 
+        /**
+         * Report a change of a traced variable to the waveform, the VCD samples
+         * them on its own. Signals are followed by their probes.
+         */
+        template <class T>
+        static void update(const T& value) {
+            if (tracer._capturing) {
+                std::unordered_map<const void*, uint32_t>::const_iterator it = tracer._var_ids.find(&value);
+                if (it != tracer._var_ids.end()) record(it->second, wave_value(value));
+            }
+        }
+
+        /** Report the progress of a model, such as the rows or frames done, to the capture window. */
+        static void trigger(const char *name, uint64_t value) {
+            if (tracer._window && tracer._window->follows(name)) {
+                tracer._window->on_trigger(value);
+            }
+        }
+
+        /** Whether the waveform is being captured. */
+        static bool capturing() {
+            return tracer._capturing;
+        }
+
+        /** Capture window of the waveform. */
+        static const sc_wave_window &window() {
+            return *tracer._window;
+        }
+
+        /** Record the value of a signal of the waveform at the current time. */
+        static void record(uint32_t id, uint64_t value) {
+            tracer._wave.change(sc_time_stamp().value(), id, value);
+        }
+
+        /** Start capturing, every value is recorded again. */
+        static void begin_capture() {
+            tracer._capturing = true;
+            tracer._wave.reset_values();
+            record(tracer._capture_id, 1);
+            for (const wave_var_t &var : tracer._vars) {
+                record(var.id, var.read(var.ptr));
+            }
+        }
+
+        /** Stop capturing. */
+        static void end_capture() {
+            record(tracer._capture_id, 0);
+            tracer._capturing = false;
+        }
+
         /** Comment. */
         static void comment(std::string comment) {
             sc_write_comment(tracer._tf, comment);
@@ -59,6 +274,11 @@ class sc_tracer {
                 sc_close_vcd_trace_file(tracer._tf);
                 tracer._tf = nullptr;
             }
+            if (tracer._wave.is_open()) {
+                if (tracer._capturing) end_capture();
+                tracer._wave.close();
+                tracer._wave.print_report(std::cout);
+            }
         }
 
         /** Disable tracing. */
@@ -79,23 +299,202 @@ class sc_tracer {
         // local file handle
         sc_trace_file *_tf = nullptr;
 
+        // traced names
+        std::vector<std::string> _globs;
+
+        // waveform
+        sc_trace_format_e _format = TRACE_FMT_VCD;
+        sc_wave_writer _wave;
+        sc_wave_window *_window = nullptr;
+        bool _capturing = false;
+        uint32_t _capture_id = 0;
+        std::vector<wave_var_t> _vars;
+        std::unordered_map<const void*, uint32_t> _var_ids;
+
+        /** Whether a name passes the filters. */
+        bool selected(const std::string &name) const {
+            if (_globs.empty()) return true;
+            for (const std::string &glob : _globs) {
+                if (fnmatch(glob.c_str(), name.c_str(), 0) == 0) return true;
+            }
+            return false;
+        }
+
+        /** Add a signal to the waveform, followed by a probe. */
+        template <class T>
+        void add_wave(sc_signal<T>& sig, const std::string &name) {
+            if constexpr (wave_type<T>::supported) {
+                uint32_t id = _wave.add_signal(name, wave_type<T>::width, wave_type<T>::kind);
+                std::string probe_name = "wave_probe_" + std::to_string(id);
+                new sc_wave_probe<T>(probe_name.c_str(), id, sig);
+            }
+            else {
+                std::cout << "Not tracing " << name << ", the waveform only holds integers and logic values" << std::endl;
+            }
+        }
+
+        /** Add a variable to the waveform, its changes are reported with `update`. */
+        template <class T>
+        void add_wave(T& value, const std::string &name) {
+            if constexpr (wave_type<T>::supported) {
+                uint32_t id = _wave.add_signal(name, wave_type<T>::width, wave_type<T>::kind);
+                _vars.push_back({&value, &wave_read_var<T>, id});
+                _var_ids[&value] = id;
+            }
+            else {
+                std::cout << "Not tracing " << name << ", the waveform only holds integers and logic values" << std::endl;
+            }
+        }
+
+};
+
+inline void sc_wave_window::open() {
+    _opened = true;
+    sc_tracer::begin_capture();
+    _open_event.notify(SC_ZERO_TIME);
+}
+
+inline void sc_wave_window::close() {
+    _closed = true;
+    sc_tracer::end_capture();
+    _close_event.notify(SC_ZERO_TIME);
+}
+
+/** Records the value of a signal when it changes while the capture window is open. */
+template <class T>
+class sc_wave_probe : public sc_module {
+
+    public:
+
+        SC_HAS_PROCESS(sc_wave_probe);
+
+        sc_wave_probe(sc_module_name name, uint32_t id, sc_signal<T> &sig)
+            : sc_module(name), _id(id), _sig(sig)
+        {
+            SC_METHOD(sample);
+        }
+
+    private:
+
+        uint32_t _id;
+        sc_signal<T> &_sig;
+
+        /** Record the value, then sleep until it changes or the window opens or closes. */
+        void sample() {
+            if (!sc_tracer::capturing()) {
+                next_trigger(sc_tracer::window().open_event());
+                return;
+            }
+            sc_tracer::record(_id, wave_value(_sig.read()));
+            next_trigger(_sig.value_changed_event() | sc_tracer::window().close_event());
+        }
+
 };
 
 // trackable class types
 enum trackable_class_e {
     REDUNDANT_COMMAND,
     REDUNDANT_RESPONSE,
+    COMMAND_ACK,  // command delivered to acknowledge verified, by transaction ID
+    INPUT_PACKET, // packet written to the input FIFO to read from it, by FIFO position
     TRACKABLE_CLASS_NONE
 };
 #define NUM_TRACKABLE_CLASSES TRACKABLE_CLASS_NONE
 
+// class names in the report
+static const char *const trackable_class_names[NUM_TRACKABLE_CLASSES] = {
+    "redundant command", "redundant response", "command to ack", "input packet"
+};
+
+// table of published data, open addressing with linear probing
+#define LATENCY_TABLE_N_BITS 16
+#define LATENCY_TABLE_SIZE (1 << LATENCY_TABLE_N_BITS)
+#define LATENCY_TABLE_MASK (LATENCY_TABLE_SIZE - 1)
+#define LATENCY_TABLE_MAX_LOAD (LATENCY_TABLE_SIZE - (LATENCY_TABLE_SIZE >> 3)) // 7/8 full
+
+// histogram buckets, 2^bits per power of two so the percentiles are within 1/2^bits
+#define LATENCY_HIST_SUB_BITS 7
+#define LATENCY_HIST_SUB_SIZE (1 << LATENCY_HIST_SUB_BITS)
+#define LATENCY_HIST_SIZE ((64 - LATENCY_HIST_SUB_BITS + 1) * LATENCY_HIST_SUB_SIZE)
+
 // information about tracked data
 struct trackable_data_t {
-    trackable_class_e data_class;
-    uint32_t publish_time;
+    uint64_t id;           // transaction identity within the class
+    uint64_t publish_time; // in time resolution units
+    uint8_t data_class;    // TRACKABLE_CLASS_NONE for an empty slot
 };
 
-/** Class to track latency of data across the NoC. */
+/**
+ * Histogram of latencies in the style of HDR histograms: the buckets are
+ * linear within each power of two, so recording is constant time and the
+ * percentiles have a bounded relative error.
+ */
+class latency_histogram {
+
+    public:
+
+        /** Record a latency, in time resolution units. */
+        void record(uint64_t value) {
+            _counts[index(value)]++;
+            _n++;
+            _sum += value;
+            if (value > _max) _max = value;
+            if (value < _min) _min = value;
+        }
+
+        /** Number of latencies recorded. */
+        uint64_t count() const { return _n; }
+        uint64_t min() const { return _n ? _min : 0; }
+        uint64_t max() const { return _max; }
+        double mean() const { return _n ? (double)_sum / (double)_n : 0.0; }
+
+        /** Latency under which `p` percent of the recorded ones fall, the highest value of its bucket. */
+        uint64_t percentile(double p) const {
+            if (!_n) return 0;
+            uint64_t rank = (uint64_t)(p / 100.0 * (double)_n + 0.5);
+            if (rank < 1) rank = 1;
+            uint64_t seen = 0;
+            for (uint32_t i = 0; i < LATENCY_HIST_SIZE; i++) {
+                seen += _counts[i];
+                if (seen >= rank) {
+                    uint64_t high = highest(i);
+                    return high < _max ? high : _max;
+                }
+            }
+            return _max;
+        }
+
+    private:
+
+        uint64_t _counts[LATENCY_HIST_SIZE] = {};
+        uint64_t _n = 0;
+        uint64_t _sum = 0;
+        uint64_t _min = UINT64_MAX;
+        uint64_t _max = 0;
+
+        /** Bucket of a value, exact below LATENCY_HIST_SUB_SIZE. */
+        static uint32_t index(uint64_t value) {
+            if (value < LATENCY_HIST_SUB_SIZE) return (uint32_t)value;
+            uint32_t shift = 63 - __builtin_clzll(value) - LATENCY_HIST_SUB_BITS;
+            return (shift + 1) * LATENCY_HIST_SUB_SIZE + (uint32_t)(value >> shift) - LATENCY_HIST_SUB_SIZE;
+        }
+
+        /** Highest value of a bucket. */
+        static uint64_t highest(uint32_t i) {
+            if (i < LATENCY_HIST_SUB_SIZE) return i;
+            uint32_t shift = i / LATENCY_HIST_SUB_SIZE - 1;
+            uint64_t low = (uint64_t)(i % LATENCY_HIST_SUB_SIZE + LATENCY_HIST_SUB_SIZE) << shift;
+            return low + ((1ull << shift) - 1);
+        }
+
+};
+
+/**
+ * Class to track the latency of data across the models, such as a command to
+ * its acknowledge. The data is identified by its class and an ID unique within
+ * the class while it is in flight, such as a transaction ID. The table is
+ * preallocated, so publishing and capturing take constant time.
+ */
 class latency_tracker; // forward declaration for global singleton
 class latency_tracker {
 
@@ -104,70 +503,104 @@ class latency_tracker {
         /** Global singleton instance */
         static latency_tracker tracker;
 
-        /** Publish a tracker. */
-        template <class T, class U = uint32_t>
-        static void publish(trackable_class_e data_class, T* data, U* data2 = nullptr) {
-            // calculate checksum for key
-            uint32_t chksum = 0;
-            uint32_t *ptr = (uint32_t*)data;
-            for (int i = 0; ptr && i < sizeof(T); i += sizeof(uint32_t), ptr++) {
-                chksum ^= *ptr;
-            }
-            ptr = (uint32_t*)data2;
-            for (int i = 0; ptr && i < sizeof(U); i += sizeof(uint32_t), ptr++) {
-                chksum ^= *ptr;
+        latency_tracker() {
+            for (uint32_t i = 0; i < LATENCY_TABLE_SIZE; i++) {
+                _table[i].data_class = TRACKABLE_CLASS_NONE;
             }
+        }
 
-            // insert into map
-            trackable_data_t data_struct;
-            data_struct.data_class = data_class;
-            data_struct.publish_time = (uint32_t)sc_time_stamp().to_double();
-            tracker._tracked_data[chksum] = data_struct;
+        /** Enable tracking, nothing is tracked by default. */
+        static void enable() {
+            tracker._enabled = true;
         }
 
-        /** Capture a tracker. */
-        template <class T, class U = uint32_t>
-        static void capture(T* data, U* data2 = nullptr) {
-            // calculate checksum for key
-            uint32_t chksum = 0;
-            uint32_t *ptr = (uint32_t*)data;
-            for (int i = 0; ptr && i < sizeof(T); i += sizeof(uint32_t), ptr++) {
-                chksum ^= *ptr;
-            }
-            ptr = (uint32_t*)data2;
-            for (int i = 0; ptr && i < sizeof(U); i += sizeof(uint32_t), ptr++) {
-                chksum ^= *ptr;
+        /** Publish a tracker, data published twice keeps its first time. */
+        static void publish(trackable_class_e data_class, uint64_t id) {
+            if (!tracker._enabled) return;
+            if (tracker._n_tracked >= LATENCY_TABLE_MAX_LOAD) {
+                tracker._n_dropped++;
+                return;
             }
 
-            // fetch from dictionary
-            std::map<uint32_t, trackable_data_t>::const_iterator it = tracker._tracked_data.find(chksum);
-            if (it != tracker._tracked_data.end()) {
-                // found in map
-                trackable_data_t entry = it->second;
-                tracker._durations[entry.data_class] += (uint32_t)sc_time_stamp().to_double() - entry.publish_time;
-                tracker._counts[entry.data_class]++;
+            uint32_t i = slot(data_class, id);
+            while (tracker._table[i].data_class != TRACKABLE_CLASS_NONE) {
+                if (tracker._table[i].data_class == data_class && tracker._table[i].id == id) return;
+                i = (i + 1) & LATENCY_TABLE_MASK;
+            }
+            tracker._table[i].id = id;
+            tracker._table[i].publish_time = sc_time_stamp().value();
+            tracker._table[i].data_class = (uint8_t)data_class;
+            tracker._n_tracked++;
+        }
 
-                // remove from map
-                tracker._tracked_data.erase(it);
+        /** Capture a tracker. */
+        static void capture(trackable_class_e data_class, uint64_t id) {
+            if (!tracker._enabled) return;
+
+            uint32_t i = slot(data_class, id);
+            while (tracker._table[i].data_class != TRACKABLE_CLASS_NONE) {
+                trackable_data_t &entry = tracker._table[i];
+                if (entry.data_class == data_class && entry.id == id) {
+                    tracker._hists[data_class].record(sc_time_stamp().value() - entry.publish_time);
+                    tracker.erase(i);
+                    return;
+                }
+                i = (i + 1) & LATENCY_TABLE_MASK;
             }
         }
 
         /** Print the report. */
         static void print_report(std::ostream& out = std::cout) {
+            if (!tracker._enabled) return;
             for (uint32_t c = (uint32_t)REDUNDANT_COMMAND; c < (uint32_t)TRACKABLE_CLASS_NONE; c++) {
-                out << "Class " << c << ": total duration " << tracker._durations[c] << " over " << tracker._counts[c] << " packets, average of " << ((double)tracker._durations[c] / (double)tracker._counts[c]) << " ticks per packet." << std::endl;
+                const latency_histogram &h = tracker._hists[c];
+                if (!h.count()) continue;
+                out << "Latency of " << trackable_class_names[c] << ": " << h.count() << " samples, min " << sc_time::from_value(h.min())
+                    << ", mean " << sc_time::from_value((uint64_t)h.mean()) << ", p50 " << sc_time::from_value(h.percentile(50.0))
+                    << ", p99 " << sc_time::from_value(h.percentile(99.0)) << ", p99.9 " << sc_time::from_value(h.percentile(99.9))
+                    << ", max " << sc_time::from_value(h.max()) << std::endl;
             }
-            out << tracker._tracked_data.size() << " outstanding packets." << std::endl;
+            out << tracker._n_tracked << " outstanding packets, " << tracker._n_dropped << " dropped with the table full." << std::endl;
         }
 
     private:
 
-        // list of tracked values
-        std::map<uint32_t, trackable_data_t> _tracked_data;
+        bool _enabled = false;
+
+        // published data in flight
+        trackable_data_t _table[LATENCY_TABLE_SIZE];
+        uint32_t _n_tracked = 0;
+        uint64_t _n_dropped = 0;
 
-        // total durations
-        uint32_t _durations[NUM_TRACKABLE_CLASSES];
-        uint32_t _counts[NUM_TRACKABLE_CLASSES];
+        // latencies per class
+        latency_histogram _hists[NUM_TRACKABLE_CLASSES];
+
+        /** Home slot of an ID, mixed so that consecutive IDs spread over the table. */
+        static uint32_t slot(uint32_t data_class, uint64_t id) {
+            uint64_t h = id ^ ((uint64_t)data_class << 56);
+            h = (h ^ (h >> 30)) * 0xbf58476d1ce4e5b9ull;
+            h = (h ^ (h >> 27)) * 0x94d049bb133111ebull;
+            return (uint32_t)(h ^ (h >> 31)) & LATENCY_TABLE_MASK;
+        }
+
+        /** Empty a slot, shifting back the entries of its probe sequence so no tombstone is left. */
+        void erase(uint32_t i) {
+            uint32_t j = i;
+            while (true) {
+                j = (j + 1) & LATENCY_TABLE_MASK;
+                if (_table[j].data_class == TRACKABLE_CLASS_NONE) break;
+
+                // the entry moves back unless its home slot is in (i, j]
+                uint32_t home = slot(_table[j].data_class, _table[j].id);
+                bool stays = i <= j ? (i < home && home <= j) : (i < home || home <= j);
+                if (!stays) {
+                    _table[i] = _table[j];
+                    i = j;
+                }
+            }
+            _table[i].data_class = TRACKABLE_CLASS_NONE;
+            _n_tracked--;
+        }
 
 };
 
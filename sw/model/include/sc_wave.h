@@ -0,0 +1,121 @@
+#include <stdint.h>
+#include <stdio.h>
+#include <ostream>
+#include <string>
+#include <vector>
+
+#ifndef SC_WAVE_H
+#define SC_WAVE_H
+
+// waveform file, see scripts/wave2vcd.py
+#define WAVE_MAGIC "SCWAVE\x01"
+#define WAVE_EXT ".scw"
+#define WAVE_BLOCK_SIZE (1 << 18) // bytes of encoded value changes per compressed block
+
+// sections of the file
+#define WAVE_SECTION_SIGNALS 'H'
+#define WAVE_SECTION_BLOCK   'B'
+
+// values of a 4-state logic signal
+#define WAVE_LOGIC_0 0
+#define WAVE_LOGIC_1 1
+#define WAVE_LOGIC_X 2
+#define WAVE_LOGIC_Z 3
+
+// kinds of signals
+enum wave_kind_e {
+    WAVE_KIND_INT,  // unsigned integer of `width` bits
+    WAVE_KIND_LOGIC // one 4-state bit
+};
+
+// traced signal
+struct wave_signal_t {
+    std::string name; // full name, the module path separated by dots
+    uint32_t width;
+    wave_kind_e kind;
+    uint64_t last;    // last value written
+    bool known;       // whether `last` was written in the current capture
+};
+
+/**
+ * Writer of a compact binary waveform, in the spirit of FST. The value changes
+ * are encoded as variable-length integers in blocks which are compressed with
+ * zlib on their own, so a reader can seek to a block by its time range.
+ *
+ * The file starts with WAVE_MAGIC and the time resolution in ns (double), then
+ * holds sections of a tag byte, the raw and compressed sizes (u32) and the
+ * compressed data. The blocks also hold their first and last time (u64) before
+ * the sizes. The signals section comes before the first block and lists the
+ * width (u32), kind (u8) and name (u16 length and bytes) of each signal, its
+ * index being its ID. In a block, a varint `(id << 1)` followed by a varint
+ * value is a value change, and a varint `(delta << 1) | 1` advances the time by
+ * `delta` resolution units, from the first time of the block.
+ */
+class sc_wave_writer {
+
+    public:
+
+        sc_wave_writer();
+        ~sc_wave_writer();
+
+        /**
+         * @brief Open the file.
+         *
+         * @param file   Path of the file.
+         * @param res_ns Time resolution, the unit of the times.
+         * @retval       Whether the file was opened.
+         */
+        bool open(const char *file, double res_ns);
+
+        /** Whether the file is open. */
+        bool is_open() const {
+            return _fp != nullptr;
+        }
+
+        /** Add a signal before the first block is written, return its ID. */
+        uint32_t add_signal(const std::string &name, uint32_t width, wave_kind_e kind);
+
+        /** Record the value of a signal at `time`, nothing if it did not change. */
+        void change(uint64_t time, uint32_t id, uint64_t value);
+
+        /** Forget the last values, so the next change of every signal is written. */
+        void reset_values();
+
+        /** Write the last block and close the file. */
+        void close();
+
+        /** Print the size of the waveform. */
+        void print_report(std::ostream &out);
+
+    private:
+
+        FILE *_fp;
+        std::vector<wave_signal_t> _signals;
+        bool _signals_written;
+
+        // current block
+        std::vector<uint8_t> _block;
+        uint64_t _block_start; // first time of the block
+        uint64_t _time;        // time of the last change
+
+        // statistics
+        uint64_t _n_changes;
+        uint64_t _n_blocks;
+        uint64_t _raw_bytes;
+        uint64_t _file_bytes;
+
+        /** Append a varint to the block. */
+        void put_varint(uint64_t v);
+
+        /** Compress and write a section, a section that fails to compress is reported and dropped. */
+        void write_section(char tag, const std::vector<uint8_t> &data, bool is_block);
+
+        /** Write the signals section. */
+        void write_signals();
+
+        /** Write the current block. */
+        void flush_block();
+
+};
+
+#endif // SC_WAVE_H
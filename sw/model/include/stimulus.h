@@ -0,0 +1,42 @@
+#include <stdint.h>
+#include <string>
+
+#ifndef STIMULUS_H
+#define STIMULUS_H
+
+/**
+ * Distribution of the generated stimulus.
+ */
+enum stim_dist_e {
+    STIM_UNIFORM,  // independent uniform bytes
+    STIM_NATURAL,  // smooth gradients with a little noise, as in camera frames
+    STIM_SATURATE, // mostly full-scale bytes, so the accumulators reach their largest values
+};
+
+/**
+ * @brief Parse a distribution name (`uniform`, `natural` or `saturate`).
+ *
+ * @retval Whether the name is a known distribution.
+ */
+bool stim_parse_dist(const std::string &name, stim_dist_e *dist);
+
+/**
+ * @brief Printable name of a distribution.
+ */
+const char *stim_dist_name(stim_dist_e dist);
+
+/**
+ * @brief Fill a matrix with stimulus. The bytes only depend on the seed, the
+ *        stream and their row and column, not on the stride.
+ *
+ * @param dst    First byte of the matrix.
+ * @param rows   Number of rows.
+ * @param cols   Number of bytes generated per row, the rest of the stride is untouched.
+ * @param stride Distance between consecutive rows.
+ * @param seed   Seed of the run.
+ * @param stream Independent sequence of the matrix.
+ * @param dist   Distribution of the bytes.
+ */
+void stim_fill(uint8_t *dst, uint32_t rows, uint32_t cols, uint64_t stride, uint64_t seed, uint64_t stream, stim_dist_e dist);
+
+#endif // STIMULUS_H
@@ -1,7 +1,11 @@
 
+#include "sc_log.h"
+
 #include <string>
 #include <iostream>
+#include <sstream>
 #include <stdio.h>
+#include <stdint.h>
 
 #ifndef SYSTEM_H
 #define SYSTEM_H
@@ -12,10 +16,39 @@
 
 #define PIXEL_SIZE 1 // pixel size in bytes
 
+/**
+ * Frame geometry and CPU memory map. Set at runtime by `parseCmdLine` from the
+ * command line options or a configuration file.
+ */
+struct sys_config_t {
+    uint32_t mat_rows;     // rows in the frame
+    uint32_t frame_cols;   // columns in the frame files
+    uint32_t mat_cols;     // columns in memory, frame_cols rounded up to MAT_COLS_ALIGN
+    uint32_t n_kern;       // kernels in the filter bank
+    uint32_t queue_depth;  // commands in flight
+    uint32_t n_frames;     // frames pushed through the kernel
+    uint32_t n_frame_bufs; // subject and output buffers, two to load a frame while the previous one computes
+    uint32_t cur_frame;    // frame last loaded in the subject buffers
+    uint64_t mem_size;     // bytes of CPU memory
+    uint64_t mat_addr;     // subject matrix
+    uint64_t kern_addr;    // kernels, packed back to back
+    uint64_t out_addr;     // output matrices, one per kernel
+    uint64_t unused_addr;  // acknowledge packets
+};
+extern sys_config_t sys_cfg;
+
+// default frame dimensions
+#define DEFAULT_MAT_ROWS 1080
+#define DEFAULT_MAT_COLS 1920
+
 // matrix dimensions
-#define MAT_ROWS 1080
-#define MAT_COLS 1920
-#define MAT_SIZE (MAT_ROWS*MAT_COLS)
+#define MAT_COLS_ALIGN 128 // subject columns are transferred in multiples of 128
+#define MAX_MAT_ROWS 0xFFFF
+#define MAX_MAT_COLS (0xFF * MAT_COLS_ALIGN)
+#define MAT_ROWS (sys_cfg.mat_rows)
+#define MAT_COLS (sys_cfg.mat_cols)
+#define FRAME_COLS (sys_cfg.frame_cols)
+#define MAT_SIZE ((uint64_t)MAT_ROWS*MAT_COLS)
 
 // kernel dimensions
 #define MAX_KERN_DIM 7
@@ -23,25 +56,52 @@
 #define MAX_KERN_SIZE (MAX_KERN_ROWS*MAX_KERN_ROWS)
 #define KERN_SIZE_ROUNDED ((((MAX_KERN_SIZE) >> 3) + 1) << 3)
 
+// filter bank dimensions
+#define MAX_KERN_BANK 8
+#define KERN_BANK_SIZE_ROUNDED ((((MAX_KERN_BANK*MAX_KERN_SIZE) >> 3) + 1) << 3)
+#define N_KERN (sys_cfg.n_kern)
+
+// command queue, one acknowledge packet slot per command in flight
+#define MAX_QUEUE_DEPTH 8
+#define QUEUE_DEPTH (sys_cfg.queue_depth)
+
+// frame sequence, consecutive frames alternate between the subject and output buffers
+#define MAX_FRAME_BUFS 2
+#define N_FRAMES (sys_cfg.n_frames)
+#define N_FRAME_BUFS (sys_cfg.n_frame_bufs)
+#define CUR_FRAME (sys_cfg.cur_frame)
+
 // CPU memory constraint
-#define MEM_SIZE (1 << (20+4)) // 24MB
-#define MAT_SIZE_PADDED ((MAT_ROWS+(MAX_KERN_DIM>>1))*MAT_COLS)
+#define MEM_SIZE (sys_cfg.mem_size)
+#define MAT_SIZE_PADDED ((uint64_t)(MAT_ROWS+(MAX_KERN_DIM>>1))*MAT_COLS)
+#define KERN_REGION_SIZE ((((N_KERN*MAX_KERN_SIZE) >> 3) + 1) << 3)
+#define OUT_REGION_SIZE (N_KERN*MAT_SIZE)
+#define ACK_SIZE_ROUNDED 64
+#define ACK_REGION_SIZE (QUEUE_DEPTH*ACK_SIZE_ROUNDED)
 
 // CPU memory addresses
-#define MAT_ADDR    0
-#define KERN_ADDR   MAT_ADDR+MAT_SIZE_PADDED
-#define OUT_ADDR    KERN_ADDR+KERN_SIZE_ROUNDED
-#define UNUSED_ADDR OUT_ADDR+MAT_SIZE
+#define MAT_ADDR    (sys_cfg.mat_addr)
+#define KERN_ADDR   (sys_cfg.kern_addr)
+#define OUT_ADDR    (sys_cfg.out_addr)
+#define UNUSED_ADDR (sys_cfg.unused_addr)
 #define BUILD_MAT_ADDR(r, c) (MAT_ADDR) + ((r) * MAT_COLS) + c
 #define BUILD_KERN_ADDR(i)   (KERN_ADDR) + i
 #define BUILD_OUT_ADDR(r, c) (OUT_ADDR) + ((r) * MAT_COLS) + c
+#define BUILD_ACK_ADDR(i)    (UNUSED_ADDR) + ((i) * ACK_SIZE_ROUNDED)
+#define FRAME_MAT_ADDR(i)    ((MAT_ADDR) + ((i) % N_FRAME_BUFS) * MAT_SIZE_PADDED)
+#define FRAME_OUT_ADDR(i)    ((OUT_ADDR) + ((i) % N_FRAME_BUFS) * OUT_REGION_SIZE)
 
 // optimization parameter constraints
 #define MAX_N_CLUSTERS 8
-#define MAX_N_CORES_PER_CLUSTER MAX_KERN_DIM
+#define MAX_N_CORES_PER_CLUSTER (MAX_KERN_DIM*MAX_KERN_BANK) // one core per kernel row in the bank
 #define PACKET_BYTES (sizeof(uint64_t) / PIXEL_SIZE)
 #define MAX_CLUSTER_INPUT_SIZE (PACKET_BYTES + MAX_KERN_DIM - 1)
 
+// input FIFO of the matrix multiplier, in packets
+#define IN_FIFO_BUF_N_BITS 4
+#define IN_FIFO_BUF_SIZE (1 << IN_FIFO_BUF_N_BITS)
+#define IN_FIFO_PTR_MASK (IN_FIFO_BUF_SIZE - 1)
+
 // ==================================
 // ===== SIMULATION TIME MACROS =====
 // ==================================
@@ -62,25 +122,56 @@
 #define POS_PROC() wait(CC_PROC_NS, SC_NS)
 // yield so all modules can capture the rising edge signals
 #define YIELD() wait(0, SC_NS)
+// sleep until `e` is notified, then resume on the first rising edge of the core clock after it, when a
+// thread polling every edge would see the change written by a thread of the core clock
+#define IDLE_CORE(e) do { \
+        wait(e); \
+        wait(sc_time(CC_CORE_NS, SC_NS) - sc_time::from_value(sc_time_stamp().value() % sc_time(CC_CORE_NS, SC_NS).value())); \
+    } while (0)
 
 // ========================================
 // ===== UTILITY FUNCTIONS AND MACROS =====
 // ========================================
 
-// logging functions
-#define LOG(a) std::cout << sc_time_stamp() << " - " << a << std::endl;
-#define LOGF(a, ...) std::cout << sc_time_stamp() << " - "; printf(a, __VA_ARGS__); printf("\n")
+// module of the records of LOG, LOGF, DEBUG and DEBUGF, for the filters of --log: the name of the
+// SystemC module by default, a source file outside a module defines its own before including system.h
+#ifndef LOG_MODULE
+    #define LOG_MODULE this->name()
+#endif
+
+// logging functions, the records are written out by the thread of sc_logger, see sc_log.h
+#define LOG_STREAM(level, a) do { \
+        if ((level) <= LOG_LEVEL && sc_logger::enabled(level, LOG_MODULE)) { \
+            std::ostringstream log_ss; \
+            log_ss << a; \
+            sc_logger::log_str(level, LOG_MODULE, log_ss.str()); \
+        } \
+    } while (0)
+#define LOG(a) LOG_STREAM(LOG_LVL_INFO, a)
+#define LOGF(...) LOG_INFO(LOG_MODULE, __VA_ARGS__)
 
 #ifdef DO_DEBUG
-    #define DEBUG(a) std::cout << sc_time_stamp() << " - " << a << std::endl;
-    #define DEBUGF(a, ...) std::cout << sc_time_stamp() << " - "; printf(a, __VA_ARGS__); printf("\n")
+    #define DEBUG(a) LOG_STREAM(LOG_LVL_DEBUG, a)
+    #define DEBUGF(...) LOG_DEBUG(LOG_MODULE, __VA_ARGS__)
 #else
     #define DEBUG(a)
-    #define DEBUGF(a, ...)
+    #define DEBUGF(...)
 #endif
 
-// parse command line arguments
-bool parseCmdLine(int argc, char **argv, unsigned char *mem, int *kernelsize);
+// parse command line arguments, configure the system and allocate the CPU memory
+bool parseCmdLine(int argc, char **argv, unsigned char **mem, int *kernelsize);
+
+// runtime options given on the command line as --<NAME>=<VALUE>
+bool hasOption(const char *name);
+std::string getOption(const char *name, const std::string &def = "");
+int getOptionInt(const char *name, int def);
+uint64_t getOptionAddr(const char *name, uint64_t def);
+
+// whether every numeric option read so far is a number in range, the others are reported and read as their default
+bool optionsValid();
+
+// load frame `i` of the sequence in its subject buffer
+bool frameLoad(unsigned char *mem, uint32_t i);
 
 // visualize and output current memory
 bool memoryWrite(char **argv, unsigned char *mem);
@@ -0,0 +1,124 @@
+#include <stdint.h>
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#ifndef THREAD_POOL_HPP
+#define THREAD_POOL_HPP
+
+/**
+ * Fixed-size pool of host threads to run data-parallel loops. The workers
+ * never call into the SystemC kernel, so they may be used from any process.
+ */
+class thread_pool {
+
+    public:
+
+        /**
+         * @brief Constructor.
+         *
+         * @param n_threads Total number of threads running tasks, including the
+         *                  caller of `run`. 0 selects the hardware concurrency.
+         */
+        thread_pool(uint32_t n_threads) : _generation(0), _n_tasks(0), _n_busy(0), _stop(false)
+        {
+            if (!n_threads) {
+                n_threads = std::thread::hardware_concurrency();
+            }
+            for (uint32_t i = 1; i < n_threads; i++) {
+                _workers.emplace_back(&thread_pool::worker, this);
+            }
+        }
+
+        ~thread_pool() {
+            {
+                std::lock_guard<std::mutex> lock(_mutex);
+                _stop = true;
+            }
+            _start_cv.notify_all();
+            for (std::thread& t : _workers) {
+                t.join();
+            }
+        }
+
+        /** Number of threads running tasks. */
+        uint32_t size() const {
+            return (uint32_t)_workers.size() + 1;
+        }
+
+        /**
+         * @brief Run `fn(i)` for each `i` in `[0, n_tasks)` and block until all complete.
+         *
+         * Tasks are handed out dynamically, so they may complete in any order.
+         */
+        void run(uint32_t n_tasks, std::function<void(uint32_t)> fn) {
+            if (_workers.empty()) {
+                for (uint32_t i = 0; i < n_tasks; i++) fn(i);
+                return;
+            }
+
+            // publish the job
+            {
+                std::lock_guard<std::mutex> lock(_mutex);
+                _fn = fn;
+                _n_tasks = n_tasks;
+                _next_task.store(0);
+                _n_busy = (uint32_t)_workers.size();
+                _generation++;
+            }
+            _start_cv.notify_all();
+
+            // participate, then wait for the workers to drain
+            run_tasks();
+            std::unique_lock<std::mutex> lock(_mutex);
+            _done_cv.wait(lock, [this] { return _n_busy == 0; });
+        }
+
+    private:
+
+        std::vector<std::thread> _workers;
+        std::mutex _mutex;
+        std::condition_variable _start_cv;
+        std::condition_variable _done_cv;
+
+        /** Current job. */
+        std::function<void(uint32_t)> _fn;
+        uint64_t _generation;
+        uint32_t _n_tasks;
+        uint32_t _n_busy;
+        std::atomic<uint32_t> _next_task;
+        bool _stop;
+
+        void run_tasks() {
+            for (uint32_t i = _next_task++; i < _n_tasks; i = _next_task++) {
+                _fn(i);
+            }
+        }
+
+        void worker() {
+            uint64_t generation = 0;
+
+            while (true) {
+                {
+                    std::unique_lock<std::mutex> lock(_mutex);
+                    _start_cv.wait(lock, [&] { return _stop || _generation != generation; });
+                    if (_stop) return;
+                    generation = _generation;
+                }
+
+                run_tasks();
+
+                {
+                    std::lock_guard<std::mutex> lock(_mutex);
+                    _n_busy--;
+                }
+                _done_cv.notify_one();
+            }
+        }
+
+};
+
+#endif // THREAD_POOL_HPP
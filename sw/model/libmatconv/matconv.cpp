@@ -0,0 +1,68 @@
+#include "matconv.h"
+#include "conv_engine.h"
+#include "system.h"
+
+static_assert(MATCONV_MAX_KERN_DIM == MAX_KERN_DIM, "kernel dimension differs from the models");
+static_assert(MATCONV_MAX_KERN_BANK == MAX_KERN_BANK, "filter bank size differs from the models");
+
+/** Engine for the host CPU, detected on first use. */
+static conv_isa_e matconv_isa() {
+    static const conv_isa_e isa = conv_detect_isa();
+    return isa;
+}
+
+int matconv_api_version(void) {
+    return MATCONV_API_VERSION;
+}
+
+const char *matconv_engine(void) {
+    return conv_isa_name(matconv_isa());
+}
+
+int matconv_convolve(const uint8_t *subj, uint32_t rows, uint32_t cols, size_t subj_stride,
+                     const uint8_t *kern, uint32_t kern_dim, uint32_t n_kern,
+                     uint8_t *out, size_t out_stride, size_t out_plane) {
+    return matconv_convolve_rows(subj, rows, cols, subj_stride, kern, kern_dim, n_kern,
+                                 out, out_stride, out_plane, 0, rows);
+}
+
+int matconv_convolve_rows(const uint8_t *subj, uint32_t rows, uint32_t cols, size_t subj_stride,
+                          const uint8_t *kern, uint32_t kern_dim, uint32_t n_kern,
+                          uint8_t *out, size_t out_stride, size_t out_plane,
+                          uint32_t r_start, uint32_t r_end) {
+    if (!subj || !kern || !out || subj_stride < cols || out_stride < cols) {
+        return MATCONV_STAT_ERR_ARG;
+    }
+    if (kern_dim > 0xff || !n_kern || n_kern > MAX_KERN_BANK || r_start > r_end || r_end > rows) {
+        return MATCONV_STAT_ERR_SIZE;
+    }
+
+    conv_bank_fn conv_fn = conv_select_bank(matconv_isa(), (uint8_t)kern_dim);
+    if (!conv_fn) {
+        return MATCONV_STAT_ERR_SIZE;
+    }
+
+    // same row loop as mat_mult::calculate_band, directly on the caller's buffers
+    int32_t hf_kern_dim = kern_dim >> 1;
+    const uint8_t *in_rows[MAX_KERN_DIM];
+    for (uint32_t r = r_start; r < r_end; r++) {
+        for (int32_t i = 0; i < (int32_t)kern_dim; i++) {
+            int64_t subj_r = (int64_t)r + i - hf_kern_dim;
+            in_rows[i] = (subj_r >= 0 && subj_r < rows) ? subj + subj_r * subj_stride : nullptr;
+        }
+        conv_fn(in_rows, cols, kern, n_kern, out + r * out_stride, out_plane);
+    }
+
+    return MATCONV_STAT_OKAY;
+}
+
+uint32_t matconv_core_row(uint32_t carry, const uint8_t *kern_row, const uint8_t *group, uint32_t kern_dim) {
+    if (!conv_dot_legal(kern_dim)) {
+        return carry;
+    }
+    return conv_core_result(conv_dot_dim((uint8_t)kern_dim, carry, kern_row, group));
+}
+
+uint8_t matconv_round(uint32_t sum) {
+    return conv_round(sum);
+}
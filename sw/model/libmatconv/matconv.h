@@ -0,0 +1,98 @@
+#include <stddef.h>
+#include <stdint.h>
+
+#ifndef MATCONV_H
+#define MATCONV_H
+
+/*
+ * libmatconv: the convolution arithmetic of the matrix multiplier, without SystemC.
+ *
+ * The functions only read and write the caller's buffers, keep no state, and
+ * may be called from any number of threads. They share their implementation
+ * with the simulation models, so the outputs are identical.
+ */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// only the C functions are exported from the shared library
+#if defined(__GNUC__)
+    #define MATCONV_API __attribute__((visibility("default")))
+#else
+    #define MATCONV_API
+#endif
+
+// version of this interface, incremented on incompatible changes
+#define MATCONV_API_VERSION 1
+
+// largest kernel dimension and filter bank
+#define MATCONV_MAX_KERN_DIM  7
+#define MATCONV_MAX_KERN_BANK 8
+
+// status values
+#define MATCONV_STAT_OKAY     0
+#define MATCONV_STAT_ERR_ARG  1 // null buffer or stride shorter than a row
+#define MATCONV_STAT_ERR_SIZE 2 // illegal kernel dimension, bank size or row range
+
+/**
+ * @brief Version of the library, compare with `MATCONV_API_VERSION`.
+ */
+MATCONV_API int matconv_api_version(void);
+
+/**
+ * @brief Name of the engine selected for the host CPU ("scalar", "avx2" or "avx512").
+ */
+MATCONV_API const char *matconv_engine(void);
+
+/**
+ * @brief Convolve a subject with a filter bank, as the golden model does.
+ *
+ * Each output pixel is the low byte of the 32-bit sum of the unsigned products
+ * between the kernel and the pixel neighbourhood, with zero padding outside of
+ * the subject.
+ *
+ * @param subj        Subject, row-major.
+ * @param rows        Number of rows in the subject.
+ * @param cols        Number of columns in the subject.
+ * @param subj_stride Bytes between the starts of consecutive subject rows.
+ * @param kern        Kernel values, row-major, kernels packed back to back.
+ * @param kern_dim    Kernel dimension (odd, at most `MATCONV_MAX_KERN_DIM`).
+ * @param n_kern      Number of kernels (at most `MATCONV_MAX_KERN_BANK`).
+ * @param out         Output of the first kernel, `rows`x`cols`.
+ * @param out_stride  Bytes between the starts of consecutive output rows.
+ * @param out_plane   Bytes between the outputs of consecutive kernels.
+ * @retval A `MATCONV_STAT_*` value.
+ */
+MATCONV_API int matconv_convolve(const uint8_t *subj, uint32_t rows, uint32_t cols, size_t subj_stride,
+                                 const uint8_t *kern, uint32_t kern_dim, uint32_t n_kern,
+                                 uint8_t *out, size_t out_stride, size_t out_plane);
+
+/**
+ * @brief Convolve output rows `[r_start, r_end)` only, so callers can split a
+ *        subject across their own threads. Parameters as in `matconv_convolve`;
+ *        `out` still points to row 0.
+ */
+MATCONV_API int matconv_convolve_rows(const uint8_t *subj, uint32_t rows, uint32_t cols, size_t subj_stride,
+                                      const uint8_t *kern, uint32_t kern_dim, uint32_t n_kern,
+                                      uint8_t *out, size_t out_stride, size_t out_plane,
+                                      uint32_t r_start, uint32_t r_end);
+
+/**
+ * @brief Row result of a compute core: the dot product of a kernel row with a
+ *        group of `kern_dim` pixels added to `carry`, masked to 18 bits.
+ *
+ * @retval The result, or `carry` if `kern_dim` is not a legal kernel dimension.
+ */
+MATCONV_API uint32_t matconv_core_row(uint32_t carry, const uint8_t *kern_row, const uint8_t *group, uint32_t kern_dim);
+
+/**
+ * @brief Round a SQ0.7 sum to an output pixel, as the concatenation stage does.
+ */
+MATCONV_API uint8_t matconv_round(uint32_t sum);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // MATCONV_H
@@ -0,0 +1,103 @@
+
+import re
+import struct
+from sys import argv, stdout
+
+# usage: python logdec.py <LOG_FILE>, decode a log written with --log_binary=1
+
+MAGIC = b"SCLOG\x01"
+
+# argument types, see log_arg_type_e in sc_log.h
+ARG_INT, ARG_UINT, ARG_DOUBLE, ARG_PTR, ARG_STR = range(5)
+
+# level prefixes, see sc_logger::write_text
+LEVEL_PREFIX = ["ERROR>>> ", "WARNING>>> ", "", ""]
+
+# printf conversion, the length modifiers are dropped as Python has none
+CONV = re.compile(r"%([-+ #0]*[0-9]*(?:\.[0-9]*)?)[hlLqjzt]*([diuxXocfFeEgGaAsp%])")
+
+class reader:
+
+    def __init__(self, data):
+        self.data = data
+        self.pos = 0
+
+    def done(self):
+        return self.pos >= len(self.data)
+
+    def unpack(self, fmt):
+        vals = struct.unpack_from("<" + fmt, self.data, self.pos)
+        self.pos += struct.calcsize("<" + fmt)
+        return vals if len(vals) > 1 else vals[0]
+
+    def bytes(self, n):
+        b = self.data[self.pos:self.pos + n]
+        self.pos += n
+        return b.decode("utf-8", "replace")
+
+    def string(self):
+        return self.bytes(self.unpack("H"))
+
+# format a record like the writer thread
+def format_record(fmt, args):
+    it = iter(args)
+    def conv(m):
+        spec, c = m.group(1), m.group(2)
+        if c == "%":
+            return "%"
+        arg = next(it, None)
+        if arg is None:
+            return "<?>"
+        if c == "s":
+            return ("%" + spec + "s") % (arg if isinstance(arg, str) else "<?>")
+        if c == "p":
+            return hex(arg)
+        if c in "diuxXoc":
+            val = int(arg)
+            if c in "uxXo":
+                val &= 0xFFFFFFFFFFFFFFFF
+            return ("%" + spec + ("d" if c in "iu" else c)) % val
+        return ("%" + spec + c) % float(arg)
+    return CONV.sub(conv, fmt)
+
+def decode(file, out):
+    with open(file, "rb") as f:
+        r = reader(f.read())
+    if r.bytes(len(MAGIC)) != MAGIC.decode():
+        raise Exception(f"{file} is not a binary log")
+    res_ns = r.unpack("d")
+
+    fmts = {}
+    modules = {}
+    while not r.done():
+        tag = r.bytes(1)
+        if tag == "F":
+            i = r.unpack("I")
+            fmts[i] = r.string()
+        elif tag == "M":
+            i = r.unpack("I")
+            modules[i] = r.string()
+        elif tag == "R":
+            time, level, module, fmt = r.unpack("QBII")
+            if fmt == 0xFFFFFFFF:
+                msg = r.string()
+            else:
+                args = []
+                for _ in range(r.unpack("B")):
+                    t = r.unpack("B")
+                    if t == ARG_STR:
+                        args.append(r.string())
+                    elif t == ARG_INT:
+                        args.append(r.unpack("q"))
+                    elif t == ARG_DOUBLE:
+                        args.append(r.unpack("d"))
+                    else:
+                        args.append(r.unpack("Q"))
+                msg = format_record(fmts[fmt], args)
+            prefix = f"[{modules[module]}] " if modules[module] else ""
+            out.write(f"{time * res_ns:.15g} ns - {prefix}{LEVEL_PREFIX[level]}{msg}\n")
+        else:
+            raise Exception(f"Invalid tag {tag} at byte {r.pos - 1}")
+
+if __name__ == "__main__":
+    decode(argv[1], stdout)
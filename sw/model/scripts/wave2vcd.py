@@ -0,0 +1,133 @@
+
+import struct
+import zlib
+from sys import argv
+
+# usage: python wave2vcd.py <WAVE_FILE> <VCD_FILE> [<FROM_NS> <TO_NS>], convert a waveform written with --trace_format=wave
+
+MAGIC = b"SCWAVE\x01"
+
+# signal kinds and logic values, see sc_wave.h
+KIND_INT, KIND_LOGIC = range(2)
+LOGIC_CHARS = "01xz"
+
+# VCD identifier of a signal
+def vcd_id(i):
+    s = ""
+    while True:
+        s += chr(33 + i % 94)
+        i //= 94
+        if i == 0:
+            return s
+
+# VCD time scale of a resolution
+def timescale(res_ns):
+    for unit, scale in (("fs", 1e-6), ("ps", 1e-3), ("ns", 1.0), ("us", 1e3)):
+        if abs(res_ns / scale - round(res_ns / scale)) < 1e-9 and round(res_ns / scale) in (1, 10, 100):
+            return f"{round(res_ns / scale)} {unit}"
+    raise Exception(f"Unsupported time resolution {res_ns} ns")
+
+def read_varint(data, pos):
+    v = 0
+    shift = 0
+    while True:
+        b = data[pos]
+        pos += 1
+        v |= (b & 0x7f) << shift
+        shift += 7
+        if b < 0x80:
+            return v, pos
+
+# read the signals and blocks of the file
+def read_wave(file):
+    with open(file, "rb") as f:
+        raw = f.read()
+    if not raw.startswith(MAGIC):
+        raise Exception(f"{file} is not a waveform")
+    pos = len(MAGIC)
+    res_ns, = struct.unpack_from("<d", raw, pos)
+    pos += 8
+
+    signals = []
+    blocks = []
+    while pos < len(raw):
+        tag = chr(raw[pos])
+        pos += 1
+        if tag == "B":
+            t_start, t_end = struct.unpack_from("<QQ", raw, pos)
+            pos += 16
+        raw_size, comp_size = struct.unpack_from("<II", raw, pos)
+        pos += 8
+        data = zlib.decompress(raw[pos:pos + comp_size])
+        pos += comp_size
+        if tag == "H":
+            p = 0
+            while p < len(data):
+                width, kind, n = struct.unpack_from("<IBH", data, p)
+                p += 7
+                signals.append((data[p:p + n].decode(), width, kind))
+                p += n
+        elif tag == "B":
+            blocks.append((t_start, t_end, data))
+        else:
+            raise Exception(f"Invalid section {tag}")
+    return res_ns, signals, blocks
+
+def vcd_value(sig, value, ident):
+    name, width, kind = sig
+    if kind == KIND_LOGIC:
+        return f"{LOGIC_CHARS[value]}{ident}"
+    if width == 1:
+        return f"{value}{ident}"
+    return f"b{value:b} {ident}"
+
+def convert(file, out_file, t_from=None, t_to=None):
+    res_ns, signals, blocks = read_wave(file)
+
+    with open(out_file, "w") as out:
+        out.write(f"$timescale {timescale(res_ns)} $end\n")
+
+        # scopes, the last part of a name is the signal
+        scope = []
+        for i, (name, width, kind) in sorted(enumerate(signals), key=lambda s: s[1][0]):
+            path = name.split(".")
+            common = 0
+            while common < len(scope) and common < len(path) - 1 and scope[common] == path[common]:
+                common += 1
+            for _ in range(len(scope) - common):
+                out.write("$upscope $end\n")
+            scope = scope[:common]
+            for module in path[common:-1]:
+                out.write(f"$scope module {module} $end\n")
+                scope.append(module)
+            out.write(f"$var wire {width} {vcd_id(i)} {path[-1]} $end\n")
+        for _ in scope:
+            out.write("$upscope $end\n")
+        out.write("$enddefinitions $end\n")
+
+        # value changes, the blocks outside the range are skipped without decoding
+        last_time = None
+        for t_start, t_end, data in blocks:
+            if (t_to is not None and t_start * res_ns > t_to) or (t_from is not None and t_end * res_ns < t_from):
+                continue
+            time = t_start
+            p = 0
+            while p < len(data):
+                v, p = read_varint(data, p)
+                if v & 1:
+                    time += v >> 1
+                    continue
+                value, p = read_varint(data, p)
+                if (t_from is not None and time * res_ns < t_from) or (t_to is not None and time * res_ns > t_to):
+                    continue
+                if time != last_time:
+                    out.write(f"#{time}\n")
+                    last_time = time
+                i = v >> 1
+                out.write(vcd_value(signals[i], value, vcd_id(i)) + "\n")
+
+if __name__ == "__main__":
+    if len(argv) not in (3, 5):
+        print(f"USAGE: {argv[0]} <WAVE_FILE> <VCD_FILE> [<FROM_NS> <TO_NS>]")
+        exit()
+    convert(argv[1], argv[2], *(float(a) for a in argv[3:]))
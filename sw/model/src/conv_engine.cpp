@@ -0,0 +1,279 @@
+
+#include "conv_engine.h"
+#include "system.h"
+
+#include <string.h>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+    #define CONV_X86
+    #include <immintrin.h>
+#endif
+
+// number of output columns accumulated at once by the scalar interior loop
+#define CONV_TILE_COLS 256
+
+// number of output columns computed for every kernel of a bank before moving on,
+// a multiple of the vector widths so only the last tile has a scalar tail
+#define CONV_BANK_TILE_COLS 512
+
+/**
+ * Kernel rows overlapping the subject for the current output row. Rows in the
+ * zero padding contribute nothing, so they are dropped up front and the loops
+ * below never check row bounds.
+ */
+struct conv_rows_t {
+    const uint8_t *in[MAX_KERN_DIM];   // subject rows
+    const uint8_t *kern[MAX_KERN_DIM]; // matching kernel rows
+    int32_t n;                         // number of valid rows
+};
+
+/**
+ * Branch-free scalar interior. Every column tap of the outputs in
+ * `[c_start, c_end)` must be inside the rows.
+ *
+ * The outputs are accumulated one kernel tap at a time over a tile of columns,
+ * which keeps the accumulators in L1 and gives the compiler a straight-line
+ * inner loop. Only the low byte of each sum is kept, so a 16-bit wrapping
+ * accumulator is bit-exact with the 32-bit reference. The vector engines rely
+ * on the same property.
+ */
+template <int KDIM>
+static void conv_interior_scalar(const conv_rows_t& rows, int32_t c_start, int32_t c_end, uint8_t *out) {
+    const int32_t hf_kern_dim = KDIM >> 1;
+    uint16_t acc[CONV_TILE_COLS];
+
+    for (int32_t t = c_start; t < c_end; t += CONV_TILE_COLS) {
+        int32_t w = (c_end - t) < CONV_TILE_COLS ? (c_end - t) : CONV_TILE_COLS;
+        memset(acc, 0, w * sizeof(uint16_t));
+
+        for (int32_t kr = 0; kr < rows.n; kr++) {
+            const uint8_t *p = rows.in[kr] + t - hf_kern_dim;
+            for (int32_t kc = 0; kc < KDIM; kc++) {
+                uint16_t k = rows.kern[kr][kc];
+                for (int32_t i = 0; i < w; i++) {
+                    acc[i] += (uint16_t)(p[i + kc] * k);
+                }
+            }
+        }
+
+        for (int32_t i = 0; i < w; i++) {
+            out[t + i] = (uint8_t)acc[i];
+        }
+    }
+}
+
+/**
+ * Border columns `[c_start, c_end)`. The columns read by these outputs are
+ * copied into scratch rows with explicit zero padding, then handed to the
+ * branch-free interior loop.
+ */
+template <int KDIM>
+static void conv_border(const conv_rows_t& rows, int32_t cols, int32_t c_start, int32_t c_end, uint8_t *out) {
+    if (c_start >= c_end) return;
+
+    const int32_t hf_kern_dim = KDIM >> 1;
+    int32_t first = c_start - hf_kern_dim; // first column read, may be negative
+    int32_t width = (c_end - c_start) + 2 * hf_kern_dim;
+
+    // at most 3 half kernels wide, see conv_row_k
+    uint8_t scratch[MAX_KERN_DIM][3 * MAX_KERN_DIM];
+    conv_rows_t padded = rows;
+    for (int32_t kr = 0; kr < rows.n; kr++) {
+        for (int32_t i = 0; i < width; i++) {
+            int32_t j = first + i;
+            scratch[kr][i] = (j >= 0 && j < cols) ? rows.in[kr][j] : 0;
+        }
+        padded.in[kr] = scratch[kr];
+    }
+
+    uint8_t res[3 * MAX_KERN_DIM];
+    conv_interior_scalar<KDIM>(padded, hf_kern_dim, hf_kern_dim + (c_end - c_start), res);
+    memcpy(out + c_start, res + hf_kern_dim, c_end - c_start);
+}
+
+#ifdef CONV_X86
+
+template <int KDIM>
+__attribute__((target("avx2")))
+static int32_t conv_interior_avx2(const conv_rows_t& rows, int32_t c_start, int32_t c_end, uint8_t *out) {
+    const int32_t hf_kern_dim = KDIM >> 1;
+    int32_t c = c_start;
+
+    // broadcast each tap to the 16-bit lanes
+    __m256i taps[KDIM * KDIM];
+    for (int32_t kr = 0; kr < KDIM; kr++) {
+        for (int32_t kc = 0; kc < KDIM; kc++) {
+            taps[kr * KDIM + kc] = _mm256_set1_epi16(kr < rows.n ? (int16_t)rows.kern[kr][kc] : 0);
+        }
+    }
+    const __m256i low_byte = _mm256_set1_epi16(0xff);
+
+    for (; c + 16 <= c_end; c += 16) {
+        __m256i acc = _mm256_setzero_si256();
+
+        for (int32_t kr = 0; kr < KDIM; kr++) {
+            if (kr >= rows.n) break; // rows dropped in the top and bottom border
+            const uint8_t *p = rows.in[kr] + c - hf_kern_dim;
+            for (int32_t kc = 0; kc < KDIM; kc++) {
+                __m256i px = _mm256_cvtepu8_epi16(_mm_loadu_si128((const __m128i*)(p + kc)));
+                acc = _mm256_add_epi16(acc, _mm256_mullo_epi16(px, taps[kr * KDIM + kc]));
+            }
+        }
+
+        // keep the low byte of each lane and narrow
+        acc = _mm256_and_si256(acc, low_byte);
+        __m128i res = _mm_packus_epi16(_mm256_castsi256_si128(acc), _mm256_extracti128_si256(acc, 1));
+        _mm_storeu_si128((__m128i*)(out + c), res);
+    }
+
+    return c;
+}
+
+template <int KDIM>
+__attribute__((target("avx512f,avx512bw")))
+static int32_t conv_interior_avx512(const conv_rows_t& rows, int32_t c_start, int32_t c_end, uint8_t *out) {
+    const int32_t hf_kern_dim = KDIM >> 1;
+    int32_t c = c_start;
+
+    // broadcast each tap to the 16-bit lanes
+    __m512i taps[KDIM * KDIM];
+    for (int32_t kr = 0; kr < KDIM; kr++) {
+        for (int32_t kc = 0; kc < KDIM; kc++) {
+            taps[kr * KDIM + kc] = _mm512_set1_epi16(kr < rows.n ? (int16_t)rows.kern[kr][kc] : 0);
+        }
+    }
+
+    for (; c + 32 <= c_end; c += 32) {
+        __m512i acc = _mm512_setzero_si512();
+
+        for (int32_t kr = 0; kr < KDIM; kr++) {
+            if (kr >= rows.n) break; // rows dropped in the top and bottom border
+            const uint8_t *p = rows.in[kr] + c - hf_kern_dim;
+            for (int32_t kc = 0; kc < KDIM; kc++) {
+                __m512i px = _mm512_cvtepu8_epi16(_mm256_loadu_si256((const __m256i*)(p + kc)));
+                acc = _mm512_add_epi16(acc, _mm512_mullo_epi16(px, taps[kr * KDIM + kc]));
+            }
+        }
+
+        // truncate each lane to its low byte
+        _mm256_storeu_si256((__m256i*)(out + c), _mm512_cvtepi16_epi8(acc));
+    }
+
+    return c;
+}
+
+#endif // CONV_X86
+
+conv_isa_e conv_detect_isa() {
+#ifdef CONV_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx512bw")) return CONV_ISA_AVX512;
+    if (__builtin_cpu_supports("avx2")) return CONV_ISA_AVX2;
+#endif
+    return CONV_ISA_SCALAR;
+}
+
+const char *conv_isa_name(conv_isa_e isa) {
+    switch (isa) {
+    case CONV_ISA_AVX2:   return "avx2";
+    case CONV_ISA_AVX512: return "avx512";
+    default:              return "scalar";
+    };
+}
+
+/**
+ * Filter bank row convolution for a kernel dimension and engine fixed at
+ * compile time, so the tap loops are fully unrolled.
+ */
+template <int KDIM, conv_isa_e ISA>
+static void conv_bank_k(const uint8_t *const *in_rows, uint32_t cols, const uint8_t *kern, uint32_t n_kern, uint8_t *out, uint64_t out_stride) {
+    const int32_t hf_kern_dim = KDIM >> 1;
+    int32_t n_cols = (int32_t)cols;
+
+    // drop the padding rows of the top and bottom border, for each kernel of the bank
+    conv_rows_t bank[MAX_KERN_BANK];
+    bank[0].n = 0;
+    for (int32_t kr = 0; kr < KDIM; kr++) {
+        if (in_rows[kr]) {
+            bank[0].in[bank[0].n] = in_rows[kr];
+            bank[0].kern[bank[0].n] = kern + kr * KDIM;
+            bank[0].n++;
+        }
+    }
+    for (uint32_t k = 1; k < n_kern; k++) {
+        bank[k] = bank[0];
+        for (int32_t i = 0; i < bank[0].n; i++) {
+            bank[k].kern[i] += k * KDIM * KDIM;
+        }
+    }
+
+    // left and right border columns, which are never wider than a half kernel
+    int32_t left_end = hf_kern_dim < n_cols ? hf_kern_dim : n_cols;
+    int32_t right_start = n_cols - hf_kern_dim > left_end ? n_cols - hf_kern_dim : left_end;
+    for (uint32_t k = 0; k < n_kern; k++) {
+        conv_border<KDIM>(bank[k], n_cols, 0, left_end, out + k * out_stride);
+        conv_border<KDIM>(bank[k], n_cols, right_start, n_cols, out + k * out_stride);
+    }
+
+    // interior, tile by tile so the subject columns are reused by every kernel
+    for (int32_t t = left_end; t < right_start; t += CONV_BANK_TILE_COLS) {
+        int32_t t_end = right_start - t < CONV_BANK_TILE_COLS ? right_start : t + CONV_BANK_TILE_COLS;
+
+        for (uint32_t k = 0; k < n_kern; k++) {
+            // the vector engines return where they stopped
+            int32_t c = t;
+#ifdef CONV_X86
+            if (ISA == CONV_ISA_AVX2) {
+                c = conv_interior_avx2<KDIM>(bank[k], c, t_end, out + k * out_stride);
+            }
+            else if (ISA == CONV_ISA_AVX512) {
+                c = conv_interior_avx512<KDIM>(bank[k], c, t_end, out + k * out_stride);
+            }
+#endif
+            conv_interior_scalar<KDIM>(bank[k], c, t_end, out + k * out_stride);
+        }
+    }
+}
+
+/** Row convolution with a single kernel. */
+template <int KDIM, conv_isa_e ISA>
+static void conv_row_k(const uint8_t *const *in_rows, uint32_t cols, const uint8_t *kern, uint8_t *out) {
+    conv_bank_k<KDIM, ISA>(in_rows, cols, kern, 1, out, 0);
+}
+
+#ifdef CONV_X86
+    #define CONV_TABLE(FN, ISA) { &FN<1, ISA>, &FN<3, ISA>, &FN<5, ISA>, &FN<7, ISA> }
+#else
+    // vector engines are never detected, fall back to scalar
+    #define CONV_TABLE(FN, ISA) CONV_TABLE_SCALAR(FN)
+#endif
+#define CONV_TABLE_SCALAR(FN) { &FN<1, CONV_ISA_SCALAR>, &FN<3, CONV_ISA_SCALAR>, &FN<5, CONV_ISA_SCALAR>, &FN<7, CONV_ISA_SCALAR> }
+
+// dispatch tables, indexed by engine then half kernel dimension
+static const conv_row_fn conv_row_table[][(MAX_KERN_DIM >> 1) + 1] = {
+    CONV_TABLE_SCALAR(conv_row_k),
+    CONV_TABLE(conv_row_k, CONV_ISA_AVX2),
+    CONV_TABLE(conv_row_k, CONV_ISA_AVX512),
+};
+static const conv_bank_fn conv_bank_table[][(MAX_KERN_DIM >> 1) + 1] = {
+    CONV_TABLE_SCALAR(conv_bank_k),
+    CONV_TABLE(conv_bank_k, CONV_ISA_AVX2),
+    CONV_TABLE(conv_bank_k, CONV_ISA_AVX512),
+};
+
+conv_row_fn conv_select(conv_isa_e isa, uint8_t kern_dim) {
+    if (!(kern_dim & 1) || kern_dim > MAX_KERN_DIM) return nullptr;
+    return conv_row_table[isa][kern_dim >> 1];
+}
+
+conv_bank_fn conv_select_bank(conv_isa_e isa, uint8_t kern_dim) {
+    if (!(kern_dim & 1) || kern_dim > MAX_KERN_DIM) return nullptr;
+    return conv_bank_table[isa][kern_dim >> 1];
+}
+
+bool conv_row(conv_isa_e isa, const uint8_t *const *in_rows, uint32_t cols, const uint8_t *kern, uint8_t kern_dim, uint8_t *out) {
+    conv_row_fn fn = conv_select(isa, kern_dim);
+    if (!fn) return false;
+    fn(in_rows, cols, kern, out);
+    return true;
+}
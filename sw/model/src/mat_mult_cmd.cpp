@@ -6,6 +6,8 @@
 #include "mat_mult_top.h"
 #include "system.h"
 
+#include <chrono>
+
 mat_mult_cmd::mat_mult_cmd(sc_module_name name, uint8_t *memory, int kernel_size, bool extra_padding, bool do_wait)
     : sc_module(name), _memory(memory), _kernel_size(kernel_size), _extra_padding(extra_padding), _do_wait(do_wait)
 {
@@ -15,50 +17,97 @@ mat_mult_cmd::mat_mult_cmd(sc_module_name name, uint8_t *memory, int kernel_size
 void mat_mult_cmd::do_mat_mult() {
     wait(CC_CORE(10), SC_NS);
     mm_if->reset();
-    LOGF("[%s] Done startup and reset", this->name());
-
-    // send kernel
-    _verif_ack = false;
-    _sent_subject = false;
-    mm_if->send_cmd(_memory, MM_CMD_KERN, _kernel_size, _kernel_size, UNUSED_ADDR, 0, KERN_ADDR);
-    LOGF("[%s] Done kernel", this->name());
+    LOG_INFO(this->name(), "Done startup and reset");
 
-    // wait until acknowledge verified
-    while (!_verif_ack) {
-        if (_do_wait) POS_PROC();
-    }
+    // post kernel once for the whole sequence
+    _n_posted = 0;
+    _n_frames_done = 0;
+    _kern_trans_id = mm_if->post_cmd(_memory, MM_CMD_KERN, _kernel_size, _kernel_size, next_ack_addr(), 0, KERN_ADDR, N_KERN);
+    LOG_INFO(this->name(), "Posted kernel");
 
-    // send subject
-    _verif_ack = false;
-    _sent_subject = true;
+    // post the frames back to back, each posting waits while the queue is full
     uint32_t hf_kernel_size = _kernel_size >> 1;
-    if (_extra_padding) {
-        mm_if->send_cmd(_memory, MM_CMD_SUBJ, MAT_ROWS+hf_kernel_size, MAT_COLS, UNUSED_ADDR, OUT_ADDR, MAT_ADDR);
-    }
-    else {
-        mm_if->send_cmd(_memory, MM_CMD_SUBJ, MAT_ROWS, MAT_COLS, UNUSED_ADDR, OUT_ADDR, MAT_ADDR);
+    uint32_t rows = _extra_padding ? MAT_ROWS+hf_kernel_size : MAT_ROWS;
+    _wall_start = std::chrono::steady_clock::now();
+    for (uint32_t i = 0; i < N_FRAMES; i++) {
+        // a buffer is reused once the frame before in the buffer is acknowledged
+        while (i >= _n_frames_done + N_FRAME_BUFS) {
+            wait_ack();
+        }
+        if (i && !frameLoad(_memory, i)) {
+            sc_stop();
+            return;
+        }
+
+        mm_if->post_cmd(_memory, MM_CMD_SUBJ, rows, MAT_COLS, next_ack_addr(), FRAME_OUT_ADDR(i), FRAME_MAT_ADDR(i));
+        LOG_INFO(this->name(), "Posted frame %d", i);
+        sc_tracer::trigger("frame", i);
     }
-    LOGF("[%s] Done subject", this->name());
 
-    // wait until acknowledge verified
-    while (!_verif_ack) {
-        if (_do_wait) POS_PROC();
+    // wait until all acknowledges verified
+    while (mm_if->n_outstanding()) {
+        wait_ack();
     }
 }
 
+void mat_mult_cmd::wait_ack() {
+    if (_do_wait) POS_PROC();
+    else wait(mm_if->ack_event());
+}
+
+uint32_t mat_mult_cmd::next_ack_addr() {
+    // one acknowledge slot per command in flight
+    return (uint32_t)(BUILD_ACK_ADDR(_n_posted++ % QUEUE_DEPTH));
+}
+
 void mat_mult_cmd::raise_interrupt() {
-    LOGF("[%s] Received interrupt", this->name());
+    LOG_DEBUG(this->name(), "Received interrupt");
 
-    if (mm_if->verify_ack(_memory, UNUSED_ADDR)) {
-        LOGF("[%s] Error in ack packet", this->name());
-        sc_stop();
-        return;
+    // acknowledges are matched by transaction ID, in any order
+    uint32_t trans_id;
+    int status;
+    while ((status = mm_if->collect_ack(_memory, &trans_id)) >= 0) {
+        if (status) {
+            LOG_ERROR(this->name(), "Error in ack packet");
+            sc_stop();
+            return;
+        }
+
+        LOG_INFO(this->name(), "Transaction %d done after %s, %d in flight (max %d)", trans_id,
+            mm_if->last_latency().to_string().c_str(), mm_if->n_outstanding(), mm_if->max_outstanding());
+        if (trans_id != _kern_trans_id) {
+            frame_done();
+        }
+    }
+}
+
+void mat_mult_cmd::frame_done() {
+    // latency from posting to acknowledge
+    sc_time latency = mm_if->last_latency();
+    if (!_n_frames_done) {
+        _first_frame_time = sc_time_stamp();
+        _min_latency = latency;
+        _max_latency = latency;
+        _sum_latency = SC_ZERO_TIME;
     }
+    if (latency < _min_latency) _min_latency = latency;
+    if (latency > _max_latency) _max_latency = latency;
+    _sum_latency += latency;
+    _n_frames_done++;
 
-    _verif_ack = true;
-    if(_sent_subject) {
-        // done with subject
-        LOGF("[%s] Done!", this->name());
-        sc_stop();
+    if (_n_frames_done < N_FRAMES) {
+        return;
     }
+
+    // sustained rate between the first and the last frame, simulated and on the host
+    double sim_s = (sc_time_stamp() - _first_frame_time).to_seconds();
+    double wall_s = std::chrono::duration<double>(std::chrono::steady_clock::now() - _wall_start).count();
+    LOG_INFO(this->name(), "%d frames, %.2f frames/s (simulated), %.2f frames/s (host)", N_FRAMES,
+        N_FRAMES > 1 && sim_s > 0 ? (N_FRAMES - 1) / sim_s : 1.0 / latency.to_seconds(), N_FRAMES / wall_s);
+    LOG_INFO(this->name(), "Frame latency min %s, avg %s, max %s", _min_latency.to_string().c_str(),
+        (_sum_latency / (double)N_FRAMES).to_string().c_str(), _max_latency.to_string().c_str());
+
+    // done with the frames
+    LOG_INFO(this->name(), "Done!");
+    sc_stop();
 }
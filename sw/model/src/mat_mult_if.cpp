@@ -6,85 +6,144 @@
 #include "mat_mult_top.h"
 #include "system.h"
 
-// generate command field
-#define GEN_COMMAND(type, out_addr) \
-    ((type & 0b1) << 30) | ((out_addr & 0xffffffff) >> 3)
-
-// generate size field
-#define GEN_KERN_SIZE(rows, cols) \
-    ((((rows * cols) & 0x7fff) << 15) | ((rows & 0x7ff) << 4) | (cols & 0xf))
-#define GEN_SUBJ_SIZE(rows, cols) \
-    ((((rows * (cols >> 7)) & 0x7fff) << 15) | ((rows & 0x7ff) << 4)  | ((cols >> 7) & 0xf))
-
-
 mat_mult_if::mat_mult_if()
-    : _cur_trans_id(0)
+    : _cur_trans_id(0), _deliver_trans_id(0), _n_outstanding(0), _max_outstanding(0)
 {
+    for (int i = 0; i < MAX_QUEUE_DEPTH; ++i) {
+        _queue[i].outstanding = false;
+    }
+}
 
+uint32_t mat_mult_if::post_cmd(uint8_t *ext_mem, unsigned int cmd_type, unsigned int rows, unsigned int cols, unsigned int tx_addr, unsigned int out_addr, unsigned int in_addr, unsigned int n_kern) {
+    uint32_t trans_id = enqueue_cmd(ext_mem, cmd_type, rows, cols, tx_addr, out_addr, in_addr, n_kern);
+    _posted_event.notify(SC_ZERO_TIME);
+
+    return trans_id;
 }
 
-void mat_mult_if::send_cmd(uint8_t *ext_mem, unsigned int cmd_type, unsigned int rows, unsigned int cols, unsigned int tx_addr, unsigned int out_addr, unsigned int in_addr) {
+uint32_t mat_mult_if::enqueue_cmd(uint8_t *ext_mem, unsigned int cmd_type, unsigned int rows, unsigned int cols, unsigned int tx_addr, unsigned int out_addr, unsigned int in_addr, unsigned int n_kern) {
+    // wait for the slot of the transaction to be acknowledged
+    mat_mult_queue_entry_t *entry = _queue + (_cur_trans_id % QUEUE_DEPTH);
+    while (entry->outstanding) {
+        wait(_ack_event);
+    }
+
     // construct command
-    _cmd.s_key    = MM_S_KEY;
-    _cmd.command  = GEN_COMMAND(cmd_type, out_addr);
+    mat_mult_cmd_t &cmd = entry->cmd;
+    cmd.s_key    = MM_S_KEY;
+    cmd.command  = GEN_COMMAND(cmd_type, out_addr);
+    cmd.reserved = 0;
     if (cmd_type == MM_CMD_KERN) {
-        _cmd.size = GEN_KERN_SIZE(rows, cols);
+        cmd.size = GEN_KERN_SIZE(rows, cols, n_kern);
+        cmd.reserved = GEN_KERN_RSVD(n_kern);
     }
     else if (cmd_type == MM_CMD_SUBJ) {
-        _cmd.size = GEN_SUBJ_SIZE(rows, cols);
-    }
-    _cmd.tx_addr  = tx_addr;
-    _cmd.trans_id = _cur_trans_id;
-    _cmd.reserved = 0;
-    _cmd.e_key    = MM_E_KEY;
-    _cmd.chksum   = CALC_CMD_CHKSUM(_cmd);
-
-    LOGF("[mat_mult_if] Commanding to write to %d", out_addr);
-
-    // send command
-    _packets = (uint64_t*)&_cmd;
-    for (int i = 0; i < N_PACKETS_IN_CMD; ++i) {
-        receive_packet((i << 3) + OFFSET_COMMAND, _packets[i]);
+        cmd.size = GEN_SUBJ_SIZE(rows, cols);
+        cmd.reserved = GEN_SUBJ_RSVD(rows, cols);
     }
+    cmd.tx_addr  = tx_addr;
+    cmd.trans_id = _cur_trans_id;
+    cmd.e_key    = MM_E_KEY;
+    cmd.chksum   = CALC_CMD_CHKSUM(cmd);
 
     // calculate number of packets to send
     int n = rows * cols;
+    if (cmd_type == MM_CMD_KERN) {
+        n *= n_kern;
+    }
     if (n & 0b111) {
         n += 8;
     }
     n >>= 3;
 
+    entry->ext_mem = ext_mem;
+    entry->in_addr = in_addr;
+    entry->n_packets = n;
+    entry->outstanding = true;
+    entry->post_time = sc_time_stamp();
+
+    // count commands in flight
+    _n_outstanding++;
+    if (_n_outstanding > _max_outstanding) {
+        _max_outstanding = _n_outstanding;
+    }
+
+    return _cur_trans_id++;
+}
+
+void mat_mult_if::deliver_cmd() {
+    mat_mult_queue_entry_t *entry = _queue + (_deliver_trans_id % QUEUE_DEPTH);
+    _deliver_trans_id++;
+
+    latency_tracker::publish(COMMAND_ACK, entry->cmd.trans_id);
+    LOG_DEBUG("mat_mult_if", "Commanding transaction %d to write to %d", entry->cmd.trans_id, GET_CMD_OUT_ADDR(entry->cmd));
+
+    // send command
+    uint64_t *packets = (uint64_t*)&entry->cmd;
+    for (uint32_t i = 0; i < N_PACKETS_IN_CMD; ++i) {
+        receive_packet((i << 3) + OFFSET_COMMAND, packets[i]);
+    }
+
     // send payload
-    _packets = (uint64_t*)(ext_mem + in_addr);
-    for (int i = 0; i < n; ++i) {
-        // generate address to wrap
-        uint64_t addr = (uint64_t)(i & 0xf); // wrap every 16 packets
-        addr <<= 3; // shift to 64-bit boundary
-        addr += OFFSET_PAYLOAD; // add offset
-
-        // transmit
-        receive_packet(addr, _packets[i]);
+    send_payload(entry->ext_mem, entry->in_addr, entry->n_packets);
+}
+
+bool mat_mult_if::send_payload(uint8_t *ext_mem, uint64_t in_addr, uint32_t n) {
+    // addresses wrap every 16 packets
+    return receive_packets(OFFSET_PAYLOAD, (const uint64_t*)(ext_mem + in_addr), n);
+}
+
+bool mat_mult_if::receive_packets(uint64_t addr, const uint64_t *packets, uint32_t n) {
+    for (uint32_t i = 0; i < n; ++i) {
+        receive_packet(BURST_ADDR(addr, i), packets[i]);
     }
+    return true;
 }
 
-int mat_mult_if::verify_ack(uint8_t *ext_mem, unsigned int tx_addr) {
+int mat_mult_if::verify_ack(uint8_t *ext_mem, unsigned int tx_addr, uint32_t *trans_id) {
     // read ack
-    memcpy(&_ack, ext_mem + _cmd.tx_addr, sizeof(_ack));
+    memcpy(&_ack, ext_mem + tx_addr, sizeof(_ack));
+
+    // find the command in flight
+    mat_mult_queue_entry_t *entry = _queue + (_ack.trans_id % QUEUE_DEPTH);
+    LOG_DEBUG("mat_mult_if", "Ack trans_id is %d for transaction %d and status is %d", _ack.trans_id, entry->cmd.trans_id, _ack.status);
 
     // verify acknowledge packet
-    LOGF("[mat_mult_if] Ack trans_id is %d for transaction %d and status is %d", _ack.trans_id, _cmd.trans_id, _ack.status);
-    if (!CMP_CMD_ACK(_cmd, _ack)) {
-        LOG("[mat_mult_if] ERROR>>> Acknowledge packet does not match command.");
+    if (!entry->outstanding || !CMP_CMD_ACK(entry->cmd, _ack)) {
+        LOG_ERROR("mat_mult_if", "Acknowledge packet does not match command.");
         return MM_STAT_ERR_OTHER;
     }
 
-    // increment transaction ID for next transaction
-    _cur_trans_id++;
+    latency_tracker::capture(COMMAND_ACK, _ack.trans_id);
+
+    // release the slot for the next transaction
+    entry->outstanding = false;
+    _n_outstanding--;
+    _last_latency = sc_time_stamp() - entry->post_time;
+    _ack_event.notify();
+    if (trans_id) {
+        *trans_id = _ack.trans_id;
+    }
 
     // return the status
     return _ack.status;
 }
 
+int mat_mult_if::collect_ack(uint8_t *ext_mem, uint32_t *trans_id) {
+    for (uint32_t i = 0; i < QUEUE_DEPTH; ++i) {
+        mat_mult_queue_entry_t *entry = _queue + i;
+        if (!entry->outstanding) continue;
+
+        // acknowledge packet written for this transaction
+        mat_mult_ack_t *ack = (mat_mult_ack_t*)(ext_mem + entry->cmd.tx_addr);
+        if (ack->s_key == MM_S_KEY && ack->trans_id == entry->cmd.trans_id) {
+            return verify_ack(ext_mem, entry->cmd.tx_addr, trans_id);
+        }
+    }
+
+    return -1;
+}
+
 void mat_mult_if::reset() {
     protected_reset();
     private_reset();
@@ -92,4 +151,10 @@ void mat_mult_if::reset() {
 
 void mat_mult_if::private_reset() {
     _cur_trans_id = 0;
+    _deliver_trans_id = 0;
+    _n_outstanding = 0;
+    _max_outstanding = 0;
+    for (int i = 0; i < MAX_QUEUE_DEPTH; ++i) {
+        _queue[i].outstanding = false;
+    }
 }
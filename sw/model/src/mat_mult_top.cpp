@@ -4,12 +4,19 @@
 #include "mat_mult_if.h"
 #include "mat_mult_cmd.h"
 #include "mat_mult_top.h"
+#include "perf_counters.h"
 #include "system.h"
 
+#include <string.h>
+
 mat_mult_top::mat_mult_top(sc_module_name name)
-    : sc_module(name), mat_mult_if()
+    : sc_module(name), mat_mult_if(), _n_delivered(0), _n_decoded(0), _output_packets(0), _output_bytes(0), _ack_writes(0)
 {
+    perf_counters::add(this->name(), "output_packets", &_output_packets);
+    perf_counters::add(this->name(), "output_bytes", &_output_bytes);
+    perf_counters::add(this->name(), "ack_writes", &_ack_writes);
 
+    SC_THREAD(process_queue);
 }
 
 void mat_mult_top::calculate_next_state() {
@@ -36,7 +43,7 @@ void mat_mult_top::calculate_next_state() {
 
         // advance state
         _next_state = WAIT_CMD_SIZE;
-        LOGF("WAIT_CMD_SKEY: received %08x, %08x, new status %d", _cur_cmd.s_key, _cur_cmd.command, _cur_ack.status);
+        LOG_DEBUG("mat_mult_top", "WAIT_CMD_SKEY: received %08x, %08x, new status %d", _cur_cmd.s_key, _cur_cmd.command, _cur_ack.status);
         break;
     }
     case WAIT_CMD_SIZE:
@@ -50,15 +57,21 @@ void mat_mult_top::calculate_next_state() {
 
             if ((rows != cols) ||      // kernel must be square
                 ((rows & 0b1) == 0) || // kernel must have an odd dimension
-                (rows > MAX_KERN_DIM)) // kernel size constraint
+                (rows > MAX_KERN_DIM) || // kernel size constraint
+                (GET_CMD_SIZE_NELS(_cur_cmd) != rows * cols * GET_CMD_KERN_BANK(_cur_cmd)) || // payload holds the whole bank
+                !configure_kernel((uint8_t)rows, (uint8_t)GET_CMD_KERN_BANK(_cur_cmd)))
                 _cur_ack.status |= MM_STAT_ERR_SIZE;
         }
         else if (_regs.cmd_type_reg.is_subj) {
             rows = (uint16_t)(GET_CMD_SIZE_SUBJ_ROWS(_cur_cmd));
             cols = (uint16_t)(GET_CMD_SIZE_SUBJ_COLS(_cur_cmd));
+
+            if ((GET_CMD_SIZE_SUBJ_ROWS(_cur_cmd) == 0) || (GET_CMD_SIZE_SUBJ_ROWS(_cur_cmd) > MAX_MAT_ROWS) || // subject size constraint
+                (GET_CMD_SIZE_SUBJ_COLS(_cur_cmd) == 0) || (GET_CMD_SIZE_SUBJ_COLS(_cur_cmd) > MAX_MAT_COLS))
+                _cur_ack.status |= MM_STAT_ERR_SIZE;
         }
 
-        LOGF("[mat_mult_top] Expecting matrix of size %dx%d", rows, cols);
+        LOG_DEBUG("mat_mult_top", "Expecting matrix of size %dx%d", rows, cols);
 
         // latch in acknowledge message
         _cur_ack.size = _cur_cmd.size;
@@ -66,7 +79,7 @@ void mat_mult_top::calculate_next_state() {
 
         // advance state
         _next_state = WAIT_CMD_TID;
-        LOGF("WAIT_CMD_SIZE: received %08x, %08x, new status %d", _cur_cmd.size, _cur_cmd.tx_addr, _cur_ack.status);
+        LOG_DEBUG("mat_mult_top", "WAIT_CMD_SIZE: received %08x, %08x, new status %d", _cur_cmd.size, _cur_cmd.tx_addr, _cur_ack.status);
         break;
     }
     case WAIT_CMD_TID:
@@ -76,7 +89,7 @@ void mat_mult_top::calculate_next_state() {
 
         // advance state
         _next_state = WAIT_CMD_EKEY;
-        LOGF("WAIT_CMD_TID: received %08x, %08x, new status %d", _cur_cmd.trans_id, _cur_cmd.reserved, _cur_ack.status);
+        LOG_DEBUG("mat_mult_top", "WAIT_CMD_TID: received %08x, %08x, new status %d", _cur_cmd.trans_id, _cur_cmd.reserved, _cur_ack.status);
         break;
     }
     case WAIT_CMD_EKEY:
@@ -102,7 +115,7 @@ void mat_mult_top::calculate_next_state() {
             }
         }
 
-        LOGF("WAIT_CMD_EKEY: received %08x, %08x, new status %d", _cur_cmd.e_key, _cur_cmd.chksum, _cur_ack.status);
+        LOG_DEBUG("mat_mult_top", "WAIT_CMD_EKEY: received %08x, %08x, new status %d", _cur_cmd.e_key, _cur_cmd.chksum, _cur_ack.status);
         break;
     }
     case WAIT_DATA:
@@ -121,25 +134,74 @@ void mat_mult_top::calculate_next_state() {
 }
 
 void mat_mult_top::advance_state() {
+    // the header is decoded when the FSM leaves the end key, accepted or not
+    if (_cur_state == WAIT_CMD_EKEY && _next_state != WAIT_CMD_EKEY) {
+        _n_decoded++;
+    }
+
     _cur_state = _next_state;
+    if (accepts_cmd()) {
+        _accept_event.notify(SC_ZERO_TIME);
+    }
 }
 
 void mat_mult_top::protected_reset() {
     _cur_state = WAIT_CMD_SKEY;
+    _n_decoded = _n_delivered;
+    _accept_event.notify(SC_ZERO_TIME);
 }
 
 void mat_mult_top::write_ack() {
     // write ack packet to CPU
-    uint64_t *packets = (uint64_t*)&_cur_ack;
-    for (int i = 0; i < N_PACKETS_IN_CMD; ++i) {
-        mem_if->write((uint64_t)(_cur_cmd.tx_addr), *packets);
-
-        // advance cursors
-        _cur_cmd.tx_addr += 8;
-        packets += 1;
-    }
+    store_mem((uint64_t)(_cur_cmd.tx_addr), (uint64_t*)&_cur_ack, N_PACKETS_IN_CMD);
+    _ack_writes++;
+    _cur_cmd.tx_addr += N_PACKETS_IN_CMD * 8;
 
     // raise interrupt
+    signal_ack();
+}
+
+void mat_mult_top::signal_ack() {
     cmd_if->raise_interrupt();
 }
 
+void mat_mult_top::write_mem(uint64_t addr, const uint64_t *packets, uint64_t n) {
+    _output_packets += n;
+    _output_bytes += n * sizeof(uint64_t);
+    store_mem(addr, packets, n);
+}
+
+void mat_mult_top::store_mem(uint64_t addr, const uint64_t *packets, uint64_t n) {
+    uint64_t n_bytes = n * sizeof(uint64_t);
+
+    // request the grant once, and again when the memory invalidated it, a refusal is kept until then
+    if (!mem_if->dmi_current(_mem_dmi)) {
+        _mem_dmi = memory_dmi_t();
+        mem_if->get_direct_mem_ptr(addr, _mem_dmi);
+    }
+
+    if (_mem_dmi.write_allowed && _mem_dmi.covers(addr, n_bytes)) {
+        memcpy(_mem_dmi.ptr + (addr - _mem_dmi.start_addr), packets, n_bytes);
+        mem_if->count_dmi(addr, n, true);
+    }
+    else {
+        mem_if->write_block(addr, packets, n);
+    }
+}
+
+void mat_mult_top::process_queue() {
+    while (true) {
+        // wait for a posted command
+        while (!cmd_queued()) {
+            wait(cmd_posted_event());
+        }
+
+        // deliver the next command once the module accepts it, on the next core clock edge
+        while (!accepts_cmd()) {
+            IDLE_CORE(_accept_event);
+        }
+
+        _n_delivered++;
+        deliver_cmd();
+    }
+}
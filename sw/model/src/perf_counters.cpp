@@ -0,0 +1,157 @@
+#include "perf_counters.h"
+#include "system.h"
+#include "systemc.h"
+
+#include <iostream>
+#include <string.h>
+
+perf_counters perf_counters::counters;
+
+/**
+ * Samples the counters every `period` core cycles, until the rest of the
+ * model has no more activity so the sampling does not keep the run alive.
+ */
+class perf_sampler : public sc_module {
+
+    public:
+
+        SC_HAS_PROCESS(perf_sampler);
+        perf_sampler(sc_module_name name, uint64_t period)
+            : sc_module(name), _period(period)
+        {
+            SC_THREAD(main);
+        }
+
+    private:
+
+        uint64_t _period;
+
+        void main() {
+            double period_ns = CC_CORE(_period);
+            while (true) {
+                wait(period_ns, SC_NS);
+                perf_counters::sample();
+                if (!sc_pending_activity()) return;
+            }
+        }
+
+};
+
+perf_counters::perf_counters()
+    : _out(nullptr)
+{
+}
+
+uint32_t perf_counters::add(const std::string &module, const char *name, const uint64_t *value) {
+    perf_reg_t reg;
+    reg.name = module + "." + name;
+    reg.value = value;
+    counters._regs.push_back(reg);
+    return PERF_REG_BASE + (uint32_t)(counters._regs.size() - 1) * PERF_REG_STRIDE;
+}
+
+bool perf_counters::read(uint32_t addr, uint64_t &data) {
+    if ((addr - PERF_REG_BASE) % PERF_REG_STRIDE) return false;
+    uint32_t i = (addr - PERF_REG_BASE) / PERF_REG_STRIDE;
+    if (i >= counters._regs.size()) return false;
+    data = *counters._regs[i].value;
+    return true;
+}
+
+bool perf_counters::find(const std::string &name, uint32_t &addr) {
+    for (uint32_t i = 0; i < counters._regs.size(); i++) {
+        if (counters._regs[i].name == name) {
+            addr = PERF_REG_BASE + i * PERF_REG_STRIDE;
+            return true;
+        }
+    }
+    return false;
+}
+
+void perf_counters::set_config(const char *name, uint64_t value) {
+    for (perf_config_t &cfg : counters._config) {
+        if (cfg.name == name) {
+            cfg.value = value;
+            return;
+        }
+    }
+    counters._config.push_back({name, value});
+}
+
+bool perf_counters::configure(const std::string &file, uint64_t period) {
+    if (file.empty()) return true;
+    counters._out = fopen(file.c_str(), "w");
+    if (!counters._out) {
+        std::cerr << "*** ERROR in main: could not open the performance counter file " << file << std::endl;
+        return false;
+    }
+    if (period) {
+        new perf_sampler("perf_sampler", period);
+    }
+    return true;
+}
+
+void perf_counters::sample() {
+    if (!counters._out) return;
+    perf_sample_t s;
+    s.time_ns = sc_time_stamp().to_seconds() * 1e9;
+    s.values.reserve(counters._regs.size());
+    for (const perf_reg_t &reg : counters._regs) {
+        s.values.push_back(*reg.value);
+    }
+    counters._samples.push_back(s);
+}
+
+void perf_counters::finish() {
+    if (!counters._out) return;
+    sample();
+    counters.write_json();
+    fclose(counters._out);
+    counters._out = nullptr;
+}
+
+/** Whether `s` ends with `suffix`. */
+static bool ends_with(const std::string &s, const char *suffix) {
+    size_t n = strlen(suffix);
+    return s.size() >= n && s.compare(s.size() - n, n, suffix) == 0;
+}
+
+void perf_counters::write_json() {
+    FILE *f = _out;
+    fprintf(f, "{\n  \"config\": {");
+    for (size_t i = 0; i < _config.size(); i++) {
+        fprintf(f, "%s\n    \"%s\": %llu", i ? "," : "", _config[i].name.c_str(), (unsigned long long)_config[i].value);
+    }
+    fprintf(f, "\n  },\n  \"clock_ns\": %g,\n  \"registers\": {", CC_CORE_NS);
+    for (size_t i = 0; i < _regs.size(); i++) {
+        fprintf(f, "%s\n    \"%s\": %zu", i ? "," : "", _regs[i].name.c_str(), PERF_REG_BASE + i * PERF_REG_STRIDE);
+    }
+    fprintf(f, "\n  },\n  \"samples\": [");
+    for (size_t s = 0; s < _samples.size(); s++) {
+        fprintf(f, "%s\n    {\"time_ns\": %.3f, \"core_cycles\": %llu, \"counters\": {", s ? "," : "",
+            _samples[s].time_ns, (unsigned long long)(_samples[s].time_ns / CC_CORE_NS));
+        for (size_t i = 0; i < _samples[s].values.size(); i++) {
+            fprintf(f, "%s\"%s\": %llu", i ? ", " : "", _regs[i].name.c_str(), (unsigned long long)_samples[s].values[i]);
+        }
+        fprintf(f, "}}");
+    }
+
+    // the cycle counters of the whole run and their fraction of it, the idle cycles are the rest of the busy cycles
+    const perf_sample_t &last = _samples.back();
+    uint64_t cycles = (uint64_t)(last.time_ns / CC_CORE_NS);
+    fprintf(f, "\n  ],\n  \"summary\": {\n    \"core_cycles\": %llu", (unsigned long long)cycles);
+    for (size_t i = 0; i < last.values.size(); i++) {
+        const std::string &name = _regs[i].name;
+        if (!ends_with(name, PERF_CYCLES_SUFFIX)) continue;
+        write_cycles(name, last.values[i], cycles);
+        if (ends_with(name, PERF_BUSY_SUFFIX)) {
+            std::string idle = name.substr(0, name.size() - strlen(PERF_BUSY_SUFFIX)) + PERF_IDLE_SUFFIX;
+            write_cycles(idle, cycles > last.values[i] ? cycles - last.values[i] : 0, cycles);
+        }
+    }
+    fprintf(f, "\n  }\n}\n");
+}
+
+void perf_counters::write_cycles(const std::string &name, uint64_t n, uint64_t total) {
+    fprintf(_out, ",\n    \"%s\": {\"cycles\": %llu, \"fraction\": %.6f}", name.c_str(), (unsigned long long)n, total ? (double)n / total : 0.0);
+}
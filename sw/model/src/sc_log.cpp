@@ -0,0 +1,352 @@
+#include "sc_log.h"
+#include "systemc.h"
+
+#include <chrono>
+#include <iostream>
+#include <string>
+#include <unordered_map>
+
+// writer thread back-off when the ring is empty
+#define LOG_IDLE_US 200
+
+// level names, indexed by level
+static const char *log_level_names[] = {"error", "warn", "info", "debug"};
+
+// interned format strings and modules of the binary log
+static std::unordered_map<const char*, uint32_t> log_bin_fmts;
+static std::unordered_map<std::string, uint32_t> log_bin_modules;
+
+// defined after the maps above, so its writer thread stops before they are destroyed
+sc_logger sc_logger::logger;
+
+sc_logger::sc_logger()
+    : _default_level(LOG_LVL_INFO), _max_level(LOG_LVL_INFO), _n_rules(0),
+      _enq(0), _deq(0), _written(0), _started(false), _stop(false), _res_ns(1.0), _out(stdout), _binary(false)
+{
+    _ring = new log_slot_t[LOG_RING_SIZE];
+    for (uint64_t i = 0; i < LOG_RING_SIZE; i++) {
+        _ring[i].seq.store(i, std::memory_order_relaxed);
+    }
+}
+
+sc_logger::~sc_logger() {
+    if (_started.load(std::memory_order_acquire)) {
+        _stop.store(true, std::memory_order_release);
+        _writer.join();
+    }
+    if (_out != stdout) {
+        fclose(_out);
+    }
+    delete[] _ring;
+}
+
+/** Parse a level name or number, -1 if invalid. */
+static int parse_level(const std::string &name) {
+    for (int l = LOG_LVL_ERROR; l <= LOG_LVL_DEBUG; l++) {
+        if (name == log_level_names[l] || name == std::to_string(l)) return l;
+    }
+    return -1;
+}
+
+bool sc_logger::configure(const std::string &filters, const std::string &file, bool binary) {
+    // filters
+    size_t start = 0;
+    while (start < filters.size()) {
+        size_t end = filters.find(',', start);
+        if (end == std::string::npos) end = filters.size();
+        std::string rule = filters.substr(start, end - start);
+        start = end + 1;
+        if (rule.empty()) continue;
+
+        size_t colon = rule.rfind(':');
+        int level = parse_level(colon == std::string::npos ? rule : rule.substr(colon + 1));
+        if (level < 0) {
+            std::cerr << "*** ERROR in main: invalid log rule " << rule << ", expected [<MODULE>:]<error|warn|info|debug>" << std::endl;
+            return false;
+        }
+
+        if (colon == std::string::npos || rule.substr(0, colon) == "*") {
+            logger._default_level = level;
+            continue;
+        }
+        if (logger._n_rules == LOG_MAX_RULES || colon >= LOG_MODULE_SIZE) {
+            std::cerr << "*** ERROR in main: too many or too long log rules, max is " << LOG_MAX_RULES << std::endl;
+            return false;
+        }
+
+        log_rule_t &r = logger._rules[logger._n_rules++];
+        r.prefix = rule[colon - 1] == '*';
+        r.len = (uint32_t)(r.prefix ? colon - 1 : colon);
+        copy_str(r.pattern, rule.c_str(), r.len + 1);
+        r.level = level;
+    }
+
+    // the least severe level of any rule passes the first check of `enabled`
+    logger._max_level = logger._default_level;
+    for (uint32_t i = 0; i < logger._n_rules; i++) {
+        if (logger._rules[i].level > logger._max_level) logger._max_level = logger._rules[i].level;
+    }
+
+    // output
+    logger._binary = binary;
+    if (!file.empty()) {
+        logger._out = fopen(file.c_str(), binary ? "wb" : "w");
+        if (!logger._out) {
+            std::cerr << "*** ERROR in main: cannot open log file " << file << std::endl;
+            logger._out = stdout;
+            return false;
+        }
+    }
+    else if (binary) {
+        std::cerr << "*** ERROR in main: binary logs need --log_file" << std::endl;
+        return false;
+    }
+
+    return true;
+}
+
+bool sc_logger::module_enabled(int level, const char *module) const {
+    int module_level = _default_level;
+    for (uint32_t i = 0; i < _n_rules; i++) {
+        const log_rule_t &r = _rules[i];
+        if (strncmp(module, r.pattern, r.len) == 0 && (r.prefix || module[r.len] == '\0')) {
+            module_level = r.level;
+        }
+    }
+    return level <= module_level;
+}
+
+void sc_logger::log_str(int level, const char *module, const std::string &msg) {
+    uint64_t pos;
+    log_record_t *rec = logger.acquire(&pos);
+    rec->time = now();
+    rec->fmt = nullptr;
+    rec->level = (uint8_t)level;
+    rec->n_args = 0;
+    rec->str_len = (uint16_t)copy_str(rec->str, msg.c_str(), LOG_STR_SIZE);
+
+    // mark a truncated message
+    if (msg.size() >= LOG_STR_SIZE) {
+        memcpy(rec->str + LOG_STR_SIZE - sizeof(LOG_STR_TRUNC), LOG_STR_TRUNC, sizeof(LOG_STR_TRUNC));
+    }
+    copy_str(rec->module, module, LOG_MODULE_SIZE);
+    logger.release(pos);
+}
+
+void sc_logger::flush() {
+    if (!logger._started.load(std::memory_order_acquire)) return;
+    uint64_t target = logger._enq.load(std::memory_order_acquire);
+    while (logger._written.load(std::memory_order_acquire) < target) {
+        std::this_thread::yield();
+    }
+}
+
+log_record_t *sc_logger::acquire(uint64_t *pos) {
+    if (!_started.load(std::memory_order_acquire)) {
+        std::call_once(_start_flag, &sc_logger::start, this);
+    }
+
+    uint64_t p = _enq.load(std::memory_order_relaxed);
+    while (true) {
+        log_slot_t &slot = _ring[p & LOG_RING_PTR_MASK];
+        int64_t diff = (int64_t)slot.seq.load(std::memory_order_acquire) - (int64_t)p;
+        if (diff == 0) {
+            if (_enq.compare_exchange_weak(p, p + 1, std::memory_order_relaxed)) {
+                *pos = p;
+                return &slot.rec;
+            }
+        }
+        else if (diff < 0) {
+            // full, the writer thread frees a slot
+            std::this_thread::yield();
+            p = _enq.load(std::memory_order_relaxed);
+        }
+        else {
+            p = _enq.load(std::memory_order_relaxed);
+        }
+    }
+}
+
+void sc_logger::start() {
+    _res_ns = sc_get_time_resolution().to_seconds() * 1e9;
+    if (_binary) {
+        fwrite(LOG_BIN_MAGIC, 1, sizeof(LOG_BIN_MAGIC) - 1, _out);
+        fwrite(&_res_ns, sizeof(_res_ns), 1, _out);
+    }
+    _writer = std::thread(&sc_logger::drain, this);
+    _started.store(true, std::memory_order_release);
+}
+
+uint64_t sc_logger::now() {
+    return sc_time_stamp().value();
+}
+
+void sc_logger::drain() {
+    while (true) {
+        log_slot_t &slot = _ring[_deq & LOG_RING_PTR_MASK];
+        if (slot.seq.load(std::memory_order_acquire) != _deq + 1) {
+            // empty, publish what was written
+            fflush(_out);
+            _written.store(_deq, std::memory_order_release);
+            if (_stop.load(std::memory_order_acquire) && slot.seq.load(std::memory_order_acquire) != _deq + 1) break;
+            std::this_thread::sleep_for(std::chrono::microseconds(LOG_IDLE_US));
+            continue;
+        }
+
+        if (_binary) write_binary(slot.rec);
+        else write_text(slot.rec);
+
+        slot.seq.store(_deq + LOG_RING_SIZE, std::memory_order_release);
+        _deq++;
+    }
+}
+
+/** Format one conversion of `spec` with `arg`, the length modifiers are replaced to match the captured type. */
+static void format_arg(std::string &line, const log_record_t &rec, const char *spec, uint32_t spec_len, char conv, const log_arg_t &arg) {
+    char fmt[32];
+    char buf[256];
+    memcpy(fmt, spec, spec_len);
+    fmt[spec_len] = '\0';
+
+    int64_t i = arg.type == LOG_ARG_INT ? arg.i : arg.type == LOG_ARG_DOUBLE ? (int64_t)arg.d : (int64_t)arg.u;
+    switch (conv) {
+    case 'd': case 'i':
+        strcat(fmt, "lld");
+        snprintf(buf, sizeof(buf), fmt, (long long)i);
+        break;
+    case 'u': case 'x': case 'X': case 'o':
+        strcat(fmt, "ll");
+        fmt[spec_len + 2] = conv;
+        fmt[spec_len + 3] = '\0';
+        snprintf(buf, sizeof(buf), fmt, (unsigned long long)i);
+        break;
+    case 'c':
+        strcat(fmt, "c");
+        snprintf(buf, sizeof(buf), fmt, (int)i);
+        break;
+    case 'f': case 'F': case 'e': case 'E': case 'g': case 'G': case 'a': case 'A':
+        fmt[spec_len] = conv;
+        fmt[spec_len + 1] = '\0';
+        snprintf(buf, sizeof(buf), fmt, arg.type == LOG_ARG_DOUBLE ? arg.d : (double)i);
+        break;
+    case 's':
+        strcat(fmt, "s");
+        snprintf(buf, sizeof(buf), fmt, arg.type == LOG_ARG_STR ? rec.str + arg.str : "<?>");
+        break;
+    case 'p':
+        strcat(fmt, "p");
+        snprintf(buf, sizeof(buf), fmt, arg.p);
+        break;
+    default:
+        snprintf(buf, sizeof(buf), "<?>");
+        break;
+    }
+    line += buf;
+}
+
+void sc_logger::write_text(const log_record_t &rec) {
+    std::string line;
+    char buf[64];
+    snprintf(buf, sizeof(buf), "%.15g ns - ", (double)rec.time * _res_ns);
+    line += buf;
+    if (rec.module[0]) {
+        line += "[";
+        line += rec.module;
+        line += "] ";
+    }
+    if (rec.level == LOG_LVL_ERROR) line += "ERROR>>> ";
+    else if (rec.level == LOG_LVL_WARN) line += "WARNING>>> ";
+
+    if (!rec.fmt) {
+        line += rec.str;
+    }
+    else {
+        // conversions are `%[flags][width][.precision][length]<conv>`
+        uint32_t n_arg = 0;
+        for (const char *c = rec.fmt; *c; c++) {
+            if (*c != '%') {
+                line += *c;
+                continue;
+            }
+            if (c[1] == '%') {
+                line += '%';
+                c++;
+                continue;
+            }
+
+            const char *spec = c++;
+            while (*c && strchr("-+ #0123456789.", *c) && c - spec < 16) c++;
+            uint32_t spec_len = (uint32_t)(c - spec);
+            while (*c && strchr("hlLqjzt", *c)) c++;
+            if (!*c) break;
+
+            if (n_arg < rec.n_args) format_arg(line, rec, spec, spec_len, *c, rec.args[n_arg++]);
+            else line += "<?>";
+        }
+    }
+
+    line += '\n';
+    fwrite(line.data(), 1, line.size(), _out);
+}
+
+void sc_logger::write_binary(const log_record_t &rec) {
+    // intern the format string, literals keep their address
+    uint32_t fmt_id = LOG_BIN_NO_FMT;
+    if (rec.fmt) {
+        std::unordered_map<const char*, uint32_t>::const_iterator it = log_bin_fmts.find(rec.fmt);
+        if (it == log_bin_fmts.end()) {
+            fmt_id = (uint32_t)log_bin_fmts.size();
+            log_bin_fmts[rec.fmt] = fmt_id;
+            uint16_t len = (uint16_t)strlen(rec.fmt);
+            fputc('F', _out);
+            fwrite(&fmt_id, sizeof(fmt_id), 1, _out);
+            fwrite(&len, sizeof(len), 1, _out);
+            fwrite(rec.fmt, 1, len, _out);
+        }
+        else {
+            fmt_id = it->second;
+        }
+    }
+
+    // intern the module
+    uint32_t module_id;
+    std::unordered_map<std::string, uint32_t>::const_iterator it = log_bin_modules.find(rec.module);
+    if (it == log_bin_modules.end()) {
+        module_id = (uint32_t)log_bin_modules.size();
+        log_bin_modules[rec.module] = module_id;
+        uint16_t len = (uint16_t)strlen(rec.module);
+        fputc('M', _out);
+        fwrite(&module_id, sizeof(module_id), 1, _out);
+        fwrite(&len, sizeof(len), 1, _out);
+        fwrite(rec.module, 1, len, _out);
+    }
+    else {
+        module_id = it->second;
+    }
+
+    // record
+    fputc('R', _out);
+    fwrite(&rec.time, sizeof(rec.time), 1, _out);
+    fwrite(&rec.level, sizeof(rec.level), 1, _out);
+    fwrite(&module_id, sizeof(module_id), 1, _out);
+    fwrite(&fmt_id, sizeof(fmt_id), 1, _out);
+    if (!rec.fmt) {
+        uint16_t len = (uint16_t)rec.str_len;
+        fwrite(&len, sizeof(len), 1, _out);
+        fwrite(rec.str, 1, len, _out);
+        return;
+    }
+    fwrite(&rec.n_args, sizeof(rec.n_args), 1, _out);
+    for (uint32_t i = 0; i < rec.n_args; i++) {
+        const log_arg_t &arg = rec.args[i];
+        fwrite(&arg.type, sizeof(arg.type), 1, _out);
+        if (arg.type == LOG_ARG_STR) {
+            uint16_t len = (uint16_t)strlen(rec.str + arg.str);
+            fwrite(&len, sizeof(len), 1, _out);
+            fwrite(rec.str + arg.str, 1, len, _out);
+        }
+        else {
+            fwrite(&arg.u, sizeof(arg.u), 1, _out);
+        }
+    }
+}
@@ -0,0 +1,144 @@
+#include "sc_wave.h"
+
+#include <iostream>
+#include <string.h>
+#include <zlib.h>
+
+sc_wave_writer::sc_wave_writer()
+    : _fp(nullptr), _signals_written(false), _block_start(0), _time(0),
+      _n_changes(0), _n_blocks(0), _raw_bytes(0), _file_bytes(0)
+{
+}
+
+sc_wave_writer::~sc_wave_writer() {
+    close();
+}
+
+bool sc_wave_writer::open(const char *file, double res_ns) {
+    _fp = fopen(file, "wb");
+    if (!_fp) {
+        return false;
+    }
+    fwrite(WAVE_MAGIC, 1, sizeof(WAVE_MAGIC) - 1, _fp);
+    fwrite(&res_ns, sizeof(res_ns), 1, _fp);
+    _file_bytes = sizeof(WAVE_MAGIC) - 1 + sizeof(res_ns);
+    _block.reserve(WAVE_BLOCK_SIZE + 32);
+    return true;
+}
+
+uint32_t sc_wave_writer::add_signal(const std::string &name, uint32_t width, wave_kind_e kind) {
+    if (_signals_written) {
+        std::cerr << "*** ERROR in sc_wave_writer: signal " << name << " added after the first block" << std::endl;
+    }
+    wave_signal_t sig;
+    sig.name = name;
+    sig.width = width;
+    sig.kind = kind;
+    sig.last = 0;
+    sig.known = false;
+    _signals.push_back(sig);
+    return (uint32_t)(_signals.size() - 1);
+}
+
+void sc_wave_writer::change(uint64_t time, uint32_t id, uint64_t value) {
+    if (!_fp) return;
+    wave_signal_t &sig = _signals[id];
+    if (sig.known && sig.last == value) return;
+    sig.last = value;
+    sig.known = true;
+
+    // advance the time
+    if (_block.empty()) {
+        _block_start = time;
+        _time = time;
+    }
+    else if (time > _time) {
+        put_varint(((time - _time) << 1) | 1);
+        _time = time;
+    }
+
+    put_varint((uint64_t)id << 1);
+    put_varint(value);
+    _n_changes++;
+
+    if (_block.size() >= WAVE_BLOCK_SIZE) {
+        flush_block();
+    }
+}
+
+void sc_wave_writer::reset_values() {
+    for (wave_signal_t &sig : _signals) {
+        sig.known = false;
+    }
+}
+
+void sc_wave_writer::close() {
+    if (!_fp) return;
+    flush_block();
+    if (!_signals_written) {
+        write_signals();
+    }
+    fclose(_fp);
+    _fp = nullptr;
+}
+
+void sc_wave_writer::print_report(std::ostream &out) {
+    out << "Waveform: " << _signals.size() << " signals, " << _n_changes << " changes in " << _n_blocks << " blocks, "
+        << _raw_bytes << " bytes encoded, " << _file_bytes << " bytes written" << std::endl;
+}
+
+void sc_wave_writer::put_varint(uint64_t v) {
+    while (v >= 0x80) {
+        _block.push_back((uint8_t)(v | 0x80));
+        v >>= 7;
+    }
+    _block.push_back((uint8_t)v);
+}
+
+void sc_wave_writer::write_section(char tag, const std::vector<uint8_t> &data, bool is_block) {
+    uLongf comp_len = compressBound((uLong)data.size());
+    std::vector<uint8_t> comp(comp_len);
+    int status = compress2(comp.data(), &comp_len, data.data(), (uLong)data.size(), Z_BEST_SPEED);
+    if (status != Z_OK) {
+        std::cerr << "*** ERROR in sc_wave_writer: could not compress a section of " << data.size() << " bytes, zlib error " << status << ", section dropped" << std::endl;
+        return;
+    }
+
+    uint32_t raw_size = (uint32_t)data.size();
+    uint32_t comp_size = (uint32_t)comp_len;
+    fputc(tag, _fp);
+    if (is_block) {
+        fwrite(&_block_start, sizeof(_block_start), 1, _fp);
+        fwrite(&_time, sizeof(_time), 1, _fp);
+        _file_bytes += sizeof(_block_start) + sizeof(_time);
+    }
+    fwrite(&raw_size, sizeof(raw_size), 1, _fp);
+    fwrite(&comp_size, sizeof(comp_size), 1, _fp);
+    fwrite(comp.data(), 1, comp_size, _fp);
+    _file_bytes += 1 + sizeof(raw_size) + sizeof(comp_size) + comp_size;
+}
+
+void sc_wave_writer::write_signals() {
+    std::vector<uint8_t> data;
+    for (const wave_signal_t &sig : _signals) {
+        uint16_t len = (uint16_t)sig.name.size();
+        uint8_t kind = (uint8_t)sig.kind;
+        data.insert(data.end(), (const uint8_t*)&sig.width, (const uint8_t*)&sig.width + sizeof(sig.width));
+        data.push_back(kind);
+        data.insert(data.end(), (const uint8_t*)&len, (const uint8_t*)&len + sizeof(len));
+        data.insert(data.end(), sig.name.begin(), sig.name.end());
+    }
+    write_section(WAVE_SECTION_SIGNALS, data, false);
+    _signals_written = true;
+}
+
+void sc_wave_writer::flush_block() {
+    if (_block.empty()) return;
+    if (!_signals_written) {
+        write_signals();
+    }
+    write_section(WAVE_SECTION_BLOCK, _block, true);
+    _raw_bytes += _block.size();
+    _n_blocks++;
+    _block.clear();
+}
@@ -0,0 +1,107 @@
+#include "stimulus.h"
+
+#include <string.h>
+#include <vector>
+
+// increment between consecutive counters (golden ratio), spreads the counters over the mixer input
+#define STIM_GOLDEN 0x9e3779b97f4a7c15ull
+
+// natural images are interpolated between random values on a grid of 2^bits pixels
+#define STIM_CELL_BITS 5
+#define STIM_CELL (1 << STIM_CELL_BITS)
+
+// the grid values use their own stream
+#define STIM_GRID_STREAM 0x8000000000000000ull
+
+/**
+ * SplitMix64 finalizer, a bijection whose outputs pass statistical tests even
+ * for consecutive inputs.
+ */
+static inline uint64_t stim_mix(uint64_t z) {
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ull;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebull;
+    return z ^ (z >> 31);
+}
+
+/** Key of a stream, the counters of a stream are added to it. */
+static inline uint64_t stim_key(uint64_t seed, uint64_t stream) {
+    return stim_mix(seed ^ (stream * STIM_GOLDEN));
+}
+
+bool stim_parse_dist(const std::string &name, stim_dist_e *dist) {
+    if (name == "uniform") *dist = STIM_UNIFORM;
+    else if (name == "natural") *dist = STIM_NATURAL;
+    else if (name == "saturate") *dist = STIM_SATURATE;
+    else return false;
+    return true;
+}
+
+const char *stim_dist_name(stim_dist_e dist) {
+    switch (dist) {
+    case STIM_NATURAL:  return "natural";
+    case STIM_SATURATE: return "saturate";
+    default:            return "uniform";
+    }
+}
+
+/** Generate `n` words from `counter`, each word only depends on the key of the stream and its counter. */
+static void stim_words(uint64_t *dst, uint64_t key, uint64_t counter, uint64_t n) {
+    for (uint64_t i = 0; i < n; i++) {
+        dst[i] = stim_mix(key + (counter + i) * STIM_GOLDEN);
+    }
+}
+
+/** Grid value of a natural image. */
+static inline int32_t stim_grid(uint64_t key, uint64_t grid_cols, uint64_t r, uint64_t c) {
+    return (int32_t)(stim_mix(key + (r * grid_cols + c) * STIM_GOLDEN) & 0xff);
+}
+
+void stim_fill(uint8_t *dst, uint32_t rows, uint32_t cols, uint64_t stride, uint64_t seed, uint64_t stream, stim_dist_e dist) {
+    uint64_t key = stim_key(seed, stream);
+    uint64_t grid_key = stim_key(seed, stream | STIM_GRID_STREAM);
+    uint64_t n_words = ((uint64_t)cols + 7) >> 3;
+    uint64_t grid_cols = ((uint64_t)cols >> STIM_CELL_BITS) + 2;
+
+    std::vector<uint64_t> words(n_words);
+    std::vector<int32_t> grid_row(grid_cols);
+    uint8_t *bytes = (uint8_t*)words.data();
+
+    for (uint32_t r = 0; r < rows; r++) {
+        uint8_t *row = dst + r * stride;
+        stim_words(words.data(), key, (uint64_t)r * n_words, n_words);
+
+        switch (dist) {
+        case STIM_UNIFORM:
+        {
+            memcpy(row, bytes, cols);
+            break;
+        }
+        case STIM_SATURATE:
+        {
+            // one zero byte in eight, the others full scale
+            for (uint32_t c = 0; c < cols; c++) {
+                row[c] = bytes[c] < 32 ? 0x00 : 0xff;
+            }
+            break;
+        }
+        case STIM_NATURAL:
+        {
+            // interpolate the grid rows around this row, scaled by STIM_CELL
+            uint64_t gr = r >> STIM_CELL_BITS;
+            int32_t fy = r & (STIM_CELL - 1);
+            for (uint64_t gc = 0; gc < grid_cols; gc++) {
+                grid_row[gc] = stim_grid(grid_key, grid_cols, gr, gc) * (STIM_CELL - fy) + stim_grid(grid_key, grid_cols, gr + 1, gc) * fy;
+            }
+
+            // interpolate along the row, then add noise in [-8, 7]
+            for (uint32_t c = 0; c < cols; c++) {
+                uint32_t gc = c >> STIM_CELL_BITS;
+                int32_t fx = c & (STIM_CELL - 1);
+                int32_t v = ((grid_row[gc] * (STIM_CELL - fx) + grid_row[gc + 1] * fx) >> (2 * STIM_CELL_BITS)) + (int32_t)(bytes[c] & 0xf) - 8;
+                row[c] = (uint8_t)(v < 0 ? 0 : (v > 0xff ? 0xff : v));
+            }
+            break;
+        }
+        };
+    }
+}
@@ -1,26 +1,45 @@
-
 #include "system.h"
 #include "sc_trace.hpp"
+#include "stimulus.h"
+#include "perf_counters.h"
 
 #include <iostream>
+#include <fstream>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
-#include <time.h>
 #include <string>
+#include <map>
+#include <random>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+// frame geometry and memory map, defaults are set by configureSystem
+sys_config_t sys_cfg = {DEFAULT_MAT_ROWS, DEFAULT_MAT_COLS, DEFAULT_MAT_COLS, 1, 1, 1, 1, 0, 0, 0, 0, 0, 0};
+
+// generated stimulus, frame `i` is the stream `i` and the kernels have their own stream
+#define STIM_KERN_STREAM 0x4b45524eull
+static uint64_t stim_seed = 0;
+static stim_dist_e stim_dist = STIM_UNIFORM;
+
+// set when a numeric option is not a number or out of range
+static bool option_error = false;
 
-void memoryRead(char *memfile, unsigned char *mem, unsigned int memout_size) {
+void memoryRead(const char *memfile, unsigned char *mem, unsigned int memout_size, long offset = 0) {
     FILE *fp = fopen(memfile, "rb");
 
     unsigned int cursor = 0;
     if (fp) {
         // get file size
         fseek(fp, 0L, SEEK_END);
-        int fsize = ftell(fp) - cursor;
-        fseek(fp, cursor, SEEK_SET);
+        long fsize = ftell(fp) - offset;
+        fseek(fp, offset, SEEK_SET);
 
-        int n = fsize > memout_size ? memout_size : fsize;
+        long n = fsize < 0 ? 0 : (fsize > memout_size ? memout_size : fsize);
         cursor = fread(mem, 1, n, fp);
+        fclose(fp);
     }
 
     // pad with zeros
@@ -29,16 +48,347 @@ void memoryRead(char *memfile, unsigned char *mem, unsigned int memout_size) {
     }
 }
 
-bool parseCmdLine(int argc, char **argv, unsigned char *mem, int *kernelsize) {
+/** Clear the columns between FRAME_COLS and MAT_COLS, which act as zero padding. */
+void clearRowPadding(unsigned char *mem) {
+    if (FRAME_COLS == MAT_COLS) return;
+    for (uint32_t r = 0; r < MAT_ROWS; r++) {
+        memset(mem + r * MAT_COLS + FRAME_COLS, 0, MAT_COLS - FRAME_COLS);
+    }
+}
+
+/** Read frame `i` of a file of FRAME_COLS-wide rows into MAT_COLS-wide rows. */
+void frameRead(const char *memfile, unsigned char *mem, uint32_t i = 0) {
+    long offset = (long)i * MAT_ROWS * FRAME_COLS;
+    if (FRAME_COLS == MAT_COLS) {
+        memoryRead(memfile, mem, MAT_SIZE, offset);
+        return;
+    }
+
+    // read packed rows at the end of the region, then spread them from the top
+    unsigned char *packed = mem + MAT_SIZE - (uint64_t)MAT_ROWS * FRAME_COLS;
+    memoryRead(memfile, packed, MAT_ROWS * FRAME_COLS, offset);
+    for (uint32_t r = 0; r < MAT_ROWS; r++) {
+        memmove(mem + r * MAT_COLS, packed + r * FRAME_COLS, FRAME_COLS);
+    }
+    clearRowPadding(mem);
+}
+
+/**
+ * Load frame `i` of the sequence in its subject buffer. The frames are read
+ * from the `frames_file` option, wrapping around at the end of the file, or
+ * generated.
+ */
+bool frameLoad(unsigned char *mem, uint32_t i) {
+    unsigned char *subj = mem + FRAME_MAT_ADDR(i);
+    std::string file = getOption("frames_file");
+
+    if (!file.empty()) {
+        // number of frames in the file
+        FILE *fp = fopen(file.c_str(), "rb");
+        if (!fp) {
+            std::cerr << "*** ERROR in main: cannot open frames file " << file << std::endl;
+            return false;
+        }
+        fseek(fp, 0L, SEEK_END);
+        long n_frames = ftell(fp) / ((long)MAT_ROWS * FRAME_COLS);
+        fclose(fp);
+
+        frameRead(file.c_str(), subj, n_frames ? i % n_frames : 0);
+    }
+    else {
+        stim_fill(subj, MAT_ROWS, FRAME_COLS, MAT_COLS, stim_seed, i, stim_dist);
+        clearRowPadding(subj);
+    }
+
+    // pad input matrix with zeros
+    memset(subj + MAT_SIZE, 0, MAT_SIZE_PADDED - MAT_SIZE);
+
+    CUR_FRAME = i;
+    return true;
+}
+
+/** Write the first FRAME_COLS bytes of each MAT_COLS-wide row. */
+void frameWrite(FILE *fp, unsigned char *mem) {
+    if (FRAME_COLS == MAT_COLS) {
+        fwrite(mem, 1, MAT_SIZE, fp);
+        return;
+    }
+
+    for (uint32_t r = 0; r < MAT_ROWS; r++) {
+        fwrite(mem + r * MAT_COLS, 1, FRAME_COLS, fp);
+    }
+}
+
+// options parsed from the command line
+static std::map<std::string, std::string> options;
+
+// whether the input, kernel and output files are mapped onto their regions
+static bool mem_mapped = false;
+
+/**
+ * Map `size` bytes of `file` onto the memory from `addr`, shared so the
+ * accesses go straight to the file. The file is created or resized to `size`
+ * bytes, as `memoryWrite` would leave it.
+ */
+bool mapRegion(unsigned char *mem, uint64_t addr, const char *file, uint64_t size) {
+    int fd = open(file, O_RDWR | O_CREAT, 0644);
+    if (fd < 0) {
+        std::cerr << "*** ERROR in main: cannot open " << file << " to map it" << std::endl;
+        return false;
+    }
+
+    bool success = ftruncate(fd, (off_t)size) == 0 &&
+        mmap(mem + addr, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_FIXED, fd, 0) != MAP_FAILED;
+    close(fd);
+
+    if (!success) {
+        std::cerr << "*** ERROR in main: cannot map " << file << std::endl;
+    }
+    return success;
+}
+
+/**
+ * Back the memory with the files instead of reading and writing them: the
+ * memory is reserved as zero pages, then the input, kernel and output files
+ * are mapped onto their regions. The OS pages them in on the first access
+ * and writes the output back.
+ */
+bool memoryMap(char **argv, unsigned char **mem) {
+    void *base = mmap(nullptr, MEM_SIZE, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+    if (base == MAP_FAILED) {
+        std::cerr << "*** ERROR in main: cannot reserve " << MEM_SIZE << " bytes of memory" << std::endl;
+        return false;
+    }
+    *mem = (unsigned char*)base;
+
+    mem_mapped = mapRegion(*mem, MAT_ADDR, argv[1], MAT_SIZE) &&
+                 mapRegion(*mem, KERN_ADDR, argv[3], N_KERN * MAX_KERN_SIZE) &&
+                 mapRegion(*mem, OUT_ADDR, argv[2], OUT_REGION_SIZE);
+    return mem_mapped;
+}
+
+bool hasOption(const char *name) {
+    return options.find(name) != options.end();
+}
+
+std::string getOption(const char *name, const std::string &def) {
+    std::map<std::string, std::string>::const_iterator it = options.find(name);
+    return it != options.end() ? it->second : def;
+}
+
+/**
+ * Parse a whole option value with `parse`, report it and return `def` if it is
+ * not a number or out of range.
+ */
+template <typename T, typename F>
+static T parseOption(const char *name, const std::string &value, T def, F parse) {
+    try {
+        size_t end;
+        T n = parse(value, &end);
+        if (end == value.size()) return n;
+    }
+    catch (const std::logic_error &) {
+    }
+
+    std::cerr << "*** ERROR in main: invalid value " << value << " of --" << name << std::endl;
+    option_error = true;
+    return def;
+}
+
+int getOptionInt(const char *name, int def) {
+    std::map<std::string, std::string>::const_iterator it = options.find(name);
+    if (it == options.end()) return def;
+    return parseOption(name, it->second, def, [](const std::string &v, size_t *end) { return std::stoi(v, end); });
+}
+
+uint64_t getOptionAddr(const char *name, uint64_t def) {
+    std::map<std::string, std::string>::const_iterator it = options.find(name);
+    if (it == options.end()) return def;
+    return parseOption(name, it->second, def, [](const std::string &v, size_t *end) {
+        // stoull takes a leading minus, an address never has one
+        if (v.find('-') != std::string::npos) throw std::invalid_argument(v);
+        return (uint64_t)std::stoull(v, end, 0);
+    });
+}
+
+bool optionsValid() {
+    return !option_error;
+}
+
+/**
+ * Load options from a configuration file, one `<NAME>=<VALUE>` per line. Lines
+ * starting with `#` are comments. Options given on the command line take
+ * precedence.
+ */
+bool loadConfigFile(const std::string &file) {
+    std::ifstream in(file);
+    if (!in) {
+        std::cerr << "*** ERROR in main: cannot open configuration file " << file << std::endl;
+        return false;
+    }
+
+    std::string line;
+    while (std::getline(in, line)) {
+        size_t start = line.find_first_not_of(" \t\r");
+        if (start == std::string::npos || line[start] == '#') continue;
+
+        size_t eq = line.find('=', start);
+        if (eq == std::string::npos) continue;
+        size_t name_end = line.find_last_not_of(" \t", eq - 1);
+        size_t value_start = line.find_first_not_of(" \t", eq + 1);
+        size_t value_end = line.find_last_not_of(" \t\r");
+        std::string value = value_start == std::string::npos || value_start > value_end ? "" : line.substr(value_start, value_end - value_start + 1);
+
+        options.insert(std::make_pair(line.substr(start, name_end - start + 1), value));
+    }
+
+    return true;
+}
+
+/**
+ * Set the seed and distribution of the generated stimulus from the options. A
+ * seed is drawn when none is given, and printed so the run can be replayed.
+ */
+bool configureStimulus() {
+    if (!stim_parse_dist(getOption("stimulus", "uniform"), &stim_dist)) {
+        std::cerr << "*** ERROR in main: unknown stimulus " << getOption("stimulus") << ", expected uniform, natural or saturate" << std::endl;
+        return false;
+    }
+
+    if (hasOption("seed")) {
+        stim_seed = getOptionAddr("seed", 0);
+    }
+    else {
+        std::random_device rd;
+        stim_seed = ((uint64_t)rd() << 32) | rd();
+    }
+
+    return true;
+}
+
+/**
+ * Set the frame geometry and memory map from the options. The default memory
+ * map packs the padded subject, kernel, output and acknowledge regions.
+ */
+bool configureSystem() {
+    int64_t rows = getOptionInt("rows", DEFAULT_MAT_ROWS);
+    int64_t cols = getOptionInt("cols", DEFAULT_MAT_COLS);
+    // the padded rows below the frame are counted in the 16-bit row field of the commands
+    if (rows < 1 || rows + (MAX_KERN_DIM >> 1) > MAX_MAT_ROWS || cols < 1 || cols > MAX_MAT_COLS) {
+        std::cerr << "*** ERROR in main: invalid frame size " << rows << "x" << cols << ", max is " << (MAX_MAT_ROWS - (MAX_KERN_DIM >> 1)) << "x" << MAX_MAT_COLS << std::endl;
+        return false;
+    }
+
+    int64_t n_kern = getOptionInt("kernels", 1);
+    if (n_kern < 1 || n_kern > MAX_KERN_BANK) {
+        std::cerr << "*** ERROR in main: invalid number of kernels " << n_kern << ", max is " << MAX_KERN_BANK << std::endl;
+        return false;
+    }
+
+    int64_t n_frames = getOptionInt("frames", 1);
+    if (n_frames < 1) {
+        std::cerr << "*** ERROR in main: invalid number of frames " << n_frames << std::endl;
+        return false;
+    }
+
+    // two frames in flight (besides the kernel) to overlap them
+    int64_t queue_depth = getOptionInt("queue_depth", n_frames > 1 ? 3 : 1);
+    if (queue_depth < 1 || queue_depth > MAX_QUEUE_DEPTH) {
+        std::cerr << "*** ERROR in main: invalid queue depth " << queue_depth << ", max is " << MAX_QUEUE_DEPTH << std::endl;
+        return false;
+    }
+
+    sys_cfg.mat_rows = (uint32_t)rows;
+    sys_cfg.frame_cols = (uint32_t)cols;
+    sys_cfg.mat_cols = (uint32_t)((cols + MAT_COLS_ALIGN - 1) / MAT_COLS_ALIGN) * MAT_COLS_ALIGN;
+    sys_cfg.n_kern = (uint32_t)n_kern;
+    sys_cfg.queue_depth = (uint32_t)queue_depth;
+    sys_cfg.n_frames = (uint32_t)n_frames;
+    sys_cfg.n_frame_bufs = n_frames > 1 ? MAX_FRAME_BUFS : 1;
+    sys_cfg.cur_frame = 0;
+
+    // mapped files start on a page
+    bool do_mmap = hasOption("mmap");
+    uint64_t align = do_mmap ? (uint64_t)sysconf(_SC_PAGESIZE) : 8;
+#define ALIGN_UP(addr) ((((addr) + align - 1) / align) * align)
+    sys_cfg.mat_addr = getOptionAddr("mat_addr", 0);
+    sys_cfg.kern_addr = getOptionAddr("kern_addr", ALIGN_UP(MAT_ADDR + N_FRAME_BUFS * MAT_SIZE_PADDED));
+    sys_cfg.out_addr = getOptionAddr("out_addr", ALIGN_UP(KERN_ADDR + KERN_REGION_SIZE));
+    sys_cfg.unused_addr = getOptionAddr("ack_addr", ALIGN_UP(OUT_ADDR + N_FRAME_BUFS * OUT_REGION_SIZE));
+    sys_cfg.mem_size = getOptionAddr("mem_size", UNUSED_ADDR + ACK_REGION_SIZE);
+#undef ALIGN_UP
+
+    // validate the memory map
+    if ((MAT_ADDR | KERN_ADDR | OUT_ADDR | UNUSED_ADDR) & 0x7) {
+        std::cerr << "*** ERROR in main: memory regions must be aligned to 8 bytes" << std::endl;
+        return false;
+    }
+    if (do_mmap && (MAT_ADDR | KERN_ADDR | OUT_ADDR) % align) {
+        std::cerr << "*** ERROR in main: mapped memory regions must be aligned to " << align << " bytes" << std::endl;
+        return false;
+    }
+    if (do_mmap && (N_FRAMES > 1 || FRAME_COLS != MAT_COLS || hasOption("frames_file"))) {
+        std::cerr << "*** ERROR in main: --mmap needs a single frame with a multiple of " << MAT_COLS_ALIGN << " columns" << std::endl;
+        return false;
+    }
+
+    // every frame buffer fits in the memory, and the regions do not overlap
+    struct { const char *name; uint64_t addr; uint64_t size; } regions[] = {
+        { "subject", MAT_ADDR, N_FRAME_BUFS * MAT_SIZE_PADDED },
+        { "kernel", KERN_ADDR, KERN_REGION_SIZE },
+        { "output", OUT_ADDR, N_FRAME_BUFS * OUT_REGION_SIZE },
+        { "acknowledge", UNUSED_ADDR, ACK_REGION_SIZE },
+    };
+    for (uint32_t i = 0; i < sizeof(regions) / sizeof(regions[0]); i++) {
+        if (regions[i].addr > MEM_SIZE || regions[i].size > MEM_SIZE - regions[i].addr) {
+            std::cerr << "*** ERROR in main: " << regions[i].name << " region does not fit in " << MEM_SIZE << " bytes" << std::endl;
+            return false;
+        }
+        for (uint32_t j = 0; j < i; j++) {
+            if (regions[i].addr < regions[j].addr + regions[j].size && regions[j].addr < regions[i].addr + regions[i].size) {
+                std::cerr << "*** ERROR in main: " << regions[i].name << " region overlaps the " << regions[j].name << " region" << std::endl;
+                return false;
+            }
+        }
+    }
+
+    return true;
+}
+
+bool parseCmdLine(int argc, char **argv, unsigned char **mem, int *kernelsize) {
+    // extract options, positional arguments are compacted to the front of argv
+    int n_pos = 1;
+    for (int i = 1; i < argc; i++) {
+        std::string arg(argv[i]);
+        if (arg.rfind("--", 0) == 0) {
+            size_t eq = arg.find('=');
+            if (eq == std::string::npos) {
+                options[arg.substr(2)] = "1";
+            }
+            else {
+                options[arg.substr(2, eq - 2)] = arg.substr(eq + 1);
+            }
+        }
+        else {
+            argv[n_pos++] = argv[i];
+        }
+    }
+    argc = n_pos;
+
     // check usage
     if (argc < 5 || argc > 7) {
-    std::cerr << "Usage: " << argv[0] << " <INPUT_FILE> <OUTPUT_FILE> <KERNEL_FILE> <KERNEL_SIZE> [<DO_RANDOMIZE> [<TRACE_FILE>]]" << std::endl;
+    std::cerr << "Usage: " << argv[0] << " <INPUT_FILE> <OUTPUT_FILE> <KERNEL_FILE> <KERNEL_SIZE> [<DO_RANDOMIZE> [<TRACE_FILE>]] [--<OPTION>=<VALUE> ...]" << std::endl;
         return false;
     }
 
     // validate kernel size
-    *kernelsize = std::stoi(argv[4]);
-    if (*kernelsize > MAX_KERN_ROWS) {
+    try {
+        *kernelsize = std::stoi(argv[4]);
+    }
+    catch (const std::logic_error &) {
+        *kernelsize = 0;
+    }
+    if (*kernelsize < 1 || *kernelsize > MAX_KERN_ROWS) {
         std::cerr << "*** ERROR in main: invalid KERNEL_SIZE, max is " << MAX_KERN_ROWS << std::endl;
         return false;
     }
@@ -47,49 +397,131 @@ bool parseCmdLine(int argc, char **argv, unsigned char *mem, int *kernelsize) {
         return false;
     }
 
-    // determine randomization
-    if (argc >= 6 && argv[5][0] == '1') {
-        printf("Randomizing\n");
-        srand(time(0));
-        for (int i = 0; i < MEM_SIZE; i++) {
-            mem[i] = rand() & 0xff;
+    // configuration file
+    if (hasOption("config") && !loadConfigFile(getOption("config"))) {
+        return false;
+    }
+
+    // log filters and output
+    if (!sc_logger::configure(getOption("log"), getOption("log_file"), getOptionInt("log_binary", 0) != 0)) {
+        return false;
+    }
+
+    // frame geometry and memory map
+    if (!configureSystem() || !optionsValid()) {
+        return false;
+    }
+    if (hasOption("mmap")) {
+        if (!memoryMap(argv, mem)) {
+            return false;
         }
     }
     else {
+        *mem = new unsigned char[MEM_SIZE]();
+    }
+
+    if (!configureStimulus()) {
+        return false;
+    }
+
+    // determine randomization, only the subject and kernels are generated
+    bool do_random = argc >= 6 && argv[5][0] == '1';
+    if (do_random || (N_FRAMES > 1 && !hasOption("frames_file"))) {
+        printf("Generating %s stimulus, replay with --seed=0x%016llx\n", stim_dist_name(stim_dist), (unsigned long long)stim_seed);
+    }
+    if (do_random) {
+        stim_fill(*mem + MAT_ADDR, MAT_ROWS, FRAME_COLS, MAT_COLS, stim_seed, 0, stim_dist);
+        clearRowPadding(*mem + MAT_ADDR);
+
+        // natural images are meaningless as kernels
+        stim_fill(*mem + KERN_ADDR, 1, N_KERN * MAX_KERN_SIZE, 0, stim_seed, STIM_KERN_STREAM, stim_dist == STIM_NATURAL ? STIM_UNIFORM : stim_dist);
+    }
+    else if (hasOption("frames_file")) {
+        // first frame of the sequence
+        if (!frameLoad(*mem, 0)) {
+            return false;
+        }
+        memoryRead(argv[3], *mem + KERN_ADDR, N_KERN * MAX_KERN_SIZE); // load kernels
+    }
+    else if (!mem_mapped) {
         // read memory
-        memoryRead(argv[1], mem, MAT_SIZE); // load image
-        memoryRead(argv[3], mem + KERN_ADDR, MAX_KERN_SIZE); // load kernel
+        frameRead(argv[1], *mem + MAT_ADDR); // load image
+        memoryRead(argv[3], *mem + KERN_ADDR, N_KERN * MAX_KERN_SIZE); // load kernels
     }
 
     // pad input matrix with zeros
-    memset(mem + MAT_ADDR + MAT_SIZE, 0, MAT_SIZE_PADDED - MAT_SIZE);
+    memset(*mem + MAT_ADDR + MAT_SIZE, 0, MAT_SIZE_PADDED - MAT_SIZE);
+
+    // latency histograms, reported at the end of the run
+    if (hasOption("latency")) {
+        latency_tracker::enable();
+    }
+
+    // performance counters, written at the end of the run
+    if (!perf_counters::configure(getOption("perf"), getOptionAddr("perf_period", 0))) {
+        return false;
+    }
+    perf_counters::set_config("rows", MAT_ROWS);
+    perf_counters::set_config("cols", FRAME_COLS);
+    perf_counters::set_config("kernel_dim", *kernelsize);
+    perf_counters::set_config("kernels", N_KERN);
+    perf_counters::set_config("frames", N_FRAMES);
 
     // enable or disable logging
     if (argc >= 7) {
         sc_tracer::enable();
-        sc_tracer::init(argv[6], SC_NS);
+        sc_tracer::filter(getOption("trace_filter"));
+
+        std::string format = getOption("trace_format", "vcd");
+        bool windowed = hasOption("trace_on") || hasOption("trace_start") || hasOption("trace_length");
+        if (format == "wave") {
+            if (!sc_tracer::init_wave(argv[6], getOption("trace_on", TRACE_TRIGGER_TIME), getOptionAddr("trace_start", 0), getOptionAddr("trace_length", 0))) {
+                return false;
+            }
+        }
+        else if (format != "vcd") {
+            std::cerr << "*** ERROR in main: unknown trace format " << format << ", expected vcd or wave" << std::endl;
+            return false;
+        }
+        else if (windowed) {
+            std::cerr << "*** ERROR in main: capture windows need --trace_format=wave" << std::endl;
+            return false;
+        }
+        else {
+            sc_tracer::init(argv[6], SC_NS);
+        }
     }
     else {
         sc_tracer::disable();
     }
 
-    return true;
+    // the seed, period and window options are read above
+    return optionsValid();
 }
 
 bool memoryWrite(char **argv, unsigned char *mem) {
+    // the files are the memory, flush them
+    if (mem_mapped) {
+        return msync(mem + MAT_ADDR, MAT_SIZE, MS_SYNC) == 0 &&
+               msync(mem + KERN_ADDR, N_KERN * MAX_KERN_SIZE, MS_SYNC) == 0 &&
+               msync(mem + OUT_ADDR, OUT_REGION_SIZE, MS_SYNC) == 0;
+    }
+
     // write input file
     char *file = argv[1];
     FILE *fp = fopen(file, "wb");
     if (fp) {
-        fwrite(mem + MAT_ADDR, 1, MAT_SIZE, fp);
+        frameWrite(fp, mem + FRAME_MAT_ADDR(CUR_FRAME));
         fclose(fp);
     }
 
-    // write output file
+    // write output file, one matrix per kernel
     file = argv[2];
     fp = fopen(file, "wb");
     if (fp) {
-        fwrite(mem + OUT_ADDR, 1, MAT_SIZE, fp);
+        for (uint32_t i = 0; i < N_KERN; i++) {
+            frameWrite(fp, mem + FRAME_OUT_ADDR(CUR_FRAME) + i * MAT_SIZE);
+        }
         fclose(fp);
     }
 
@@ -97,7 +529,7 @@ bool memoryWrite(char **argv, unsigned char *mem) {
     file = argv[3];
     fp = fopen(file, "wb");
     if (fp) {
-        fwrite(mem + KERN_ADDR, 1, MAX_KERN_SIZE, fp);
+        fwrite(mem + KERN_ADDR, 1, N_KERN * MAX_KERN_SIZE, fp);
         fclose(fp);
     }
 
@@ -125,12 +557,16 @@ void printMat(unsigned char *mem, int mat_n_cols, int base_addr, int r, int c, i
 void memoryPrint(unsigned char *mem, int kernel_size) {
     std::cout << std::endl << "==========" << std::endl;
     std::cout << "Input matrix:" << std::endl;
-    printMat(mem, MAT_COLS, MAT_ADDR, 0, 0, MIN(MAT_ROWS, 10), MIN(MAT_COLS, 20));
+    printMat(mem, MAT_COLS, FRAME_MAT_ADDR(CUR_FRAME), 0, 0, MIN(MAT_ROWS, 10), MIN(FRAME_COLS, 20));
 
-    std::cout << "Kernel:" << std::endl;
-    printMat(mem, kernel_size, KERN_ADDR, 0, 0, kernel_size, kernel_size);
+    for (uint32_t i = 0; i < N_KERN; i++) {
+        std::cout << "Kernel " << i << ":" << std::endl;
+        printMat(mem, kernel_size, KERN_ADDR + i * kernel_size * kernel_size, 0, 0, kernel_size, kernel_size);
+    }
 
-    std::cout << "Output matrix:" << std::endl;
-    printMat(mem, MAT_COLS, OUT_ADDR, 0, 0, MIN(MAT_ROWS, 10), MIN(MAT_COLS, 20));
+    for (uint32_t i = 0; i < N_KERN; i++) {
+        std::cout << "Output matrix " << i << ":" << std::endl;
+        printMat(mem, MAT_COLS, FRAME_OUT_ADDR(CUR_FRAME) + i * MAT_SIZE, 0, 0, MIN(MAT_ROWS, 10), MIN(FRAME_COLS, 20));
+    }
     std::cout << std::endl << "==========" << std::endl;
 }
@@ -0,0 +1,107 @@
+#include "conv_engine.h"
+#include "system.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <iostream>
+#include <vector>
+
+// subject rows of the test, enough for every kernel row to be a padding row at some output row
+#define TEST_ROWS 11
+
+// subject widths, around the vector widths and the column tiles of the engines
+static const uint32_t test_cols[] = { 1, 2, 3, 7, 15, 16, 17, 31, 32, 33, 63, 64, 65, 255, 256, 257, 511, 512, 513, 1027, 1920 };
+
+static uint32_t n_failed = 0;
+
+#define CHECK(cond, msg) do { \
+        if (!(cond)) { \
+            std::cerr << "*** ERROR in test_conv: " << msg << std::endl; \
+            n_failed++; \
+        } \
+    } while (0)
+
+/** Reference output row, the low byte of the 32-bit sum of the products with zero padding. */
+static void ref_row(const uint8_t *const *in_rows, uint32_t cols, const uint8_t *kern, uint32_t kern_dim, uint8_t *out) {
+    int32_t hf_kern_dim = (int32_t)kern_dim >> 1;
+    for (int32_t c = 0; c < (int32_t)cols; c++) {
+        uint32_t sum = 0;
+        for (uint32_t kr = 0; kr < kern_dim; kr++) {
+            if (!in_rows[kr]) continue;
+            for (int32_t kc = 0; kc < (int32_t)kern_dim; kc++) {
+                int32_t j = c + kc - hf_kern_dim;
+                if (j < 0 || j >= (int32_t)cols) continue;
+                sum += (uint32_t)in_rows[kr][j] * (uint32_t)kern[kr * kern_dim + kc];
+            }
+        }
+        out[c] = (uint8_t)sum;
+    }
+}
+
+/** Convolve a random subject with a random filter bank on every engine the host supports, and compare them. */
+static void check_bank(conv_isa_e max_isa, uint8_t kern_dim, uint32_t cols, uint32_t n_kern) {
+    int32_t hf_kern_dim = kern_dim >> 1;
+    std::vector<uint8_t> subj(TEST_ROWS * cols);
+    std::vector<uint8_t> kern(n_kern * kern_dim * kern_dim);
+    for (uint8_t &p : subj) p = (uint8_t)rand();
+    for (uint8_t &k : kern) k = (uint8_t)rand();
+
+    // saturated values, so the wrapping of the narrow accumulators is exercised
+    if (cols > 1) subj[cols / 2] = 0xFF;
+    kern[0] = 0xFF;
+
+    std::vector<uint8_t> ref(n_kern * cols);
+    std::vector<uint8_t> out(n_kern * cols);
+    for (int32_t r = 0; r < TEST_ROWS; r++) {
+        const uint8_t *in_rows[MAX_KERN_DIM];
+        for (int32_t kr = 0; kr < kern_dim; kr++) {
+            int32_t sr = r + kr - hf_kern_dim;
+            in_rows[kr] = (sr >= 0 && sr < TEST_ROWS) ? subj.data() + sr * cols : nullptr;
+        }
+        for (uint32_t k = 0; k < n_kern; k++) {
+            ref_row(in_rows, cols, kern.data() + k * kern_dim * kern_dim, kern_dim, ref.data() + k * cols);
+        }
+
+        for (int isa = CONV_ISA_SCALAR; isa <= max_isa; isa++) {
+            memset(out.data(), 0, out.size());
+            conv_select_bank((conv_isa_e)isa, kern_dim)(in_rows, cols, kern.data(), n_kern, out.data(), cols);
+            CHECK(out == ref, conv_isa_name((conv_isa_e)isa) << " bank of " << n_kern << " " << (int)kern_dim << "x" << (int)kern_dim
+                << " kernels differs from the reference on row " << r << " of " << cols << " columns");
+
+            // the single kernel entry point
+            memset(out.data(), 0, cols);
+            conv_row((conv_isa_e)isa, in_rows, cols, kern.data(), kern_dim, out.data());
+            CHECK(memcmp(out.data(), ref.data(), cols) == 0, conv_isa_name((conv_isa_e)isa) << " " << (int)kern_dim << "x" << (int)kern_dim
+                << " row differs from the reference on row " << r << " of " << cols << " columns");
+        }
+    }
+}
+
+int main() {
+    srand(1);
+
+    // the engines above the detected one would fault, AVX-512 hosts also run AVX2
+    conv_isa_e max_isa = conv_detect_isa();
+    std::cout << "Checking the scalar engine";
+    for (int isa = CONV_ISA_SCALAR + 1; isa <= max_isa; isa++) {
+        std::cout << ", " << conv_isa_name((conv_isa_e)isa);
+    }
+    std::cout << " against the reference" << std::endl;
+
+    for (uint8_t kern_dim = 1; kern_dim <= MAX_KERN_DIM; kern_dim += 2) {
+        for (uint32_t cols : test_cols) {
+            check_bank(max_isa, kern_dim, cols, 1);
+        }
+        check_bank(max_isa, kern_dim, 1920, MAX_KERN_BANK);
+        check_bank(max_isa, kern_dim, 513, 3);
+    }
+    CHECK(!conv_select(CONV_ISA_SCALAR, 4) && !conv_select_bank(CONV_ISA_SCALAR, MAX_KERN_DIM + 2), "an illegal kernel dimension has an engine");
+    CHECK(!conv_row(CONV_ISA_SCALAR, nullptr, 1, nullptr, 0, nullptr) && !conv_dot_legal(0), "a kernel dimension of 0 is legal");
+
+    if (n_failed) {
+        std::cerr << "*** ERROR in test_conv: " << n_failed << " checks failed" << std::endl;
+        return 1;
+    }
+    std::cout << "test_conv passed" << std::endl;
+    return 0;
+}
@@ -0,0 +1,65 @@
+#include "sc_trace.hpp"
+
+#include "systemc.h"
+#include <iostream>
+
+static uint32_t n_failed = 0;
+
+#define CHECK(cond, msg) do { \
+        if (!(cond)) { \
+            std::cerr << "*** ERROR in test_hist: " << msg << std::endl; \
+            n_failed++; \
+        } \
+    } while (0)
+
+/** Highest value of the bucket of `value`, the buckets hold LATENCY_HIST_SUB_SIZE values per power of 2. */
+static uint64_t bucket_highest(uint64_t value) {
+    if (value < LATENCY_HIST_SUB_SIZE) return value;
+    uint32_t shift = 63 - __builtin_clzll(value) - LATENCY_HIST_SUB_BITS;
+    return ((value >> shift) << shift) + ((1ull << shift) - 1);
+}
+
+/** The median of `value` and of the largest latency is the highest value of the bucket of `value`. */
+static void check_bucket(uint64_t value) {
+    latency_histogram h;
+    h.record(value);
+    h.record(UINT64_MAX);
+    CHECK(h.percentile(50.0) == bucket_highest(value), "p50 of " << value << " is " << h.percentile(50.0) << ", expected " << bucket_highest(value));
+    CHECK(h.percentile(100.0) == UINT64_MAX, "p100 of " << value << " is not the largest latency");
+    CHECK(h.min() == value && h.max() == UINT64_MAX && h.count() == 2, "min, max or count of " << value << " is wrong");
+}
+
+static void check_histogram() {
+    // exact buckets, then the first buckets of every power of 2, and the values around them
+    for (uint64_t v = 0; v <= 2 * LATENCY_HIST_SUB_SIZE; v++) {
+        check_bucket(v);
+    }
+    for (uint32_t b = LATENCY_HIST_SUB_BITS + 1; b < 64; b++) {
+        uint64_t p = 1ull << b;
+        uint64_t step = p >> LATENCY_HIST_SUB_BITS;
+        uint64_t values[] = { p - 1, p, p + 1, p + step - 1, p + step, 2 * p - step - 1, 2 * p - step };
+        for (uint64_t v : values) {
+            check_bucket(v);
+        }
+    }
+    check_bucket(UINT64_MAX - 1);
+
+    // a percentile never exceeds the largest latency, even within a wide bucket
+    latency_histogram h;
+    h.record(1000000);
+    CHECK(h.percentile(99.0) == 1000000, "p99 of a single latency is " << h.percentile(99.0));
+
+    latency_histogram empty;
+    CHECK(empty.percentile(50.0) == 0 && empty.min() == 0 && empty.max() == 0 && empty.mean() == 0.0, "empty histogram is not all zero");
+}
+
+int sc_main(int argc, char* argv[]) {
+    check_histogram();
+
+    if (n_failed) {
+        std::cerr << "*** ERROR in test_hist: " << n_failed << " checks failed" << std::endl;
+        return 1;
+    }
+    std::cout << "test_hist passed" << std::endl;
+    return 0;
+}
@@ -0,0 +1,97 @@
+#include "sc_log.h"
+
+#include "systemc.h"
+#include <stdio.h>
+#include <string.h>
+#include <iostream>
+#include <string>
+
+// log file of the test, removed when the test passes
+#define TEST_LOG_FILE "test_log.log"
+
+// records logged by the test, so the ring wraps around several times
+#define TEST_LOG_RECORDS (3 * LOG_RING_SIZE + 5)
+
+// prefix of the records of the test in the log
+#define TEST_LOG_PREFIX "[test] "
+
+static uint32_t n_failed = 0;
+
+#define CHECK(cond, msg) do { \
+        if (!(cond)) { \
+            std::cerr << "*** ERROR in test_log: " << msg << std::endl; \
+            n_failed++; \
+        } \
+    } while (0)
+
+/** Open the log after the writer thread wrote every record. */
+static FILE *open_log() {
+    sc_logger::flush();
+    FILE *f = fopen(TEST_LOG_FILE, "r");
+    CHECK(f, "cannot read " TEST_LOG_FILE);
+    return f;
+}
+
+/** Every record comes out once and in order after the ring wraps around. */
+static void check_log_ring() {
+    // a module below its level is filtered out before the ring
+    LOG_DEBUG("test", "filtered %u", 0u);
+    for (uint32_t i = 0; i < TEST_LOG_RECORDS; i++) {
+        LOG_INFO("test", "record %u of %s", i, "ring");
+    }
+
+    FILE *f = open_log();
+    if (!f) return;
+    char line[256];
+    uint32_t n = 0;
+    while (fgets(line, sizeof(line), f)) {
+        const char *rec = strstr(line, TEST_LOG_PREFIX);
+        unsigned int i;
+        char ring[8];
+        bool ok = rec && sscanf(rec, TEST_LOG_PREFIX "record %u of %7s", &i, ring) == 2 && i == n && strcmp(ring, "ring") == 0;
+        CHECK(ok, "line " << n << " of the log is " << line);
+        if (!ok) break;
+        n++;
+    }
+    fclose(f);
+    CHECK(n == TEST_LOG_RECORDS, n << " records of " << TEST_LOG_RECORDS << " written");
+}
+
+/** A preformatted message longer than a record is cut with a trailing mark, after the records of the ring. */
+static void check_log_str() {
+    std::string msg(2 * LOG_STR_SIZE, 'x');
+    sc_logger::log_str(LOG_LVL_INFO, "test", msg);
+    sc_logger::log_str(LOG_LVL_INFO, "test", msg.substr(0, LOG_STR_SIZE - 1));
+
+    FILE *f = open_log();
+    if (!f) return;
+    std::string expected[] = {
+        msg.substr(0, LOG_STR_SIZE - sizeof(LOG_STR_TRUNC)) + LOG_STR_TRUNC + "\n",
+        msg.substr(0, LOG_STR_SIZE - 1) + "\n",
+    };
+    char line[4 * LOG_STR_SIZE];
+    for (uint32_t i = 0; i < TEST_LOG_RECORDS && fgets(line, sizeof(line), f); i++) {
+    }
+    for (const std::string &e : expected) {
+        const char *rec = fgets(line, sizeof(line), f) ? strstr(line, TEST_LOG_PREFIX) : nullptr;
+        CHECK(rec && e == rec + strlen(TEST_LOG_PREFIX), "message of " << e.size() - 1 << " bytes is " << (rec ? rec : "missing"));
+    }
+    fclose(f);
+}
+
+int sc_main(int argc, char* argv[]) {
+    if (!sc_logger::configure("test:info,debug", TEST_LOG_FILE, false)) {
+        std::cerr << "*** ERROR in test_log: cannot open " TEST_LOG_FILE << std::endl;
+        return 1;
+    }
+    check_log_ring();
+    check_log_str();
+
+    if (n_failed) {
+        std::cerr << "*** ERROR in test_log: " << n_failed << " checks failed" << std::endl;
+        return 1;
+    }
+    remove(TEST_LOG_FILE);
+    std::cout << "test_log passed" << std::endl;
+    return 0;
+}